@@ -0,0 +1,145 @@
+#include "app_spin.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "app_time.h"
+#include "boot_timing.h"
+#include "deferred_log.h"
+#include "executor_profile.h"
+#include "executor_split.h"
+#include "static_allocator.h"
+
+// Fixed sleep used by SPIN_MODE_POLL.
+#define POLL_PERIOD_US (100 * 1000)
+// Longest time to block for in SPIN_MODE_EVENT if no timer is due sooner.
+#define EVENT_MAX_WAIT_MS (1000)
+
+static const char *TAG = "spin";
+
+// Time that the earliest timer became, or will become, due.
+static int64_t timer_due_us = 0;
+// Measurements since the last report.
+static int64_t report_start_us = 0;
+static uint32_t wakeups = 0;
+static uint32_t publishes = 0;
+static int64_t latency_sum_us = 0;
+static int64_t latency_max_us = 0;
+
+// Time until the earliest timer is due, in ns.  Negative if overdue.
+static int64_t time_until_next_timer_ns(const entity_registry_t *registry,
+                                        int64_t max_ns) {
+  int64_t min_ns = max_ns;
+  for (size_t i = 0; i < registry->timer_count; i++) {
+    int64_t until_ns;
+    if (rcl_timer_get_time_until_next_call(registry->timers[i].handle,
+                                           &until_ns) == RCL_RET_OK &&
+        until_ns < min_ns) {
+      min_ns = until_ns;
+    }
+  }
+  return min_ns;
+}
+
+static void report(void) {
+  int64_t now_us = app_time_us();
+  int64_t elapsed_us = now_us - report_start_us;
+  if (APP_SPIN_REPORT_PERIOD_S == 0 ||
+      elapsed_us < (int64_t)APP_SPIN_REPORT_PERIOD_S * 1000000) {
+    return;
+  }
+  // Runs on the executor task so use the deferred log.
+  DLOG_I(TAG,
+         "%s: %.1f wakeups/s, timer to publish latency avg %d us, max %d us, "
+         "%u publishes",
+         (APP_SPIN_MODE == SPIN_MODE_POLL) ? "poll" : "event",
+         wakeups * 1000000.0 / elapsed_us,
+         (int32_t)(publishes ? latency_sum_us / publishes : 0),
+         (int32_t)latency_max_us, publishes);
+  report_start_us = now_us;
+  wakeups = 0;
+  publishes = 0;
+  latency_sum_us = 0;
+  latency_max_us = 0;
+}
+
+void app_spin_published(void) {
+  boot_timing_published();
+  if (timer_due_us == 0) {
+    // Not the first publish since the timer was due.
+    return;
+  }
+  int64_t latency_us = app_time_us() - timer_due_us;
+  timer_due_us = 0;
+  if (latency_us < 0) {
+    latency_us = 0;
+  }
+  latency_sum_us += latency_us;
+  if (latency_us > latency_max_us) {
+    latency_max_us = latency_us;
+  }
+  publishes++;
+}
+
+rcl_ret_t app_spin_once(rclc_executor_t *executor,
+                        const entity_registry_t *registry) {
+  if (report_start_us == 0) {
+    report_start_us = app_time_us();
+  }
+  int64_t wait_ns = time_until_next_timer_ns(
+      registry, RCL_MS_TO_NS((int64_t)EVENT_MAX_WAIT_MS));
+  timer_due_us = app_time_us() + wait_ns / 1000;
+  if (wait_ns < 0) {
+    // Timer is already overdue.
+    wait_ns = 0;
+  }
+#if APP_SPIN_MODE == SPIN_MODE_POLL
+  executor_profile_spin_t spin;
+  executor_split_lock();
+  executor_profile_spin_begin(&spin);
+  rcl_ret_t rc = rclc_executor_spin_some(executor, 100);
+  executor_profile_spin_end(&spin, EXECUTOR_PROFILE_MAIN);
+  executor_split_unlock();
+  static_allocator_seal();
+  wakeups++;
+  report();
+  int64_t idle_start_us = executor_profile_idle_begin();
+  usleep(POLL_PERIOD_US);
+  executor_profile_idle_end(EXECUTOR_PROFILE_MAIN, idle_start_us);
+#elif APP_EXECUTOR_SPLIT
+  // The command task is blocking on the transport, so wait for the timer
+  // without the session lock.
+  int64_t idle_start_us = executor_profile_idle_begin();
+  if (wait_ns > 0) {
+    usleep(wait_ns / 1000);
+  }
+  executor_split_lock();
+  executor_profile_idle_end(EXECUTOR_PROFILE_MAIN, idle_start_us);
+  executor_profile_spin_t spin;
+  executor_profile_spin_begin(&spin);
+  rcl_ret_t rc = rclc_executor_spin_some(executor, 0);
+  executor_profile_spin_end(&spin, EXECUTOR_PROFILE_MAIN);
+  executor_split_unlock();
+  static_allocator_seal();
+  wakeups++;
+  report();
+#else
+  // Blocks on the transport until data arrives or the next timer is due, so
+  // the idle time is in the spin time.
+  executor_profile_spin_t spin;
+  executor_profile_spin_begin(&spin);
+  rcl_ret_t rc = rclc_executor_spin_some(executor, wait_ns);
+  executor_profile_spin_end(&spin, EXECUTOR_PROFILE_MAIN);
+  // The first spin creates the executor's wait set, which ends startup.
+  static_allocator_seal();
+  wakeups++;
+  report();
+#endif
+  return rc;
+}
+
+void app_spin(rclc_executor_t *executor, const entity_registry_t *registry) {
+  while (1) {
+    app_spin_once(executor, registry);
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef APP_SPIN_H
+#define APP_SPIN_H
+
+/* Spin loop shared by all the apps.
+ *
+ * SPIN_MODE_POLL: The original loop.  rclc_executor_spin_some() with no wait,
+ * then sleep for a fixed 100 ms.  Data and timers can wait up to 100 ms before
+ * they are serviced and the task wakes up 10 times a second regardless.
+ * SPIN_MODE_EVENT: Block in rclc_executor_spin_some() on the transport until
+ * data arrives or the next timer is due.  No fixed sleep.
+ *
+ * Set APP_SPIN_MODE in app_config.h.  Both modes log a report every
+ * APP_SPIN_REPORT_PERIOD_S seconds with the wakeups per second and the
+ * latency from timer expiry to publish.
+ *
+ * With APP_EXECUTOR_SPLIT, the executor passed in only has the timers.  It is
+ * spun with the session lock held and the wait for the next timer is done
+ * without it.  See common/executor_split.h.
+ *
+ * After the first spin, static_allocator_seal() is called to mark the end of
+ * startup.
+ */
+
+#include <rclc/executor.h>
+
+#include "app_config.h"
+#include "entity_registry.h"
+
+#define SPIN_MODE_POLL (0)
+#define SPIN_MODE_EVENT (1)
+#ifndef APP_SPIN_MODE
+#define APP_SPIN_MODE SPIN_MODE_EVENT
+#endif
+
+// Period between spin reports.  0 disables the report.
+#ifndef APP_SPIN_REPORT_PERIOD_S
+#define APP_SPIN_REPORT_PERIOD_S (10)
+#endif
+
+/* Spin the executor forever.  The registry's timers are used to work out how
+ * long to block for.
+ */
+void app_spin(rclc_executor_t *executor, const entity_registry_t *registry);
+
+/* One pass of the app_spin() loop.  For callers that have other things to do
+ * between spins, e.g. common/connection_manager.c.  Returns the result of
+ * rclc_executor_spin_some().
+ */
+rcl_ret_t app_spin_once(rclc_executor_t *executor,
+                        const entity_registry_t *registry);
+
+/* Call from a timer callback just after publishing.  Records the latency from
+ * the timer becoming due to the publish, and the first publish after
+ * connecting for boot_timing.h.
+ */
+void app_spin_published(void);
+
+#endif  // APP_SPIN_H
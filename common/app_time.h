@@ -0,0 +1,45 @@
+#ifndef APP_TIME_H
+#define APP_TIME_H
+
+/* Monotonic time for measurements.  Not related to ROS time. */
+
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "xtensa/hal.h"
+#else
+#include <time.h>
+#endif
+
+// Microseconds since boot (ESP32) or since an arbitrary point (Linux).
+static inline int64_t app_time_us(void) {
+#ifdef ESP_PLATFORM
+  return esp_timer_get_time();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* Counter for timing short pieces of code.  CPU cycles on the ESP32, which
+ * wraps every few tens of seconds, and nanoseconds on Linux.  Only take the
+ * difference of two readings.  APP_CYCLES_UNIT names the unit for reports.
+ */
+#ifdef ESP_PLATFORM
+#define APP_CYCLES_UNIT "cycles"
+#else
+#define APP_CYCLES_UNIT "ns"
+#endif
+static inline uint32_t app_cycles(void) {
+#ifdef ESP_PLATFORM
+  return xthal_get_ccount();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+#endif
+}
+
+#endif  // APP_TIME_H
@@ -0,0 +1,115 @@
+#include "async_client.h"
+
+#include <string.h>
+
+#include "app_time.h"
+#include "deferred_log.h"
+
+static const char *TAG = "async_client";
+
+void async_client_init(async_client_t *client, rcl_client_t *handle,
+                       const char *name, uint32_t timeout_ms) {
+  memset(client, 0, sizeof(*client));
+  client->handle = handle;
+  client->name = name;
+  client->timeout_ms = timeout_ms;
+}
+
+rcl_ret_t async_client_send(async_client_t *client, const void *request,
+                            async_client_done_t done, void *context) {
+  async_request_t *slot = NULL;
+  for (size_t i = 0; i < ASYNC_CLIENT_MAX_IN_FLIGHT; i++) {
+    if (!client->requests[i].in_use) {
+      slot = &client->requests[i];
+      break;
+    }
+  }
+  if (slot == NULL) {
+    client->stats.rejected++;
+    return RCL_RET_ERROR;
+  }
+  int64_t sequence;
+  rcl_ret_t rc = rcl_send_request(client->handle, request, &sequence);
+  if (rc != RCL_RET_OK) {
+    client->stats.rejected++;
+    return rc;
+  }
+  slot->in_use = true;
+  slot->sequence = sequence;
+  slot->sent_us = app_time_us();
+  slot->deadline_us = slot->sent_us + (int64_t)client->timeout_ms * 1000;
+  slot->done = done;
+  slot->context = context;
+  client->stats.sent++;
+  return RCL_RET_OK;
+}
+
+// Free the slot before calling back, so the callback can send again.
+static void complete(async_client_t *client, async_request_t *slot,
+                     const void *response, async_client_status_t status) {
+  async_client_done_t done = slot->done;
+  void *context = slot->context;
+  slot->in_use = false;
+  if (done != NULL) {
+    done(client, response, status, context);
+  }
+}
+
+void async_client_handle_response(async_client_t *client, const void *response,
+                                  const rmw_request_id_t *header) {
+  for (size_t i = 0; i < ASYNC_CLIENT_MAX_IN_FLIGHT; i++) {
+    async_request_t *slot = &client->requests[i];
+    if (slot->in_use && slot->sequence == header->sequence_number) {
+      int64_t round_trip_us = app_time_us() - slot->sent_us;
+      client->stats.completed++;
+      client->stats.round_trip_sum_us += round_trip_us;
+      if (round_trip_us > client->stats.round_trip_max_us) {
+        client->stats.round_trip_max_us = round_trip_us;
+      }
+      complete(client, slot, response, ASYNC_CLIENT_OK);
+      return;
+    }
+  }
+  client->stats.unmatched++;
+  DLOG_D(TAG, "%s: no request for response %d", client->name,
+         (int32_t)header->sequence_number);
+}
+
+void async_client_check_timeouts(async_client_t *client) {
+  int64_t now_us = app_time_us();
+  for (size_t i = 0; i < ASYNC_CLIENT_MAX_IN_FLIGHT; i++) {
+    async_request_t *slot = &client->requests[i];
+    if (slot->in_use && now_us >= slot->deadline_us) {
+      client->stats.timed_out++;
+      DLOG_D(TAG, "%s: request %d timed out", client->name,
+             (int32_t)slot->sequence);
+      complete(client, slot, NULL, ASYNC_CLIENT_TIMEOUT);
+    }
+  }
+}
+
+void async_client_cancel_all(async_client_t *client) {
+  for (size_t i = 0; i < ASYNC_CLIENT_MAX_IN_FLIGHT; i++) {
+    async_request_t *slot = &client->requests[i];
+    if (slot->in_use) {
+      client->stats.timed_out++;
+      complete(client, slot, NULL, ASYNC_CLIENT_TIMEOUT);
+    }
+  }
+}
+
+size_t async_client_in_flight(const async_client_t *client) {
+  size_t count = 0;
+  for (size_t i = 0; i < ASYNC_CLIENT_MAX_IN_FLIGHT; i++) {
+    if (client->requests[i].in_use) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void async_client_take_stats(async_client_t *client,
+                             async_client_stats_t *stats) {
+  *stats = client->stats;
+  memset(&client->stats, 0, sizeof(client->stats));
+}
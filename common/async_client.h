@@ -0,0 +1,100 @@
+#ifndef ASYNC_CLIENT_H
+#define ASYNC_CLIENT_H
+
+/* Pipelined requests on an rcl service client.
+ *
+ * rcl_send_request() doesn't wait for the response, so several requests can
+ * be in flight on one client at once.  Each one takes a slot that holds its
+ * sequence number, deadline and completion callback.  The client's executor
+ * callback (added with its request id by entity_registry_add_to_executor())
+ * passes each response to async_client_handle_response(), which finds the slot
+ * by sequence number and calls the completion callback.  Call
+ * async_client_check_timeouts() regularly, e.g. from a timer, to complete the
+ * requests that have had no response by their deadline.
+ *
+ * All storage is in the async_client_t, so there is no allocation.  The
+ * request message is serialised by async_client_send(), so the same request
+ * buffer can be reused straight away.  Only use from the executor task.
+ */
+
+#include <rcl/rcl.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+// Requests that can be in flight on each client.
+#ifndef ASYNC_CLIENT_MAX_IN_FLIGHT
+#define ASYNC_CLIENT_MAX_IN_FLIGHT (4)
+#endif
+
+typedef enum {
+  ASYNC_CLIENT_OK,
+  ASYNC_CLIENT_TIMEOUT,
+} async_client_status_t;
+
+struct async_client;
+
+/* Called once per request.  `response` is only valid during the call and is
+ * NULL on timeout.
+ */
+typedef void (*async_client_done_t)(struct async_client *client,
+                                    const void *response,
+                                    async_client_status_t status,
+                                    void *context);
+
+typedef struct {
+  bool in_use;
+  int64_t sequence;
+  int64_t sent_us;
+  int64_t deadline_us;
+  async_client_done_t done;
+  void *context;
+} async_request_t;
+
+typedef struct {
+  uint32_t sent;
+  uint32_t completed;
+  uint32_t timed_out;
+  uint32_t rejected;   // No free slot, or rcl_send_request() failed.
+  uint32_t unmatched;  // Responses with no request, e.g. after a timeout.
+  int64_t round_trip_sum_us;
+  int64_t round_trip_max_us;
+} async_client_stats_t;
+
+typedef struct async_client {
+  rcl_client_t *handle;
+  const char *name;
+  uint32_t timeout_ms;
+  async_request_t requests[ASYNC_CLIENT_MAX_IN_FLIGHT];
+  async_client_stats_t stats;
+} async_client_t;
+
+void async_client_init(async_client_t *client, rcl_client_t *handle,
+                       const char *name, uint32_t timeout_ms);
+
+/* Send a request.  Returns RCL_RET_ERROR without sending if all the slots are
+ * in use.  `done` is called later with the response or a timeout.
+ */
+rcl_ret_t async_client_send(async_client_t *client, const void *request,
+                            async_client_done_t done, void *context);
+
+// Call from the client's executor callback.
+void async_client_handle_response(async_client_t *client, const void *response,
+                                  const rmw_request_id_t *header);
+
+// Complete the requests whose deadline has passed.
+void async_client_check_timeouts(async_client_t *client);
+
+/* Complete all the requests in flight as timed out, e.g. when the connection
+ * to the agent is lost and their responses will never come.
+ */
+void async_client_cancel_all(async_client_t *client);
+
+size_t async_client_in_flight(const async_client_t *client);
+
+// Copy and clear the statistics.
+void async_client_take_stats(async_client_t *client,
+                             async_client_stats_t *stats);
+
+#endif  // ASYNC_CLIENT_H
@@ -0,0 +1,26 @@
+#include "bench_report.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LINE_SIZE (512)
+
+void bench_report(const char *format, ...) {
+  char line[LINE_SIZE];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+  printf("BENCH %s\n", line);
+#ifndef ESP_PLATFORM
+  const char *path = getenv("BENCH_OUTPUT");
+  if (path != NULL && path[0] != '\0') {
+    FILE *file = fopen(path, "a");
+    if (file != NULL) {
+      fprintf(file, "%s\n", line);
+      fclose(file);
+    }
+  }
+#endif
+}
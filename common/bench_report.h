@@ -0,0 +1,18 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+/* Machine readable benchmark results.
+ *
+ * Each result is one line of JSON.  It is printed to the console with a
+ * "BENCH " prefix so it can be picked out of the log, e.g.
+ *   sed -n 's/^BENCH //p' console.log > results.jsonl
+ * On Linux the line is also appended, without the prefix, to the file named by
+ * the BENCH_OUTPUT environment variable, if set.
+ *
+ * Formats on the calling task, so don't use it on a hot path.
+ */
+
+void bench_report(const char *format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+#endif  // BENCH_REPORT_H
@@ -0,0 +1,93 @@
+#include "boot_timing.h"
+
+#include <stdbool.h>
+
+#include "app_config.h"
+#include "app_time.h"
+#include "bench_report.h"
+#include "entity_table.h"
+#include "esp_log.h"
+
+static const char *TAG = "boot";
+
+// When each step of the current connection happened.
+static int64_t step_us[BOOT_STEP_COUNT];
+static int64_t first_publish_us = 0;
+static int64_t power_on_us = -1;
+static int64_t destroy_us = 0;
+// 0 for the first connection after power on.
+static int32_t connection = -1;
+static bool reported = false;
+
+void boot_timing_mark(boot_step_t step) {
+  int64_t now_us = app_time_us();
+  if (step == BOOT_STEP_WAITING) {
+    if (power_on_us < 0) {
+#ifdef ESP_PLATFORM
+      power_on_us = 0;
+#else
+      power_on_us = now_us;
+#endif
+    }
+    connection++;
+    first_publish_us = 0;
+    reported = false;
+  }
+  step_us[step] = now_us;
+}
+
+void boot_timing_published(void) {
+  if (first_publish_us == 0) {
+    first_publish_us = app_time_us();
+  }
+}
+
+void boot_timing_destroyed(int64_t time_us) { destroy_us = time_us; }
+
+// Time from one step to another in ms.
+static int32_t step_ms(boot_step_t from, boot_step_t to) {
+  return (int32_t)((step_us[to] - step_us[from]) / 1000);
+}
+
+void boot_timing_report(size_t entity_count) {
+  if (reported || first_publish_us == 0) {
+    return;
+  }
+  reported = true;
+  int32_t power_on_ms =
+      connection == 0 ?
+          (int32_t)((step_us[BOOT_STEP_CONNECTED] - power_on_us) / 1000) :
+          -1;
+  int32_t destroy_ms = connection == 0 ? -1 : (int32_t)(destroy_us / 1000);
+  int32_t first_publish_ms =
+      (int32_t)((first_publish_us - step_us[BOOT_STEP_CONNECTED]) / 1000);
+  int32_t entities_ms = step_ms(BOOT_STEP_NODE, BOOT_STEP_ENTITIES);
+  ESP_LOGI(TAG,
+           "Connection %d: agent to connected %d ms (session %d, node %d, "
+           "%u entities %d, executor %d), connected to first publish %d ms",
+           (int)connection, (int)step_ms(BOOT_STEP_AGENT, BOOT_STEP_CONNECTED),
+           (int)step_ms(BOOT_STEP_AGENT, BOOT_STEP_SESSION),
+           (int)step_ms(BOOT_STEP_SESSION, BOOT_STEP_NODE),
+           (unsigned int)entity_count, (int)entities_ms,
+           (int)step_ms(BOOT_STEP_ENTITIES, BOOT_STEP_CONNECTED),
+           (int)first_publish_ms);
+  if (connection == 0) {
+    ESP_LOGI(TAG, "Power on to connected %d ms, to first publish %d ms",
+             (int)power_on_ms, (int)(power_on_ms + first_publish_ms));
+  } else {
+    ESP_LOGI(TAG, "Destroying the old entities took %d ms", (int)destroy_ms);
+  }
+  bench_report(
+      "{\"app\":\"boot\",\"fast_boot\":%d,\"connection\":%d,"
+      "\"power_on_to_connected_ms\":%d,\"agent_to_connected_ms\":%d,"
+      "\"session_ms\":%d,\"node_ms\":%d,\"entities\":%u,\"entities_ms\":%d,"
+      "\"executor_ms\":%d,\"connected_to_first_publish_ms\":%d,"
+      "\"destroy_ms\":%d}",
+      APP_FAST_BOOT, (int)connection, (int)power_on_ms,
+      (int)step_ms(BOOT_STEP_AGENT, BOOT_STEP_CONNECTED),
+      (int)step_ms(BOOT_STEP_AGENT, BOOT_STEP_SESSION),
+      (int)step_ms(BOOT_STEP_SESSION, BOOT_STEP_NODE),
+      (unsigned int)entity_count, (int)entities_ms,
+      (int)step_ms(BOOT_STEP_ENTITIES, BOOT_STEP_CONNECTED),
+      (int)first_publish_ms, (int)destroy_ms);
+}
@@ -0,0 +1,42 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+/* Time from power on, or from losing the agent, to the first publish.
+ *
+ * The connection manager marks each step of getting connected and
+ * app_spin_published() marks the first publish after that.  Once it has
+ * happened, boot_timing_report() logs, and writes as a bench_report() line:
+ *   - power on to connected, for the first connection only.  On the ESP32
+ *     power on is when the app core started, after the bootloader.  On Linux
+ *     it is when the connection manager started.
+ *   - agent found to connected, split into the session, the node, the
+ *     entities and the executor.  This is the part APP_FAST_BOOT speeds up.
+ *   - connected to the first publish.
+ *   - for a reconnect, how long destroying the old entities took.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  BOOT_STEP_WAITING,    // Started pinging the agent.
+  BOOT_STEP_AGENT,      // The agent answered.
+  BOOT_STEP_SESSION,    // rclc_support_init() done.
+  BOOT_STEP_NODE,       // The node is created.
+  BOOT_STEP_ENTITIES,   // The registry's entities are created.
+  BOOT_STEP_CONNECTED,  // The executor is created.
+  BOOT_STEP_COUNT,
+} boot_step_t;
+
+// Record the time of `step` in the current connection.
+void boot_timing_mark(boot_step_t step);
+// Cheap.  Only the first call per connection records anything.
+void boot_timing_published(void);
+// How long destroying the entities of the last connection took.
+void boot_timing_destroyed(int64_t destroy_us);
+/* Report the current connection, once, if it has published.  `entity_count`
+ * is the number of entities created, for the per entity time.
+ */
+void boot_timing_report(size_t entity_count);
+
+#endif  // BOOT_TIMING_H
@@ -0,0 +1,321 @@
+#include "connection_manager.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <rclc/executor.h>
+#include <rclc/rclc.h>
+#include <rmw_uros/options.h>
+#include <stdlib.h>
+
+#include "app_entities.h"
+#include "app_spin.h"
+#include "app_time.h"
+#include "boot_timing.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "executor_split.h"
+#include "static_allocator.h"
+#include "time_sync.h"
+
+static const char *TAG = "connection";
+
+typedef enum {
+  STATE_WAITING,
+  STATE_CONNECTED,
+} state_t;
+
+static state_t state = STATE_WAITING;
+static rclc_support_t support;
+static rcl_node_t node;
+static rclc_executor_t executor;
+#if APP_EXECUTOR_SPLIT
+_Static_assert(APP_SENSOR_HANDLE_COUNT > 0 && APP_COMMAND_HANDLE_COUNT > 0,
+               "APP_EXECUTOR_SPLIT needs timers and something to subscribe to");
+// Subscriptions, clients and services.  Spun by the executor_split task.
+static rclc_executor_t command_executor;
+#endif
+// When each of the registry's timers is next due while offline.
+static int64_t timer_due_us[APP_TIMER_COUNT > 0 ? APP_TIMER_COUNT : 1];
+
+bool connection_manager_connected(void) { return state == STATE_CONNECTED; }
+
+/* On Linux, HOST_NODE_NAMESPACE and HOST_CLIENT_KEY let several copies of an
+ * app share one agent, e.g. tools/swarm_load.py.  Otherwise there is no
+ * namespace and the RMW picks the client key.
+ */
+static const char *node_namespace(void) {
+#ifndef ESP_PLATFORM
+  const char *name = getenv("HOST_NODE_NAMESPACE");
+  if (name != NULL) {
+    return name;
+  }
+#endif
+  return "";
+}
+
+static uint32_t client_key(void) {
+#ifndef ESP_PLATFORM
+  const char *key = getenv("HOST_CLIENT_KEY");
+  if (key != NULL) {
+    return (uint32_t)strtoul(key, NULL, 0);
+  }
+#endif
+  return 0;
+}
+
+static rcl_ret_t init_support(const connection_manager_config_t *config) {
+  uint32_t key = client_key();
+  if (key == 0) {
+    return rclc_support_init(&support, 0, NULL, config->allocator);
+  }
+  // The support takes over the options and frees them in rclc_support_fini().
+  rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+  rcl_ret_t rc = rcl_init_options_init(&init_options, *config->allocator);
+  if (rc == RCL_RET_OK) {
+    rc = rmw_uros_options_set_client_key(
+        key, rcl_init_options_get_rmw_init_options(&init_options));
+  }
+  if (rc == RCL_RET_OK) {
+    rc = rclc_support_init_with_options(&support, 0, NULL, &init_options,
+                                        config->allocator);
+  }
+  return rc;
+}
+
+static bool ping_agent(void) {
+  executor_split_lock();
+  bool answered =
+      rmw_uros_ping_agent(CONNECTION_PING_TIMEOUT_MS, 1) == RMW_RET_OK;
+  executor_split_unlock();
+  return answered;
+}
+
+static void destroy_entities(const connection_manager_config_t *config,
+                             bool entities_created) {
+  // The session is probably gone, so failures here are expected.
+  if (entities_created) {
+    entity_registry_fini(config->registry, &node);
+  }
+  rcl_node_fini(&node);
+  rclc_executor_fini(&executor);
+#if APP_EXECUTOR_SPLIT
+  rclc_executor_fini(&command_executor);
+#endif
+  rclc_support_fini(&support);
+}
+
+static bool create_entities(const connection_manager_config_t *config) {
+  // Recreating the entities allocates again.
+  static_allocator_unseal();
+  if (init_support(config) != RCL_RET_OK) {
+    ESP_LOGE(TAG, "Failed to create the session");
+    return false;
+  }
+  boot_timing_mark(BOOT_STEP_SESSION);
+  node = rcl_get_zero_initialized_node();
+  executor = rclc_executor_get_zero_initialized_executor();
+#if APP_EXECUTOR_SPLIT
+  command_executor = rclc_executor_get_zero_initialized_executor();
+#endif
+  if (rclc_node_init_default(&node, config->node_name, node_namespace(),
+                             &support) != RCL_RET_OK) {
+    ESP_LOGE(TAG, "Failed to create the node");
+    destroy_entities(config, false);
+    return false;
+  }
+  boot_timing_mark(BOOT_STEP_NODE);
+  ESP_LOGI(TAG, "Creating entities");
+  if (entity_registry_init(config->registry, &node, &support) != RCL_RET_OK) {
+    destroy_entities(config, true);
+    return false;
+  }
+  boot_timing_mark(BOOT_STEP_ENTITIES);
+  ESP_LOGI(TAG, "Creating executor");
+#if APP_EXECUTOR_SPLIT
+  rcl_ret_t rc = rclc_executor_init(&executor, &support.context,
+                                    APP_SENSOR_HANDLE_COUNT, config->allocator);
+  if (rc == RCL_RET_OK) {
+    rc = rclc_executor_init(&command_executor, &support.context,
+                            APP_COMMAND_HANDLE_COUNT, config->allocator);
+  }
+  if (rc == RCL_RET_OK) {
+    rc = entity_registry_add_to_executors(config->registry, &executor,
+                                          &command_executor);
+  }
+#else
+  rcl_ret_t rc = rclc_executor_init(&executor, &support.context,
+                                    APP_EXECUTOR_HANDLE_COUNT,
+                                    config->allocator);
+  if (rc == RCL_RET_OK) {
+    rc = entity_registry_add_to_executor(config->registry, &executor);
+  }
+#endif
+  if (rc != RCL_RET_OK) {
+    ESP_LOGE(TAG, "Failed to create the executor");
+    destroy_entities(config, true);
+    return false;
+  }
+#if APP_FAST_BOOT
+  // Nothing waited for the agent to create the entities.  It handles the
+  // requests in order, so once it answers a ping it has done them all.
+  if (!ping_agent()) {
+    ESP_LOGE(TAG, "Agent lost while creating the entities");
+    destroy_entities(config, true);
+    return false;
+  }
+#endif
+  boot_timing_mark(BOOT_STEP_CONNECTED);
+  return true;
+}
+
+static size_t entity_count(const entity_registry_t *registry) {
+  return registry->publisher_count + registry->subscription_count +
+         registry->client_count + registry->service_count +
+         registry->timer_count;
+}
+
+/* Call the timer callbacks that are due, as the executor would, but with a
+ * NULL timer.  The handles aren't initialised while offline.
+ */
+static void run_offline_timers(const entity_registry_t *registry) {
+  int64_t now_us = app_time_us();
+  for (size_t i = 0; i < registry->timer_count; i++) {
+    const entity_timer_t *timer = &registry->timers[i];
+    if (timer_due_us[i] == 0) {
+      timer_due_us[i] = now_us + (int64_t)timer->period_ms * 1000;
+    } else if (now_us >= timer_due_us[i]) {
+      timer->callback(NULL, 0);
+      timer_due_us[i] += (int64_t)timer->period_ms * 1000;
+      if (timer_due_us[i] < now_us) {
+        // Fell behind.  Skip the missed calls.
+        timer_due_us[i] = now_us + (int64_t)timer->period_ms * 1000;
+      }
+    }
+  }
+}
+
+// Sleep until the next offline timer or ping is due.
+static void wait_offline(const entity_registry_t *registry,
+                         int64_t next_ping_us) {
+  int64_t wake_us = next_ping_us;
+  for (size_t i = 0; i < registry->timer_count; i++) {
+    if (timer_due_us[i] != 0 && timer_due_us[i] < wake_us) {
+      wake_us = timer_due_us[i];
+    }
+  }
+  int64_t wait_ms = (wake_us - app_time_us()) / 1000;
+  vTaskDelay(pdMS_TO_TICKS(wait_ms > 0 ? wait_ms : 1));
+}
+
+static void run_waiting(const connection_manager_config_t *config) {
+  ESP_LOGI(TAG, "Waiting for the agent");
+  boot_timing_mark(BOOT_STEP_WAITING);
+  int64_t next_ping_us = 0;
+  while (1) {
+    run_offline_timers(config->registry);
+    if (app_time_us() >= next_ping_us) {
+      if (ping_agent()) {
+        boot_timing_mark(BOOT_STEP_AGENT);
+        if (create_entities(config)) {
+          return;
+        }
+      }
+      next_ping_us = app_time_us() + CONNECTION_RETRY_PERIOD_MS * 1000LL;
+    }
+    wait_offline(config->registry, next_ping_us);
+  }
+}
+
+static void flush_stores(const connection_manager_config_t *config) {
+  executor_split_lock();
+  for (size_t i = 0; i < config->store_count; i++) {
+    store_forward_t *store = config->stores[i];
+    size_t backlog = store_forward_count(store);
+    if (backlog == 0) {
+      continue;
+    }
+    // One at a time so that commands can get in between.
+    size_t flushed = 0;
+    while (flushed < STORE_FORWARD_FLUSH_BATCH &&
+           store_forward_flush(store, 1) == 1) {
+      flushed++;
+      executor_split_yield();
+    }
+    DLOG_D(TAG, "%s: flushed %u of %u", store->name, (unsigned int)flushed,
+           (unsigned int)backlog);
+  }
+  executor_split_unlock();
+}
+
+static void report_stores(const connection_manager_config_t *config) {
+  for (size_t i = 0; i < config->store_count; i++) {
+    const store_forward_t *store = config->stores[i];
+    ESP_LOGI(TAG,
+             "%s: %u sent, %u stored, %u flushed, %u dropped, %u coalesced",
+             store->name, (unsigned int)store->stats.sent,
+             (unsigned int)store->stats.stored,
+             (unsigned int)store->stats.flushed,
+             (unsigned int)store->stats.dropped,
+             (unsigned int)store->stats.coalesced);
+  }
+}
+
+static void run_connected(const connection_manager_config_t *config) {
+  int64_t next_ping_us = app_time_us() + CONNECTION_PING_PERIOD_MS * 1000LL;
+  int64_t next_flush_us = 0;
+  int missed_pings = 0;
+  while (missed_pings < CONNECTION_MAX_MISSED_PINGS) {
+    app_spin_once(&executor, config->registry);
+    int64_t now_us = app_time_us();
+    if (now_us >= next_flush_us) {
+      flush_stores(config);
+      next_flush_us = now_us + CONNECTION_FLUSH_PERIOD_MS * 1000LL;
+    }
+    if (now_us >= next_ping_us) {
+      missed_pings = ping_agent() ? 0 : missed_pings + 1;
+      next_ping_us = now_us + CONNECTION_PING_PERIOD_MS * 1000LL;
+      time_sync_refresh(false);
+    }
+    boot_timing_report(entity_count(config->registry));
+  }
+}
+
+static void run(void *arg) {
+  const connection_manager_config_t *config =
+      (const connection_manager_config_t *)arg;
+  while (1) {
+    state = STATE_WAITING;
+    run_waiting(config);
+    state = STATE_CONNECTED;
+    ESP_LOGI(TAG, "Connected");
+    report_stores(config);
+    // Before the stores are flushed, so the samples taken offline get stamps.
+    time_sync_refresh(true);
+    if (config->on_connected != NULL) {
+      config->on_connected();
+    }
+#if APP_EXECUTOR_SPLIT
+    executor_split_start(&command_executor);
+#endif
+    run_connected(config);
+    ESP_LOGW(TAG, "Agent lost");
+    executor_split_stop();
+    state = STATE_WAITING;
+    if (config->on_disconnected != NULL) {
+      config->on_disconnected();
+    }
+    ESP_LOGI(TAG, "Destroying entities");
+    int64_t destroy_start_us = app_time_us();
+    destroy_entities(config, true);
+    boot_timing_destroyed(app_time_us() - destroy_start_us);
+    // Restart the offline timers from now.
+    for (size_t i = 0; i < config->registry->timer_count; i++) {
+      timer_due_us[i] = 0;
+    }
+  }
+}
+
+void connection_manager_run(const connection_manager_config_t *config) {
+  // On the pinned sensor task with APP_EXECUTOR_SPLIT, else on this one.
+  executor_split_run_sensor(run, (void *)config);
+}
@@ -0,0 +1,101 @@
+#ifndef CONNECTION_MANAGER_H
+#define CONNECTION_MANAGER_H
+
+/* Keeps an app running whether or not the agent can be reached.
+ *
+ * connection_manager_run() replaces the create entities / app_spin() /
+ * destroy sequence in appMain().  It is a state machine:
+ *
+ * WAITING: The agent is pinged every CONNECTION_RETRY_PERIOD_MS.  The
+ *   registry's timer callbacks are still called at their table periods so
+ *   that the app keeps producing data, which goes into its stores.
+ * CONNECTED: The support, node, entities and executor are created and
+ *   on_connected() is called.  app_spin_once() is called in a loop, the agent
+ *   is pinged every CONNECTION_PING_PERIOD_MS and the stores are flushed, at
+ *   most STORE_FORWARD_FLUSH_BATCH samples per store every
+ *   CONNECTION_FLUSH_PERIOD_MS.  The small batches stop a long outage turning
+ *   into a burst that fills the reliable streams on reconnect.
+ * The clock is synced with the agent on connection and then every
+ *   TIME_SYNC_PERIOD_S.  See common/time_sync.h.
+ * After CONNECTION_MAX_MISSED_PINGS missed pings in a row, on_disconnected()
+ *   is called, everything is destroyed and it goes back to WAITING.
+ *
+ * Each step of connecting and the first publish after it are timed and
+ * reported.  See common/boot_timing.h.  With APP_FAST_BOOT, set in
+ * app_config.h and app-colcon.meta, rmw_microxrcedds doesn't wait for the
+ * agent to confirm each entity.  The connection manager pings the agent once
+ * after creating them all instead.  An entity the agent fails to create then
+ * only shows up as a missing topic, so turn it off to find out which.
+ *
+ * With APP_EXECUTOR_SPLIT, the subscriptions, clients and services are on a
+ * second executor that is spun by its own task while connected.  See
+ * common/executor_split.h.
+ *
+ * While offline the timer callbacks are called with a NULL timer, as their
+ * timers aren't initialised.  A callback that produces data should still take
+ * its sample and publish it through a store_forward_t, passing
+ * connection_manager_connected() as `online`.  One that only publishes, or
+ * needs the agent, should return when the timer is NULL.
+ *
+ * On Linux the node namespace and XRCE client key can be set with the
+ * HOST_NODE_NAMESPACE and HOST_CLIENT_KEY environment variables, so that
+ * several copies of an app can share one agent.
+ *
+ * Wi-Fi still has to be up before appMain() is called.  That is done by the
+ * out of tree main.c.
+ */
+
+#include <rcl/rcl.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "app_config.h"
+#include "entity_registry.h"
+#include "store_forward.h"
+
+// Time between agent pings while waiting for the agent.
+#ifndef CONNECTION_RETRY_PERIOD_MS
+#define CONNECTION_RETRY_PERIOD_MS (1000)
+#endif
+// Time between agent pings while connected.
+#ifndef CONNECTION_PING_PERIOD_MS
+#define CONNECTION_PING_PERIOD_MS (1000)
+#endif
+// Time to wait for each ping response.
+#ifndef CONNECTION_PING_TIMEOUT_MS
+#define CONNECTION_PING_TIMEOUT_MS (100)
+#endif
+// Missed pings in a row before the connection is treated as lost.
+#ifndef CONNECTION_MAX_MISSED_PINGS
+#define CONNECTION_MAX_MISSED_PINGS (3)
+#endif
+// Time between flushes of the stores while connected.
+#ifndef CONNECTION_FLUSH_PERIOD_MS
+#define CONNECTION_FLUSH_PERIOD_MS (50)
+#endif
+// Most samples sent from each store per flush.
+#ifndef STORE_FORWARD_FLUSH_BATCH
+#define STORE_FORWARD_FLUSH_BATCH (8)
+#endif
+
+typedef struct {
+  const entity_registry_t *registry;
+  const char *node_name;
+  rcl_allocator_t *allocator;
+  // Called after the entities are created and before they are destroyed.
+  // Either can be NULL.
+  void (*on_connected)(void);
+  void (*on_disconnected)(void);
+  // Stores to flush while connected.
+  store_forward_t *const *stores;
+  size_t store_count;
+} connection_manager_config_t;
+
+/* Run the app.  Never returns.  With APP_EXECUTOR_SPLIT it runs on the pinned
+ * sensor task, and the calling task just waits.  See executor_split.h.
+ */
+void connection_manager_run(const connection_manager_config_t *config);
+// True while the entities exist and the agent is answering pings.
+bool connection_manager_connected(void);
+
+#endif  // CONNECTION_MANAGER_H
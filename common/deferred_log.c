@@ -0,0 +1,225 @@
+#include "deferred_log.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "app_time.h"
+
+_Static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0,
+               "DLOG_RING_SIZE must be a power of 2");
+
+// How often the print task checks the ring when it is empty.
+#define DRAIN_PERIOD_MS (10)
+#define TASK_STACK_SIZE (3072)
+#define TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+// Longest formatted line.  Longer lines are truncated.
+#define LINE_SIZE (160)
+
+typedef struct {
+  int64_t time_us;
+  const char *tag;
+  const char *format;
+  uint8_t level;
+  uint8_t arg_count;
+  dlog_arg_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+/* Bounded multi-producer, single-consumer ring.  Each slot has a sequence
+ * number that tells producers and the consumer who owns it, so no locks are
+ * needed and a full ring is detected without blocking.
+ */
+typedef struct {
+  atomic_uint sequence;
+  dlog_record_t record;
+} dlog_slot_t;
+
+static dlog_slot_t slots[DLOG_RING_SIZE];
+static atomic_uint enqueue_pos;
+static unsigned int dequeue_pos;  // Only used by the print task.
+static atomic_uint written;
+static atomic_uint dropped;
+
+static const char k_level_chars[] = {'N', 'E', 'W', 'I', 'D'};
+
+void dlog_write(uint8_t level, const char *tag, const char *format,
+                const dlog_arg_t *args, size_t arg_count) {
+  unsigned int pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+  dlog_slot_t *slot;
+  while (1) {
+    slot = &slots[pos & (DLOG_RING_SIZE - 1)];
+    unsigned int sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    int diff = (int)(sequence - pos);
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // Full.  Never wait on the hot path.
+      atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    }
+  }
+  dlog_record_t *record = &slot->record;
+  record->time_us = app_time_us();
+  record->tag = tag;
+  record->format = format;
+  record->level = level;
+  if (arg_count > DLOG_MAX_ARGS) {
+    arg_count = DLOG_MAX_ARGS;
+  }
+  record->arg_count = (uint8_t)arg_count;
+  memcpy(record->args, args, arg_count * sizeof(dlog_arg_t));
+  atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+  atomic_fetch_add_explicit(&written, 1, memory_order_relaxed);
+}
+
+static bool read_record(dlog_record_t *record) {
+  dlog_slot_t *slot = &slots[dequeue_pos & (DLOG_RING_SIZE - 1)];
+  unsigned int sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_acquire);
+  if ((int)(sequence - (dequeue_pos + 1)) < 0) {
+    return false;
+  }
+  *record = slot->record;
+  atomic_store_explicit(&slot->sequence, dequeue_pos + DLOG_RING_SIZE,
+                        memory_order_release);
+  dequeue_pos++;
+  return true;
+}
+
+/* Format one conversion.  The conversion character decides how the argument
+ * is passed to snprintf, so a mismatch between format and argument can't
+ * crash.  Length modifiers are dropped as all arguments are 32 bit.
+ */
+static int format_arg(char *out, size_t size, const char *spec,
+                      size_t spec_length, const dlog_arg_t *arg) {
+  char conversion[16];
+  size_t n = 0;
+  for (size_t i = 0; i < spec_length && n < sizeof(conversion) - 1; i++) {
+    if (strchr("hlLqjzt", spec[i]) == NULL) {
+      conversion[n++] = spec[i];
+    }
+  }
+  conversion[n] = '\0';
+  char type = spec[spec_length - 1];
+  if (strchr("diouxXc", type) != NULL) {
+    int32_t value = (arg->type == DLOG_ARG_FLOAT) ? (int32_t)arg->value.f
+                                                  : arg->value.i;
+    return snprintf(out, size, conversion, value);
+  }
+  if (strchr("fFeEgGaA", type) != NULL) {
+    double value;
+    switch (arg->type) {
+      case DLOG_ARG_FLOAT:
+        value = arg->value.f;
+        break;
+      case DLOG_ARG_UINT:
+        value = arg->value.u;
+        break;
+      default:
+        value = arg->value.i;
+        break;
+    }
+    return snprintf(out, size, conversion, value);
+  }
+  if (type == 's') {
+    const char *value =
+        (arg->type == DLOG_ARG_STR && arg->value.s) ? arg->value.s : "?";
+    return snprintf(out, size, conversion, value);
+  }
+  if (type == 'p') {
+    if (arg->type == DLOG_ARG_PTR) {
+      return snprintf(out, size, conversion, arg->value.p);
+    }
+    // An integer passed for a pointer.  Show it rather than lose it.
+    return snprintf(out, size, "0x%x", (unsigned int)arg->value.u);
+  }
+  return snprintf(out, size, "%%%c?", type);
+}
+
+static void format_record(const dlog_record_t *record, char *line,
+                          size_t size) {
+  size_t length = (size_t)snprintf(
+      line, size, "%c (%lld) %s: ", k_level_chars[record->level],
+      (long long)(record->time_us / 1000), record->tag);
+  size_t arg = 0;
+  for (const char *p = record->format; *p != '\0' && length < size - 1;) {
+    if (*p != '%') {
+      line[length++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      line[length++] = '%';
+      p += 2;
+      continue;
+    }
+    // Find the end of the conversion specification.
+    size_t spec_length = 1;
+    while (p[spec_length] != '\0' &&
+           strchr("diouxXcfFeEgGaAsp", p[spec_length]) == NULL) {
+      spec_length++;
+    }
+    if (p[spec_length] == '\0') {
+      break;
+    }
+    spec_length++;
+    if (arg < record->arg_count) {
+      int n = format_arg(&line[length], size - length, p, spec_length,
+                         &record->args[arg++]);
+      if (n > 0) {
+        length += (size_t)n;
+      }
+    }
+    p += spec_length;
+  }
+  if (length > size - 1) {
+    length = size - 1;
+  }
+  line[length] = '\0';
+}
+
+static void dlog_task(void *arg) {
+  dlog_record_t record;
+  char line[LINE_SIZE];
+  uint32_t reported_dropped = 0;
+  while (1) {
+    while (read_record(&record)) {
+      format_record(&record, line, sizeof(line));
+      printf("%s\n", line);
+    }
+    uint32_t now_dropped = dlog_dropped_count();
+    if (now_dropped != reported_dropped) {
+      printf("W dlog: %u records dropped (%u in total)\n",
+             (unsigned int)(now_dropped - reported_dropped),
+             (unsigned int)now_dropped);
+      reported_dropped = now_dropped;
+    }
+    vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+  }
+}
+
+void dlog_init(void) {
+  for (unsigned int i = 0; i < DLOG_RING_SIZE; i++) {
+    atomic_init(&slots[i].sequence, i);
+  }
+  atomic_init(&enqueue_pos, 0);
+  dequeue_pos = 0;
+  xTaskCreate(dlog_task, "dlog", TASK_STACK_SIZE, NULL, TASK_PRIORITY, NULL);
+}
+
+uint32_t dlog_written_count(void) {
+  return atomic_load_explicit(&written, memory_order_relaxed);
+}
+
+uint32_t dlog_dropped_count(void) {
+  return atomic_load_explicit(&dropped, memory_order_relaxed);
+}
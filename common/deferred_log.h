@@ -0,0 +1,148 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+/* Deferred binary logging for the publish and subscribe hot paths.
+ *
+ * DLOG_I(tag, format, ...) works like ESP_LOGI() but does no formatting on
+ * the calling task.  It writes a small binary record (time, level, tag, format
+ * pointer and up to DLOG_MAX_ARGS arguments) into a lock-free ring buffer.  A
+ * low priority task formats and prints the records later.  If the ring is
+ * full the record is dropped and counted, so a logging burst never blocks the
+ * executor.
+ *
+ * Restrictions:
+ *   - tag, format and any %s arguments are stored as pointers, so they must be
+ *     string literals or static strings.
+ *   - At most DLOG_MAX_ARGS arguments.  Integers are stored as 32 bits and
+ *     floating point values as float.
+ *   - %p arguments must be void pointers, as for printf().  Cast others.
+ *
+ * Levels below DLOG_LEVEL are removed at compile time.  Set DLOG_LEVEL in
+ * app_config.h.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#define DLOG_LEVEL_NONE (0)
+#define DLOG_LEVEL_ERROR (1)
+#define DLOG_LEVEL_WARN (2)
+#define DLOG_LEVEL_INFO (3)
+#define DLOG_LEVEL_DEBUG (4)
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#endif
+
+// Number of records in the ring.  Must be a power of 2.
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE (64)
+#endif
+
+#define DLOG_MAX_ARGS (6)
+
+typedef enum {
+  DLOG_ARG_INT,
+  DLOG_ARG_UINT,
+  DLOG_ARG_FLOAT,
+  DLOG_ARG_STR,
+  DLOG_ARG_PTR,
+} dlog_arg_type_t;
+
+typedef struct {
+  uint8_t type;  // dlog_arg_type_t
+  union {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char *s;
+    const void *p;
+  } value;
+} dlog_arg_t;
+
+/* Start the task that formats and prints the records.  Call once at start up
+ * before using DLOG_*().
+ */
+void dlog_init(void);
+
+// Records written to the ring and records dropped because it was full.
+uint32_t dlog_written_count(void);
+uint32_t dlog_dropped_count(void);
+
+// Used by the DLOG_*() macros.
+void dlog_write(uint8_t level, const char *tag, const char *format,
+                const dlog_arg_t *args, size_t arg_count);
+
+static inline dlog_arg_t dlog_arg_int(int32_t value) {
+  dlog_arg_t arg = {.type = DLOG_ARG_INT, .value.i = value};
+  return arg;
+}
+static inline dlog_arg_t dlog_arg_uint(uint32_t value) {
+  dlog_arg_t arg = {.type = DLOG_ARG_UINT, .value.u = value};
+  return arg;
+}
+static inline dlog_arg_t dlog_arg_float(double value) {
+  dlog_arg_t arg = {.type = DLOG_ARG_FLOAT, .value.f = (float)value};
+  return arg;
+}
+static inline dlog_arg_t dlog_arg_str(const char *value) {
+  dlog_arg_t arg = {.type = DLOG_ARG_STR, .value.s = value};
+  return arg;
+}
+static inline dlog_arg_t dlog_arg_ptr(const void *value) {
+  dlog_arg_t arg = {.type = DLOG_ARG_PTR, .value.p = value};
+  return arg;
+}
+
+#define DLOG_ARG(x)                      \
+  _Generic((x),                          \
+      float: dlog_arg_float,             \
+      double: dlog_arg_float,            \
+      char *: dlog_arg_str,              \
+      const char *: dlog_arg_str,        \
+      void *: dlog_arg_ptr,              \
+      const void *: dlog_arg_ptr,        \
+      unsigned int: dlog_arg_uint,       \
+      unsigned long: dlog_arg_uint,      \
+      unsigned long long: dlog_arg_uint, \
+      default: dlog_arg_int)(x)
+
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_MAP_0()
+#define DLOG_MAP_1(a) DLOG_ARG(a),
+#define DLOG_MAP_2(a, b) DLOG_ARG(a), DLOG_ARG(b),
+#define DLOG_MAP_3(a, b, c) DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c),
+#define DLOG_MAP_4(a, b, c, d) \
+  DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d),
+#define DLOG_MAP_5(a, b, c, d, e) \
+  DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e),
+#define DLOG_MAP_6(a, b, c, d, e, f)                                 \
+  DLOG_ARG(a), DLOG_ARG(b), DLOG_ARG(c), DLOG_ARG(d), DLOG_ARG(e), \
+      DLOG_ARG(f),
+
+// The first entry is a dummy so that no arguments is still a valid array.
+#define DLOG(level, tag, format, ...)                                     \
+  do {                                                                    \
+    if ((level) <= DLOG_LEVEL) {                                          \
+      const dlog_arg_t dlog_args_[] = {                                   \
+          {.type = DLOG_ARG_INT, .value.i = 0},                           \
+          DLOG_CAT(DLOG_MAP_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)};     \
+      dlog_write((level), (tag), (format), &dlog_args_[1],                \
+                 DLOG_NARGS(__VA_ARGS__));                                \
+    }                                                                     \
+  } while (0)
+
+#define DLOG_E(tag, format, ...) \
+  DLOG(DLOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOG_W(tag, format, ...) \
+  DLOG(DLOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define DLOG_I(tag, format, ...) \
+  DLOG(DLOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define DLOG_D(tag, format, ...) \
+  DLOG(DLOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+
+#endif  // DEFERRED_LOG_H
@@ -0,0 +1,180 @@
+#include "entity_registry.h"
+
+#include <stdio.h>
+
+static rcl_ret_t init_publisher(const entity_publisher_t *entity,
+                                rcl_node_t *node) {
+  *entity->handle = rcl_get_zero_initialized_publisher();
+  if (entity->qos == ENTITY_QOS_BEST_EFFORT) {
+    return rclc_publisher_init_best_effort(entity->handle, node,
+                                           entity->type_support(),
+                                           entity->topic);
+  }
+  return rclc_publisher_init_default(entity->handle, node,
+                                     entity->type_support(), entity->topic);
+}
+
+static rcl_ret_t init_subscription(const entity_subscription_t *entity,
+                                   rcl_node_t *node) {
+  *entity->handle = rcl_get_zero_initialized_subscription();
+  if (entity->qos == ENTITY_QOS_BEST_EFFORT) {
+    return rclc_subscription_init_best_effort(entity->handle, node,
+                                              entity->type_support(),
+                                              entity->topic);
+  }
+  return rclc_subscription_init_default(entity->handle, node,
+                                        entity->type_support(), entity->topic);
+}
+
+rcl_ret_t entity_registry_init(const entity_registry_t *registry,
+                               rcl_node_t *node, rclc_support_t *support) {
+  /* If an init fails, these are some of the return values.  Most are defined
+    in firmware/mcu_ws/install/include/rcl/types.h
+    1 = RCL_RET_ERROR = RMW_RET_ERROR - This is most common and usually means
+        that the RMW_UXRCE_MAX_* value in app-colcon.meta is too small.
+    10 = RCL_RET_BAD_ALLOC = RMW_RET_BAD_ALLOC
+    11 = RCL_RET_INVALID_ARGUMENT
+    103 = RCL_RET_TOPIC_NAME_INVALID
+    200 = RCL_RET_NODE_INVALID
+  */
+  rcl_ret_t rc = RCL_RET_OK;
+  for (size_t i = 0; i < registry->publisher_count; i++) {
+    const entity_publisher_t *entity = &registry->publishers[i];
+    rc = init_publisher(entity, node);
+    if (rc != RCL_RET_OK) {
+      printf("Failed to create publisher '%s': %d\n", entity->topic, (int)rc);
+      return rc;
+    }
+  }
+  for (size_t i = 0; i < registry->subscription_count; i++) {
+    const entity_subscription_t *entity = &registry->subscriptions[i];
+    rc = init_subscription(entity, node);
+    if (rc != RCL_RET_OK) {
+      printf("Failed to create subscriber '%s': %d\n", entity->topic,
+             (int)rc);
+      return rc;
+    }
+  }
+  for (size_t i = 0; i < registry->client_count; i++) {
+    const entity_client_t *entity = &registry->clients[i];
+    *entity->handle = rcl_get_zero_initialized_client();
+    rc = rclc_client_init_default(entity->handle, node, entity->type_support(),
+                                  entity->service);
+    if (rc != RCL_RET_OK) {
+      printf("Failed to create client '%s': %d\n", entity->service, (int)rc);
+      return rc;
+    }
+  }
+  for (size_t i = 0; i < registry->service_count; i++) {
+    const entity_service_t *entity = &registry->services[i];
+    *entity->handle = rcl_get_zero_initialized_service();
+    rc = rclc_service_init_default(entity->handle, node,
+                                   entity->type_support(), entity->service);
+    if (rc != RCL_RET_OK) {
+      printf("Failed to create service '%s': %d\n", entity->service, (int)rc);
+      return rc;
+    }
+  }
+  for (size_t i = 0; i < registry->timer_count; i++) {
+    const entity_timer_t *entity = &registry->timers[i];
+    *entity->handle = rcl_get_zero_initialized_timer();
+    rc = rclc_timer_init_default(entity->handle, support,
+                                 RCL_MS_TO_NS(entity->period_ms),
+                                 entity->callback);
+    if (rc != RCL_RET_OK) {
+      printf("Failed to create timer %u: %d\n", (unsigned int)i, (int)rc);
+      return rc;
+    }
+  }
+  return rc;
+}
+
+rcl_ret_t entity_registry_add_to_executor(const entity_registry_t *registry,
+                                          rclc_executor_t *executor) {
+  return entity_registry_add_to_executors(registry, executor, executor);
+}
+
+rcl_ret_t entity_registry_add_to_executors(const entity_registry_t *registry,
+                                           rclc_executor_t *timer_executor,
+                                           rclc_executor_t *command_executor) {
+  rcl_ret_t rc = RCL_RET_OK;
+  for (size_t i = 0; i < registry->timer_count && rc == RCL_RET_OK; i++) {
+    rc = rclc_executor_add_timer(timer_executor, registry->timers[i].handle);
+  }
+  for (size_t i = 0; i < registry->subscription_count && rc == RCL_RET_OK;
+       i++) {
+    const entity_subscription_t *entity = &registry->subscriptions[i];
+    rc = rclc_executor_add_subscription(command_executor, entity->handle,
+                                        entity->msg, entity->callback,
+                                        ON_NEW_DATA);
+  }
+  for (size_t i = 0; i < registry->client_count && rc == RCL_RET_OK; i++) {
+    const entity_client_t *entity = &registry->clients[i];
+    rc = rclc_executor_add_client_with_request_id(
+        command_executor, entity->handle, entity->response, entity->callback);
+  }
+  for (size_t i = 0; i < registry->service_count && rc == RCL_RET_OK; i++) {
+    const entity_service_t *entity = &registry->services[i];
+    rc = rclc_executor_add_service(command_executor, entity->handle,
+                                   entity->request, entity->response,
+                                   entity->callback);
+  }
+  return rc;
+}
+
+rcl_ret_t entity_registry_fini(const entity_registry_t *registry,
+                               rcl_node_t *node) {
+  rcl_ret_t result = RCL_RET_OK;
+  rcl_ret_t rc;
+  for (size_t i = registry->timer_count; i-- > 0;) {
+    rc = rcl_timer_fini(registry->timers[i].handle);
+    result = (result == RCL_RET_OK) ? rc : result;
+  }
+  for (size_t i = registry->service_count; i-- > 0;) {
+    rc = rcl_service_fini(registry->services[i].handle, node);
+    result = (result == RCL_RET_OK) ? rc : result;
+  }
+  for (size_t i = registry->client_count; i-- > 0;) {
+    rc = rcl_client_fini(registry->clients[i].handle, node);
+    result = (result == RCL_RET_OK) ? rc : result;
+  }
+  for (size_t i = registry->subscription_count; i-- > 0;) {
+    rc = rcl_subscription_fini(registry->subscriptions[i].handle, node);
+    result = (result == RCL_RET_OK) ? rc : result;
+  }
+  for (size_t i = registry->publisher_count; i-- > 0;) {
+    rc = rcl_publisher_fini(registry->publishers[i].handle, node);
+    result = (result == RCL_RET_OK) ? rc : result;
+  }
+  return result;
+}
+
+int entity_registry_find_subscription(const entity_registry_t *registry,
+                                      const void *msg) {
+  for (size_t i = 0; i < registry->subscription_count; i++) {
+    if (registry->subscriptions[i].msg == msg) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+int entity_registry_find_client(const entity_registry_t *registry,
+                                const void *response) {
+  for (size_t i = 0; i < registry->client_count; i++) {
+    if (registry->clients[i].response == response) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+int entity_registry_find_service(const entity_registry_t *registry,
+                                 const void *request) {
+  for (size_t i = 0; i < registry->service_count; i++) {
+    if (registry->services[i].request == request) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
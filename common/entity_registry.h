@@ -0,0 +1,328 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+/* Creation and teardown of the entities listed in an app's app_entities.h.
+ *
+ * Use ENTITY_REGISTRY_DEFINE(name) once, after the includes, to define the
+ * handles, the subscription/client/service message buffers and a constant
+ * entity_registry_t called `name` that describes them.  The handles are named
+ * publisher_<name>, subscriber_<name>, client_<name>, service_<name> and
+ * timer_<name>.  The callbacks named in the table are declared by the macro
+ * so they can be defined anywhere in the app.
+ *
+ * With APP_EXECUTOR_PROFILE the tables point at generated trampolines that
+ * time each callback into a per-entity slot, and the macro also defines
+ * executor_profile_timer_callback().  See executor_profile.h.  With
+ * APP_RESOURCE_DIAG it defines resource_diag_timer_callback(), see
+ * resource_diag.h.
+ */
+
+#include <rcl/rcl.h>
+#include <rclc/executor.h>
+#include <rclc/rclc.h>
+#include <rmw_microxrcedds_c/config.h>
+
+#include "app_config.h"
+#include "entity_table.h"
+#include "executor_profile.h"
+#include "resource_diag.h"
+
+typedef const rosidl_message_type_support_t *(*entity_msg_type_support_t)(
+    void);
+typedef const rosidl_service_type_support_t *(*entity_srv_type_support_t)(
+    void);
+
+typedef struct {
+  rcl_publisher_t *handle;
+  entity_msg_type_support_t type_support;
+  const char *topic;
+  int qos;
+} entity_publisher_t;
+
+typedef struct {
+  rcl_subscription_t *handle;
+  entity_msg_type_support_t type_support;
+  const char *topic;
+  int qos;
+  void *msg;
+  rclc_callback_t callback;
+} entity_subscription_t;
+
+typedef struct {
+  rcl_client_t *handle;
+  entity_srv_type_support_t type_support;
+  const char *service;
+  void *response;
+  rclc_client_callback_with_request_id_t callback;
+} entity_client_t;
+
+typedef struct {
+  rcl_service_t *handle;
+  entity_srv_type_support_t type_support;
+  const char *service;
+  void *request;
+  void *response;
+  rclc_service_callback_t callback;
+} entity_service_t;
+
+typedef struct {
+  rcl_timer_t *handle;
+  unsigned int period_ms;
+  rcl_timer_callback_t callback;
+} entity_timer_t;
+
+typedef struct entity_registry {
+  const entity_publisher_t *publishers;
+  size_t publisher_count;
+  const entity_subscription_t *subscriptions;
+  size_t subscription_count;
+  const entity_client_t *clients;
+  size_t client_count;
+  const entity_service_t *services;
+  size_t service_count;
+  const entity_timer_t *timers;
+  size_t timer_count;
+} entity_registry_t;
+
+/* Create all the entities in the registry.  Stops at the first failure and
+ * returns its error code after logging which entity failed.
+ */
+rcl_ret_t entity_registry_init(const entity_registry_t *registry,
+                               rcl_node_t *node, rclc_support_t *support);
+
+/* Add the timers, subscriptions, clients and services to the executor.  The
+ * executor must have been initialised with APP_EXECUTOR_HANDLE_COUNT handles.
+ * Clients are added with their request id, so the client callbacks get the
+ * sequence number of the request that each response answers.
+ */
+rcl_ret_t entity_registry_add_to_executor(const entity_registry_t *registry,
+                                          rclc_executor_t *executor);
+
+/* As entity_registry_add_to_executor() but the timers go on
+ * `timer_executor` and everything else on `command_executor`.  See
+ * common/executor_split.h for the handle counts.
+ */
+rcl_ret_t entity_registry_add_to_executors(const entity_registry_t *registry,
+                                           rclc_executor_t *timer_executor,
+                                           rclc_executor_t *command_executor);
+
+/* Destroy all the entities in the reverse order of creation.  Carries on after
+ * a failure and returns the first error code.
+ */
+rcl_ret_t entity_registry_fini(const entity_registry_t *registry,
+                               rcl_node_t *node);
+
+/* Find the subscription whose message buffer is `msg`.  Lets one callback be
+ * shared by several subscriptions.  Returns the index into
+ * registry->subscriptions or -1 if not found.
+ */
+int entity_registry_find_subscription(const entity_registry_t *registry,
+                                      const void *msg);
+
+/* Find the client whose response buffer is `response`.  Returns the index
+ * into registry->clients or -1 if not found.
+ */
+int entity_registry_find_client(const entity_registry_t *registry,
+                                const void *response);
+
+/* Find the service whose request buffer is `request`.  Returns the index into
+ * registry->services or -1 if not found.
+ */
+int entity_registry_find_service(const entity_registry_t *registry,
+                                 const void *request);
+
+// Internal helpers for ENTITY_REGISTRY_DEFINE.
+#define ENTITY_MSG_TYPE_SUPPORT(package, type) \
+  &ROSIDL_TYPESUPPORT_INTERFACE__SYMBOL_NAME(rosidl_typesupport_c, package, \
+                                             msg, type)
+#define ENTITY_SRV_TYPE_SUPPORT(package, type) \
+  &ROSIDL_TYPESUPPORT_INTERFACE__SYMBOL_NAME(rosidl_typesupport_c, package, \
+                                             srv, type)
+
+#define ENTITY_DECLARE_PUBLISHER(name, package, type, topic, qos) \
+  static rcl_publisher_t publisher_##name;
+#define ENTITY_DECLARE_SUBSCRIPTION(name, package, type, topic, qos, \
+                                    callback)                        \
+  static rcl_subscription_t subscriber_##name;                       \
+  static package##__msg__##type subscriber_msg_##name;               \
+  static void callback(const void *msg_in);
+#define ENTITY_DECLARE_CLIENT(name, package, type, service, callback) \
+  static rcl_client_t client_##name;                                  \
+  static package##__srv__##type##_Response client_response_##name;    \
+  static void callback(const void *msg_in, rmw_request_id_t *header);
+#define ENTITY_DECLARE_SERVICE(name, package, type, service, callback) \
+  static rcl_service_t service_##name;                                 \
+  static package##__srv__##type##_Request service_request_##name;      \
+  static package##__srv__##type##_Response service_response_##name;    \
+  static void callback(const void *request_in, void *response_out);
+#define ENTITY_DECLARE_TIMER(name, period_ms, callback) \
+  static rcl_timer_t timer_##name;                      \
+  static void callback(rcl_timer_t *timer, int64_t last_call_time);
+
+#if APP_EXECUTOR_PROFILE
+#define ENTITY_CALLBACK(kind, name, callback) entity_profiled_##kind##_##name
+#else
+#define ENTITY_CALLBACK(kind, name, callback) callback
+#endif
+
+#define ENTITY_PUBLISHER_ENTRY(name, package, type, topic, qos) \
+  {&publisher_##name, ENTITY_MSG_TYPE_SUPPORT(package, type), topic, qos},
+#define ENTITY_SUBSCRIPTION_ENTRY(name, package, type, topic, qos, callback) \
+  {&subscriber_##name, ENTITY_MSG_TYPE_SUPPORT(package, type), topic, qos,  \
+   &subscriber_msg_##name, ENTITY_CALLBACK(subscription, name, callback)},
+#define ENTITY_CLIENT_ENTRY(name, package, type, service, callback)          \
+  {&client_##name, ENTITY_SRV_TYPE_SUPPORT(package, type), service,         \
+   &client_response_##name, ENTITY_CALLBACK(client, name, callback)},
+#define ENTITY_SERVICE_ENTRY(name, package, type, service_name, callback) \
+  {&service_##name, ENTITY_SRV_TYPE_SUPPORT(package, type), service_name, \
+   &service_request_##name, &service_response_##name,                     \
+   ENTITY_CALLBACK(service, name, callback)},
+#define ENTITY_TIMER_ENTRY(name, period_ms, callback)                 \
+  {&timer_##name, period_ms, ENTITY_CALLBACK(timer, name, callback)},
+
+// Profiling slots and trampolines, in executor_profile_slot_t kind order.
+#define ENTITY_PROFILE_SLOT_ID(kind, name) ENTITY_PROFILE_SLOT_##kind##_##name,
+#define ENTITY_PROFILE_TIMER_ID(name, period_ms, callback) \
+  ENTITY_PROFILE_SLOT_ID(timer, name)
+#define ENTITY_PROFILE_SUBSCRIPTION_ID(name, package, type, topic, qos, \
+                                       callback)                        \
+  ENTITY_PROFILE_SLOT_ID(subscription, name)
+#define ENTITY_PROFILE_CLIENT_ID(name, package, type, service_name, \
+                                 callback)                          \
+  ENTITY_PROFILE_SLOT_ID(client, name)
+#define ENTITY_PROFILE_SERVICE_ID(name, package, type, service_name, \
+                                  callback)                          \
+  ENTITY_PROFILE_SLOT_ID(service, name)
+
+#define ENTITY_PROFILE_TIMER_SLOT(entity, period_ms, callback) \
+  {.kind = EXECUTOR_PROFILE_TIMER, .name = #entity},
+#define ENTITY_PROFILE_SUBSCRIPTION_SLOT(entity, package, type, topic, qos, \
+                                         callback)                          \
+  {.kind = EXECUTOR_PROFILE_SUBSCRIPTION, .name = #entity},
+#define ENTITY_PROFILE_CLIENT_SLOT(entity, package, type, service_name, \
+                                   callback)                            \
+  {.kind = EXECUTOR_PROFILE_CLIENT, .name = #entity},
+#define ENTITY_PROFILE_SERVICE_SLOT(entity, package, type, service_name, \
+                                    callback)                            \
+  {.kind = EXECUTOR_PROFILE_SERVICE, .name = #entity},
+
+#define ENTITY_PROFILE_TIMER_TRAMPOLINE(name, period_ms, callback)          \
+  static void entity_profiled_timer_##name(rcl_timer_t *timer,              \
+                                           int64_t last_call_time) {        \
+    int64_t start_us = executor_profile_begin();                            \
+    callback(timer, last_call_time);                                        \
+    executor_profile_end(                                                   \
+        &entity_profile_slots[ENTITY_PROFILE_SLOT_timer_##name], start_us); \
+  }
+#define ENTITY_PROFILE_SUBSCRIPTION_TRAMPOLINE(name, package, type, topic, \
+                                               qos, callback)              \
+  static void entity_profiled_subscription_##name(const void *msg_in) {    \
+    int64_t start_us = executor_profile_begin();                           \
+    callback(msg_in);                                                      \
+    executor_profile_end(                                                  \
+        &entity_profile_slots[ENTITY_PROFILE_SLOT_subscription_##name],    \
+        start_us);                                                         \
+  }
+#define ENTITY_PROFILE_CLIENT_TRAMPOLINE(name, package, type, service_name, \
+                                         callback)                          \
+  static void entity_profiled_client_##name(const void *msg_in,             \
+                                            rmw_request_id_t *header) {     \
+    int64_t start_us = executor_profile_begin();                            \
+    callback(msg_in, header);                                               \
+    executor_profile_end(                                                   \
+        &entity_profile_slots[ENTITY_PROFILE_SLOT_client_##name],           \
+        start_us);                                                          \
+  }
+#define ENTITY_PROFILE_SERVICE_TRAMPOLINE(name, package, type, service_name, \
+                                          callback)                          \
+  static void entity_profiled_service_##name(const void *request_in,         \
+                                             void *response_out) {           \
+    int64_t start_us = executor_profile_begin();                             \
+    callback(request_in, response_out);                                      \
+    executor_profile_end(                                                    \
+        &entity_profile_slots[ENTITY_PROFILE_SLOT_service_##name],           \
+        start_us);                                                           \
+  }
+
+#if APP_EXECUTOR_PROFILE
+#define ENTITY_PROFILE_DEFINE()                                         \
+  enum {                                                                \
+    APP_TIMERS(ENTITY_PROFILE_TIMER_ID)                                 \
+    APP_SUBSCRIPTIONS(ENTITY_PROFILE_SUBSCRIPTION_ID)                   \
+    APP_CLIENTS(ENTITY_PROFILE_CLIENT_ID)                               \
+    APP_SERVICES(ENTITY_PROFILE_SERVICE_ID)                             \
+    ENTITY_PROFILE_SLOT_COUNT                                           \
+  };                                                                    \
+  static executor_profile_slot_t                                        \
+      entity_profile_slots[ENTITY_PROFILE_SLOT_COUNT] = {               \
+          APP_TIMERS(ENTITY_PROFILE_TIMER_SLOT)                         \
+          APP_SUBSCRIPTIONS(ENTITY_PROFILE_SUBSCRIPTION_SLOT)           \
+          APP_CLIENTS(ENTITY_PROFILE_CLIENT_SLOT)                       \
+          APP_SERVICES(ENTITY_PROFILE_SERVICE_SLOT)};                   \
+  APP_TIMERS(ENTITY_PROFILE_TIMER_TRAMPOLINE)                           \
+  APP_SUBSCRIPTIONS(ENTITY_PROFILE_SUBSCRIPTION_TRAMPOLINE)             \
+  APP_CLIENTS(ENTITY_PROFILE_CLIENT_TRAMPOLINE)                         \
+  APP_SERVICES(ENTITY_PROFILE_SERVICE_TRAMPOLINE)                       \
+  static void executor_profile_timer_callback(rcl_timer_t *timer,       \
+                                              int64_t last_call_time) { \
+    (void)last_call_time;                                               \
+    if (timer != NULL) {                                                \
+      executor_profile_publish(&publisher_executor_profile,             \
+                               entity_profile_slots,                    \
+                               ENTITY_PROFILE_SLOT_COUNT);              \
+    }                                                                   \
+  }
+#else
+#define ENTITY_PROFILE_DEFINE()
+#endif
+
+#if APP_RESOURCE_DIAG
+#define ENTITY_DIAG_DEFINE()                                         \
+  static void resource_diag_timer_callback(rcl_timer_t *timer,       \
+                                           int64_t last_call_time) { \
+    (void)last_call_time;                                            \
+    if (timer != NULL) {                                             \
+      resource_diag_publish(&publisher_resource_diag);               \
+    }                                                                \
+  }
+#else
+#define ENTITY_DIAG_DEFINE()
+#endif
+
+/* The tables end with an unused zeroed entry so that an empty list is still a
+ * valid initialiser.  The counts come from the X-macro lists, not the tables.
+ */
+#define ENTITY_REGISTRY_DEFINE(registry)                                      \
+  _Static_assert(APP_PUBLISHER_COUNT <= RMW_UXRCE_MAX_PUBLISHERS,             \
+                 "Too many publishers, regenerate app-colcon.meta");          \
+  _Static_assert(APP_SUBSCRIPTION_COUNT <= RMW_UXRCE_MAX_SUBSCRIPTIONS,       \
+                 "Too many subscriptions, regenerate app-colcon.meta");       \
+  _Static_assert(APP_CLIENT_COUNT <= RMW_UXRCE_MAX_CLIENTS,                   \
+                 "Too many clients, regenerate app-colcon.meta");             \
+  _Static_assert(APP_SERVICE_COUNT <= RMW_UXRCE_MAX_SERVICES,                 \
+                 "Too many services, regenerate app-colcon.meta");            \
+  APP_PUBLISHERS(ENTITY_DECLARE_PUBLISHER)                                    \
+  APP_SUBSCRIPTIONS(ENTITY_DECLARE_SUBSCRIPTION)                              \
+  APP_CLIENTS(ENTITY_DECLARE_CLIENT)                                          \
+  APP_SERVICES(ENTITY_DECLARE_SERVICE)                                        \
+  APP_TIMERS(ENTITY_DECLARE_TIMER)                                            \
+  ENTITY_PROFILE_DEFINE()                                                     \
+  ENTITY_DIAG_DEFINE()                                                        \
+  static const entity_publisher_t registry##_publishers[] = {                 \
+      APP_PUBLISHERS(ENTITY_PUBLISHER_ENTRY){NULL}};                          \
+  static const entity_subscription_t registry##_subscriptions[] = {           \
+      APP_SUBSCRIPTIONS(ENTITY_SUBSCRIPTION_ENTRY){NULL}};                    \
+  static const entity_client_t registry##_clients[] = {                       \
+      APP_CLIENTS(ENTITY_CLIENT_ENTRY){NULL}};                                \
+  static const entity_service_t registry##_services[] = {                     \
+      APP_SERVICES(ENTITY_SERVICE_ENTRY){NULL}};                              \
+  static const entity_timer_t registry##_timers[] = {                         \
+      APP_TIMERS(ENTITY_TIMER_ENTRY){NULL}};                                  \
+  static const entity_registry_t registry = {                                 \
+      registry##_publishers,    APP_PUBLISHER_COUNT,                          \
+      registry##_subscriptions, APP_SUBSCRIPTION_COUNT,                       \
+      registry##_clients,       APP_CLIENT_COUNT,                             \
+      registry##_services,      APP_SERVICE_COUNT,                            \
+      registry##_timers,        APP_TIMER_COUNT};
+
+#endif  // ENTITY_REGISTRY_H
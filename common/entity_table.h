@@ -0,0 +1,122 @@
+#ifndef ENTITY_TABLE_H
+#define ENTITY_TABLE_H
+
+/* Helpers for the entity tables in each app's app_entities.h.
+ *
+ * Each app lists its entities once using these X-macro lists:
+ *   APP_PUBLISHERS(PUBLISHER)       PUBLISHER(name, package, type, topic, qos)
+ *   APP_SUBSCRIPTIONS(SUBSCRIPTION) SUBSCRIPTION(name, package, type, topic,
+ *                                                qos, callback)
+ *   APP_CLIENTS(CLIENT)             CLIENT(name, package, type, service,
+ *                                          callback)
+ *   APP_SERVICES(SERVICE)           SERVICE(name, package, type, service,
+ *                                           callback)
+ *   APP_TIMERS(TIMER)               TIMER(name, period_ms, callback)
+ *
+ * Everything else is derived from the lists: the handles and message buffers
+ * (entity_registry.h), the executor handle count and the RMW_UXRCE_MAX_*
+ * values in app-colcon.meta (tools/gen_colcon_meta.bash).
+ *
+ * NOTE: This file must only contain preprocessor definitions as it is also
+ * used by tools/gen_colcon_meta.c on the host, without any ROS headers.
+ */
+
+// Quality of service for publishers and subscriptions.
+#define ENTITY_QOS_RELIABLE (0)
+#define ENTITY_QOS_BEST_EFFORT (1)
+
+// Count the entries in an X-macro list.  The result can be used in #if.
+#define ENTITY_COUNT_ONE(...) +1
+#define ENTITY_COUNT(list) (0 list(ENTITY_COUNT_ONE))
+
+#define APP_PUBLISHER_COUNT ENTITY_COUNT(APP_PUBLISHERS)
+#define APP_SUBSCRIPTION_COUNT ENTITY_COUNT(APP_SUBSCRIPTIONS)
+#define APP_CLIENT_COUNT ENTITY_COUNT(APP_CLIENTS)
+#define APP_SERVICE_COUNT ENTITY_COUNT(APP_SERVICES)
+#define APP_TIMER_COUNT ENTITY_COUNT(APP_TIMERS)
+
+// Number of executor handles.  One for each timer, subscription, client and
+// service.  Publishers don't count as they are driven by the timers.
+#define APP_EXECUTOR_HANDLE_COUNT                                    \
+  (APP_SUBSCRIPTION_COUNT + APP_CLIENT_COUNT + APP_SERVICE_COUNT + \
+   APP_TIMER_COUNT)
+
+/* Executor profiling, see executor_profile.h.  Apps append these to their
+ * APP_PUBLISHERS and APP_TIMERS lists so that the profile publisher and timer
+ * are counted like any other entity.  They are empty unless
+ * APP_EXECUTOR_PROFILE is 1.  The message is too big for a best effort stream.
+ */
+#ifndef APP_EXECUTOR_PROFILE
+#define APP_EXECUTOR_PROFILE (0)
+#endif
+#ifndef EXECUTOR_PROFILE_PERIOD_MS
+#define EXECUTOR_PROFILE_PERIOD_MS (10000)
+#endif
+#if APP_EXECUTOR_PROFILE
+#define ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                     \
+  PUBLISHER(executor_profile, std_msgs, UInt32MultiArray,        \
+            "diagnostics/executor_profile", ENTITY_QOS_RELIABLE)
+#define ENTITY_PROFILE_TIMERS(TIMER)                  \
+  TIMER(executor_profile, EXECUTOR_PROFILE_PERIOD_MS, \
+        executor_profile_timer_callback)
+#else
+#define ENTITY_PROFILE_PUBLISHERS(PUBLISHER)
+#define ENTITY_PROFILE_TIMERS(TIMER)
+#endif
+
+/* Resource diagnostics, see resource_diag.h.  Appended to APP_PUBLISHERS and
+ * APP_TIMERS like the profile.  Empty unless APP_RESOURCE_DIAG is 1.
+ */
+#ifndef APP_RESOURCE_DIAG
+#define APP_RESOURCE_DIAG (0)
+#endif
+#ifndef RESOURCE_DIAG_PERIOD_MS
+#define RESOURCE_DIAG_PERIOD_MS (10000)
+#endif
+#if APP_RESOURCE_DIAG
+#define ENTITY_DIAG_PUBLISHERS(PUBLISHER)              \
+  PUBLISHER(resource_diag, std_msgs, UInt32MultiArray, \
+            "diagnostics/resources", ENTITY_QOS_RELIABLE)
+#define ENTITY_DIAG_TIMERS(TIMER) \
+  TIMER(resource_diag, RESOURCE_DIAG_PERIOD_MS, resource_diag_timer_callback)
+#else
+#define ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+#define ENTITY_DIAG_TIMERS(TIMER)
+#endif
+
+// Every app has exactly one node.
+#define APP_NODE_COUNT (1)
+
+// Depth of the RMW history for each subscription, client and service.
+// Override in app_config.h if an app needs to buffer more than one message.
+#ifndef APP_RMW_MAX_HISTORY
+#define APP_RMW_MAX_HISTORY (1)
+#endif
+
+/* Fast boot.  rmw_microxrcedds waits up to APP_ENTITY_CREATION_TIMEOUT_MS
+ * for the agent to confirm each entity it creates or destroys, so connecting
+ * takes a round trip per entity, and a reconnect waits the whole timeout for
+ * each entity of the lost session.  With APP_FAST_BOOT it doesn't wait.  The
+ * requests go out back to back on the reliable stream and the connection
+ * manager checks them all with one ping.  See connection_manager.h.
+ */
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT (0)
+#endif
+#if APP_FAST_BOOT
+#define APP_ENTITY_CREATION_TIMEOUT_MS (0)
+#else
+#define APP_ENTITY_CREATION_TIMEOUT_MS (1000)
+#endif
+
+// Transport MTU in bytes and number of MTU sized buffers in each reliable
+// stream.  A reliable message can be up to MTU * stream history bytes.  The
+// defaults are micro-ROS's own.  See tools/tuning_matrix.bash.
+#ifndef APP_TRANSPORT_MTU
+#define APP_TRANSPORT_MTU (512)
+#endif
+#ifndef APP_RMW_STREAM_HISTORY
+#define APP_RMW_STREAM_HISTORY (4)
+#endif
+
+#endif  // ENTITY_TABLE_H
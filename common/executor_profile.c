@@ -0,0 +1,158 @@
+#include "executor_profile.h"
+
+#include <string.h>
+
+#include "app_entities.h"
+#include "deferred_log.h"
+#include "u32_array.h"
+
+#if APP_EXECUTOR_PROFILE
+#define HEADER_SIZE (5)
+#define EXECUTOR_SIZE (4)
+#define SLOT_SIZE (5 + EXECUTOR_PROFILE_BUCKETS)
+// One slot for each executor handle.
+#define MESSAGE_SIZE                                               \
+  (HEADER_SIZE + EXECUTOR_PROFILE_EXECUTOR_COUNT * EXECUTOR_SIZE + \
+   APP_EXECUTOR_HANDLE_COUNT * SLOT_SIZE)
+
+typedef struct {
+  uint32_t spins;
+  uint64_t spin_us;
+  uint64_t callback_us;
+  uint64_t idle_us;
+} executor_stats_t;
+
+static const char *TAG = "profile";
+
+uint64_t executor_profile_callback_us = 0;
+static executor_stats_t executors[EXECUTOR_PROFILE_EXECUTOR_COUNT];
+static int64_t period_start_us = 0;
+static std_msgs__msg__UInt32MultiArray profile_msg;
+static uint32_t profile_data[MESSAGE_SIZE];
+
+static uint32_t bucket_for(uint32_t time_us) {
+  uint32_t bucket = 0;
+  uint32_t limit = EXECUTOR_PROFILE_FIRST_BUCKET_US;
+  while (bucket < EXECUTOR_PROFILE_BUCKETS - 1 && time_us >= limit) {
+    limit <<= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void executor_profile_end(executor_profile_slot_t *slot, int64_t start_us) {
+  uint32_t time_us = (uint32_t)(app_time_us() - start_us);
+  executor_profile_callback_us += time_us;
+  slot->calls++;
+  slot->total_us += time_us;
+  if (time_us > slot->max_us) {
+    slot->max_us = time_us;
+  }
+  slot->buckets[bucket_for(time_us)]++;
+}
+
+void executor_profile_spin_end(const executor_profile_spin_t *spin,
+                               executor_profile_executor_t executor) {
+  executor_stats_t *stats = &executors[executor];
+  stats->spins++;
+  stats->spin_us += app_time_us() - spin->start_us;
+  stats->callback_us += executor_profile_callback_us - spin->callback_us;
+}
+
+void executor_profile_idle_end(executor_profile_executor_t executor,
+                               int64_t start_us) {
+  executors[executor].idle_us += app_time_us() - start_us;
+}
+
+static void fill_message(executor_profile_slot_t *slots, size_t slot_count,
+                         uint32_t period_ms) {
+  uint32_t *data = profile_msg.data.data;
+  *data++ = EXECUTOR_PROFILE_VERSION;
+  *data++ = (uint32_t)slot_count;
+  *data++ = EXECUTOR_PROFILE_BUCKETS;
+  *data++ = EXECUTOR_PROFILE_FIRST_BUCKET_US;
+  *data++ = period_ms;
+  for (size_t i = 0; i < EXECUTOR_PROFILE_EXECUTOR_COUNT; i++) {
+    *data++ = executors[i].spins;
+    *data++ = (uint32_t)executors[i].spin_us;
+    *data++ = (uint32_t)executors[i].callback_us;
+    *data++ = (uint32_t)executors[i].idle_us;
+  }
+  // Index of each slot within its kind.
+  uint32_t kind_counts[EXECUTOR_PROFILE_SERVICE + 1] = {0};
+  for (size_t i = 0; i < slot_count; i++) {
+    const executor_profile_slot_t *slot = &slots[i];
+    *data++ = slot->kind;
+    *data++ = kind_counts[slot->kind]++;
+    *data++ = slot->calls;
+    *data++ = slot->total_us;
+    *data++ = slot->max_us;
+    memcpy(data, slot->buckets, sizeof(slot->buckets));
+    data += EXECUTOR_PROFILE_BUCKETS;
+  }
+}
+
+static void log_and_reset(executor_profile_slot_t *slots, size_t slot_count) {
+  static const char *const k_executor_names[] = {"main", "command"};
+  for (size_t i = 0; i < EXECUTOR_PROFILE_EXECUTOR_COUNT; i++) {
+    executor_stats_t *stats = &executors[i];
+    if (stats->spins > 0) {
+      DLOG_I(TAG, "%s executor: %u spins, %u ms waiting, %u ms in callbacks, "
+             "%u ms idle",
+             k_executor_names[i], stats->spins,
+             (uint32_t)((stats->spin_us - stats->callback_us) / 1000),
+             (uint32_t)(stats->callback_us / 1000),
+             (uint32_t)(stats->idle_us / 1000));
+    }
+    memset(stats, 0, sizeof(*stats));
+  }
+  for (size_t i = 0; i < slot_count; i++) {
+    executor_profile_slot_t *slot = &slots[i];
+    if (slot->calls > 0) {
+      DLOG_I(TAG, "%s: %u calls, avg %u us, max %u us", slot->name,
+             slot->calls, slot->total_us / slot->calls, slot->max_us);
+    }
+    slot->calls = 0;
+    slot->total_us = 0;
+    slot->max_us = 0;
+    memset(slot->buckets, 0, sizeof(slot->buckets));
+  }
+}
+
+void executor_profile_publish(const rcl_publisher_t *publisher,
+                              executor_profile_slot_t *slots,
+                              size_t slot_count) {
+  int64_t now_us = app_time_us();
+  if (period_start_us == 0) {
+    u32_array_init(&profile_msg, profile_data, MESSAGE_SIZE);
+    period_start_us = now_us;
+    return;
+  }
+  if (slot_count > APP_EXECUTOR_HANDLE_COUNT) {
+    slot_count = APP_EXECUTOR_HANDLE_COUNT;
+  }
+  fill_message(slots, slot_count,
+               (uint32_t)((now_us - period_start_us) / 1000));
+  (void)u32_array_publish(
+      &profile_msg, "executor_profile", publisher,
+      MESSAGE_SIZE - (APP_EXECUTOR_HANDLE_COUNT - slot_count) * SLOT_SIZE);
+  log_and_reset(slots, slot_count);
+  period_start_us = now_us;
+}
+
+#else
+
+void executor_profile_end(executor_profile_slot_t *slot, int64_t start_us) {
+  (void)slot;
+  (void)start_us;
+}
+
+void executor_profile_publish(const rcl_publisher_t *publisher,
+                              executor_profile_slot_t *slots,
+                              size_t slot_count) {
+  (void)publisher;
+  (void)slots;
+  (void)slot_count;
+}
+
+#endif  // APP_EXECUTOR_PROFILE
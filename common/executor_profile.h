@@ -0,0 +1,122 @@
+#ifndef EXECUTOR_PROFILE_H
+#define EXECUTOR_PROFILE_H
+
+/* Per-handle executor profiling.
+ *
+ * With APP_EXECUTOR_PROFILE set to 1 in app_config.h, ENTITY_REGISTRY_DEFINE()
+ * wraps every timer, subscription, client and service callback in the entity
+ * table with a trampoline that times it.  Each handle has a slot with its call
+ * count, total and maximum time and a histogram of EXECUTOR_PROFILE_BUCKETS
+ * power of 2 buckets: bucket 0 is under EXECUTOR_PROFILE_FIRST_BUCKET_US,
+ * bucket 1 under twice that and so on, and the last bucket takes the rest.
+ *
+ * The spin loops also record, per executor, the time spent in
+ * rclc_executor_spin_some() and the time spent sleeping outside it.  The time
+ * in spin_some minus the time in the callbacks is the time spent waiting on
+ * the transport and in rcl.
+ *
+ * The app also gets an `executor_profile` timer and publisher (see
+ * ENTITY_PROFILE_PUBLISHERS in entity_table.h).  Every
+ * EXECUTOR_PROFILE_PERIOD_MS the figures are published as a
+ * std_msgs/UInt32MultiArray on `diagnostics/executor_profile`, logged and
+ * reset.  tools/profile_dump.py
+ * decodes the message.  The layout, all uint32:
+ *   version, slot count, bucket count, first bucket us, period ms,
+ *   then for each executor (main, command): spins, spin us, callback us,
+ *   idle us,
+ *   then for each slot: kind, index, calls, total us, max us, buckets...
+ * Slots are in entity table order: timers, subscriptions, clients, services.
+ *
+ * Publishing uses a static buffer sized for APP_EXECUTOR_HANDLE_COUNT slots.
+ * The cost is two app_time_us() calls and a few adds per callback, so it can
+ * be left on.  The callbacks never run at the same time (see
+ * executor_split.h), so no locking is needed.
+ */
+
+#include <rcl/rcl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "app_time.h"
+#include "entity_table.h"
+#include "std_msgs/msg/u_int32_multi_array.h"
+
+#define EXECUTOR_PROFILE_BUCKETS (12)
+#define EXECUTOR_PROFILE_FIRST_BUCKET_US (8)
+#define EXECUTOR_PROFILE_VERSION (1)
+
+typedef enum {
+  EXECUTOR_PROFILE_TIMER,
+  EXECUTOR_PROFILE_SUBSCRIPTION,
+  EXECUTOR_PROFILE_CLIENT,
+  EXECUTOR_PROFILE_SERVICE,
+} executor_profile_kind_t;
+
+// The executors that are spun.  See executor_split.h.
+typedef enum {
+  EXECUTOR_PROFILE_MAIN,
+  EXECUTOR_PROFILE_COMMAND,
+  EXECUTOR_PROFILE_EXECUTOR_COUNT,
+} executor_profile_executor_t;
+
+typedef struct {
+  uint8_t kind;  // executor_profile_kind_t
+  const char *name;
+  uint32_t calls;
+  uint32_t total_us;
+  uint32_t max_us;
+  uint32_t buckets[EXECUTOR_PROFILE_BUCKETS];
+} executor_profile_slot_t;
+
+// Start of a spin_some() call.  See executor_profile_spin_end().
+typedef struct {
+  int64_t start_us;
+  uint64_t callback_us;
+} executor_profile_spin_t;
+
+// Time in the callbacks since start up.  Only used by the spin records.
+extern uint64_t executor_profile_callback_us;
+
+// Called by the trampolines.
+static inline int64_t executor_profile_begin(void) { return app_time_us(); }
+void executor_profile_end(executor_profile_slot_t *slot, int64_t start_us);
+
+#if APP_EXECUTOR_PROFILE
+static inline void executor_profile_spin_begin(executor_profile_spin_t *spin) {
+  spin->start_us = app_time_us();
+  spin->callback_us = executor_profile_callback_us;
+}
+void executor_profile_spin_end(const executor_profile_spin_t *spin,
+                               executor_profile_executor_t executor);
+// Time spent sleeping or blocked outside spin_some().
+static inline int64_t executor_profile_idle_begin(void) {
+  return app_time_us();
+}
+void executor_profile_idle_end(executor_profile_executor_t executor,
+                               int64_t start_us);
+#else
+static inline void executor_profile_spin_begin(executor_profile_spin_t *spin) {
+  (void)spin;
+}
+static inline void executor_profile_spin_end(
+    const executor_profile_spin_t *spin, executor_profile_executor_t executor) {
+  (void)spin;
+  (void)executor;
+}
+static inline int64_t executor_profile_idle_begin(void) { return 0; }
+static inline void executor_profile_idle_end(
+    executor_profile_executor_t executor, int64_t start_us) {
+  (void)executor;
+  (void)start_us;
+}
+#endif
+
+/* Publish, log and reset the figures.  Called by the executor_profile timer
+ * that ENTITY_REGISTRY_DEFINE() adds.
+ */
+void executor_profile_publish(const rcl_publisher_t *publisher,
+                              executor_profile_slot_t *slots,
+                              size_t slot_count);
+
+#endif  // EXECUTOR_PROFILE_H
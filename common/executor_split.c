@@ -0,0 +1,144 @@
+#include "executor_split.h"
+
+#if APP_EXECUTOR_SPLIT
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include "esp_log.h"
+#include "executor_profile.h"
+
+#define TASK_STACK_SIZE (4096)
+// Above the sensor task.
+#define TASK_PRIORITY (tskIDLE_PRIORITY + 6)
+// The app task's default priority.
+#define SENSOR_TASK_PRIORITY (tskIDLE_PRIORITY + 5)
+// How often the stopped task checks if it should start again.
+#define IDLE_PERIOD_MS (10)
+
+static const char *TAG = "executor_split";
+
+static SemaphoreHandle_t session_mutex = NULL;
+static rclc_executor_t *command_executor = NULL;
+static atomic_bool running;
+static atomic_bool stopped;
+// Set while each side is waiting for the lock.
+static atomic_bool command_waiting;
+static atomic_bool sensor_waiting;
+
+static void command_task(void *arg) {
+  while (1) {
+    if (!atomic_load(&running)) {
+      atomic_store(&stopped, true);
+      vTaskDelay(pdMS_TO_TICKS(IDLE_PERIOD_MS));
+      continue;
+    }
+    atomic_store(&command_waiting, true);
+    // Waiting for the lock, and below for the sensor side, counts as idle.
+    int64_t idle_start_us = executor_profile_idle_begin();
+    xSemaphoreTake(session_mutex, portMAX_DELAY);
+    executor_profile_idle_end(EXECUTOR_PROFILE_COMMAND, idle_start_us);
+    atomic_store(&command_waiting, false);
+    // Don't block on the transport if the sensor side wants the lock.
+    uint64_t wait_ns =
+        atomic_load(&sensor_waiting)
+            ? 0
+            : RCL_MS_TO_NS((uint64_t)EXECUTOR_SPLIT_COMMAND_WAIT_MS);
+    executor_profile_spin_t spin;
+    executor_profile_spin_begin(&spin);
+    rclc_executor_spin_some(command_executor, wait_ns);
+    executor_profile_spin_end(&spin, EXECUTOR_PROFILE_COMMAND);
+    xSemaphoreGive(session_mutex);
+    // The sensor side can have a lower priority on this core, so block rather
+    // than yield until it has the lock.
+    idle_start_us = executor_profile_idle_begin();
+    while (atomic_load(&sensor_waiting)) {
+      vTaskDelay(1);
+    }
+    executor_profile_idle_end(EXECUTOR_PROFILE_COMMAND, idle_start_us);
+  }
+}
+
+void executor_split_run_sensor(void (*function)(void *), void *arg) {
+  if (xTaskCreatePinnedToCore(function, "sensor",
+                              EXECUTOR_SPLIT_SENSOR_STACK_SIZE, arg,
+                              SENSOR_TASK_PRIORITY, NULL,
+                              EXECUTOR_SPLIT_SENSOR_CORE) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create the sensor task, running unpinned");
+    function(arg);
+    return;
+  }
+  ESP_LOGI(TAG, "Sensor executor on core %d", EXECUTOR_SPLIT_SENSOR_CORE);
+  while (1) {
+    vTaskDelay(pdMS_TO_TICKS(60 * 1000));
+  }
+}
+
+void executor_split_start(rclc_executor_t *executor) {
+  if (session_mutex == NULL) {
+    session_mutex = xSemaphoreCreateMutex();
+  }
+  command_executor = executor;
+  atomic_store(&stopped, false);
+  atomic_store(&running, true);
+  static bool task_created = false;
+  if (task_created) {
+    return;
+  }
+  if (xTaskCreatePinnedToCore(command_task, "command", TASK_STACK_SIZE, NULL,
+                              TASK_PRIORITY, NULL,
+                              EXECUTOR_SPLIT_COMMAND_CORE) != pdPASS) {
+    ESP_LOGE(TAG, "Failed to create the command task");
+    atomic_store(&running, false);
+    atomic_store(&stopped, true);
+    return;
+  }
+  task_created = true;
+  ESP_LOGI(TAG, "Command executor on core %d", EXECUTOR_SPLIT_COMMAND_CORE);
+}
+
+void executor_split_stop(void) {
+  atomic_store(&running, false);
+  while (!atomic_load(&stopped)) {
+    vTaskDelay(pdMS_TO_TICKS(IDLE_PERIOD_MS));
+  }
+}
+
+void executor_split_lock(void) {
+  if (session_mutex == NULL) {
+    session_mutex = xSemaphoreCreateMutex();
+  }
+  atomic_store(&sensor_waiting, true);
+  xSemaphoreTake(session_mutex, portMAX_DELAY);
+  atomic_store(&sensor_waiting, false);
+}
+
+void executor_split_unlock(void) { xSemaphoreGive(session_mutex); }
+
+void executor_split_yield(void) {
+  if (!atomic_load(&command_waiting)) {
+    return;
+  }
+  xSemaphoreGive(session_mutex);
+  // The command task has the higher priority, so it takes the lock as soon as
+  // it is given on this core.  On the other core, wait until it has.
+  while (atomic_load(&command_waiting)) {
+    taskYIELD();
+  }
+  executor_split_lock();
+}
+
+#else
+
+void executor_split_run_sensor(void (*function)(void *), void *arg) {
+  function(arg);
+}
+void executor_split_start(rclc_executor_t *executor) { (void)executor; }
+void executor_split_stop(void) {}
+void executor_split_lock(void) {}
+void executor_split_unlock(void) {}
+void executor_split_yield(void) {}
+
+#endif  // APP_EXECUTOR_SPLIT
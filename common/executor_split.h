@@ -0,0 +1,86 @@
+#ifndef EXECUTOR_SPLIT_H
+#define EXECUTOR_SPLIT_H
+
+/* Optional split of an app's handles over two executors.
+ *
+ * With APP_EXECUTOR_SPLIT set to 1 in app_config.h, common/connection_manager.c
+ * creates two executors:
+ *   - The sensor executor has the timers, so it does the publishing.  The
+ *     app task isn't pinned, so connection_manager_run() moves onto a
+ *     `sensor` task pinned to EXECUTOR_SPLIT_SENSOR_CORE, which runs the
+ *     connection manager and spins this executor.  The app task just waits.
+ *   - The command executor has the subscriptions, clients and services.  It is
+ *     spun by its own task, pinned to EXECUTOR_SPLIT_COMMAND_CORE at a higher
+ *     priority than the sensor task.
+ * On Linux the tasks are threads with their CPU affinity set.
+ *
+ * The XRCE-DDS session is not thread safe, so both sides take the session
+ * lock to use it.  The command task blocks on the transport, holding the lock,
+ * for at most EXECUTOR_SPLIT_COMMAND_WAIT_MS at a time.  The sensor side waits
+ * for its next timer without the lock and only takes it to run the due timers.
+ * A burst of publishes calls executor_split_yield() between messages, which
+ * hands the lock to the command task if it is waiting, so a cmd_vel message is
+ * not held up for the whole burst.
+ *
+ * The callbacks on both executors are run with the lock held, so two
+ * callbacks never run at once.  But a sensor callback that calls
+ * executor_split_yield() lets the command callbacks run in the middle of it.
+ * Data shared between the executors needs no extra locking only if it is
+ * consistent at every yield as well as between callbacks.
+ *
+ * With APP_EXECUTOR_SPLIT at 0 the lock and yield functions do nothing.
+ */
+
+#include <rclc/executor.h>
+
+#include "app_config.h"
+#include "entity_table.h"
+
+#ifndef APP_EXECUTOR_SPLIT
+#define APP_EXECUTOR_SPLIT (0)
+#endif
+
+// ESP32 core 0 also runs Wi-Fi and lwIP.
+#ifndef EXECUTOR_SPLIT_COMMAND_CORE
+#define EXECUTOR_SPLIT_COMMAND_CORE (1)
+#endif
+#ifndef EXECUTOR_SPLIT_SENSOR_CORE
+#define EXECUTOR_SPLIT_SENSOR_CORE (0)
+#endif
+// The sensor task does everything the app task did, so give it as much stack.
+#ifndef EXECUTOR_SPLIT_SENSOR_STACK_SIZE
+#define EXECUTOR_SPLIT_SENSOR_STACK_SIZE (16000)
+#endif
+// Longest time the command task blocks on the transport with the lock held.
+#ifndef EXECUTOR_SPLIT_COMMAND_WAIT_MS
+#define EXECUTOR_SPLIT_COMMAND_WAIT_MS (5)
+#endif
+
+// Executor handle counts.  The timers go on the sensor executor.
+#define APP_SENSOR_HANDLE_COUNT (APP_TIMER_COUNT)
+#define APP_COMMAND_HANDLE_COUNT \
+  (APP_SUBSCRIPTION_COUNT + APP_CLIENT_COUNT + APP_SERVICE_COUNT)
+
+/* Run `function(arg)` on the sensor task and block the calling task for good.
+ * If the task can't be created, runs it on the calling task instead.
+ */
+void executor_split_run_sensor(void (*function)(void *), void *arg);
+/* Start spinning `executor` on the command task.  Creates the task the first
+ * time.
+ */
+void executor_split_start(rclc_executor_t *executor);
+/* Stop the command task spinning.  Returns once it has stopped, after which
+ * the executor can be destroyed.
+ */
+void executor_split_stop(void);
+
+// Take and give the session lock.  For the sensor side, e.g. around a ping.
+void executor_split_lock(void);
+void executor_split_unlock(void);
+/* Call with the lock held, e.g. between the publishes of a burst.  Lets the
+ * command task run if it is waiting for the lock, so any command callback can
+ * run before this returns.  Leave the data they share consistent first.
+ */
+void executor_split_yield(void);
+
+#endif  // EXECUTOR_SPLIT_H
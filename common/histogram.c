@@ -0,0 +1,74 @@
+#include "histogram.h"
+
+#include <string.h>
+
+static unsigned int bucket_index(uint32_t value) {
+  if (value > HISTOGRAM_MAX_VALUE) {
+    value = HISTOGRAM_MAX_VALUE;
+  }
+  if (value < 2 * HISTOGRAM_SUB_BUCKETS) {
+    return value;
+  }
+  unsigned int top_bit = 31 - __builtin_clz(value);
+  unsigned int shift = top_bit - HISTOGRAM_SUB_BUCKET_BITS;
+  return (shift + 1) * HISTOGRAM_SUB_BUCKETS +
+         ((value >> shift) - HISTOGRAM_SUB_BUCKETS);
+}
+
+// Largest value that goes into bucket `index`.
+static uint32_t bucket_top(unsigned int index) {
+  if (index < 2 * HISTOGRAM_SUB_BUCKETS) {
+    return index;
+  }
+  unsigned int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+  uint32_t sub = index % HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKETS;
+  return ((sub + 1) << shift) - 1;
+}
+
+void histogram_reset(histogram_t *histogram) {
+  memset(histogram, 0, sizeof(*histogram));
+  histogram->min = UINT32_MAX;
+}
+
+void histogram_record(histogram_t *histogram, uint32_t value) {
+  histogram->counts[bucket_index(value)]++;
+  histogram->count++;
+  histogram->sum += value;
+  if (value < histogram->min) {
+    histogram->min = value;
+  }
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+}
+
+uint32_t histogram_percentile(const histogram_t *histogram, double percentile) {
+  if (histogram->count == 0) {
+    return 0;
+  }
+  // Rank of the wanted value, rounded up, in the range 1 to count.
+  double rank = percentile / 100.0 * histogram->count;
+  uint32_t target = (uint32_t)rank;
+  if (target < rank || target == 0) {
+    target++;
+  }
+  if (target > histogram->count) {
+    target = histogram->count;
+  }
+  uint32_t seen = 0;
+  for (unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen >= target) {
+      uint32_t top = bucket_top(i);
+      return (top < histogram->max) ? top : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+uint32_t histogram_mean(const histogram_t *histogram) {
+  if (histogram->count == 0) {
+    return 0;
+  }
+  return (uint32_t)(histogram->sum / histogram->count);
+}
@@ -0,0 +1,40 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+/* Fixed size log-linear histogram for latency measurements.
+ *
+ * Values below 32 are counted exactly.  Above that each power of two is split
+ * into 16 buckets, so a percentile is within about 6% of the real value.
+ * Values up to HISTOGRAM_MAX_VALUE (about 67 s in us) are stored, larger
+ * values go in the top bucket.  Recording is O(1) with no allocation, so it can
+ * be used in callbacks.  Not thread safe.
+ */
+
+#include <stdint.h>
+
+#define HISTOGRAM_SUB_BUCKET_BITS (4)
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_BIT (25)
+#define HISTOGRAM_MAX_VALUE ((UINT32_C(1) << (HISTOGRAM_MAX_BIT + 1)) - 1)
+#define HISTOGRAM_BUCKETS \
+  ((HISTOGRAM_MAX_BIT - HISTOGRAM_SUB_BUCKET_BITS + 2) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+  uint32_t counts[HISTOGRAM_BUCKETS];
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+} histogram_t;
+
+void histogram_reset(histogram_t *histogram);
+void histogram_record(histogram_t *histogram, uint32_t value);
+/* Value that `percentile` percent (0 to 100) of the recorded values are less
+ * than or equal to.  Returns the top of the bucket, capped at the maximum
+ * recorded value, so it never under-reports.  Returns 0 if empty.
+ */
+uint32_t histogram_percentile(const histogram_t *histogram, double percentile);
+// Mean of the recorded values.  Returns 0 if empty.
+uint32_t histogram_mean(const histogram_t *histogram);
+
+#endif  // HISTOGRAM_H
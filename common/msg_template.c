@@ -0,0 +1,236 @@
+#include "msg_template.h"
+
+#include <rcl/error_handling.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_typesupport_microxrcedds_c/identifier.h>
+#include <string.h>
+#include <ucdr/microcdr.h>
+
+#include "app_time.h"
+#include "bench_report.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+
+static const char *TAG = "msg_template";
+
+// The CDR encapsulation header that starts a serialised message.
+#define ENCAPSULATION_SIZE (4)
+#define ENCAPSULATION_CDR_BE (0)
+#define ENCAPSULATION_CDR_LE (1)
+// Biggest field that can be added.
+#define FIELD_MAX_SIZE (32)
+
+#if APP_MSG_TEMPLATES
+/* Serialise the template's message into `buffer`.  The CDR alignment is from
+ * the end of the encapsulation header, so the micro-CDR buffer starts there.
+ * Returns the size including the header, or 0 if it doesn't fit.
+ */
+static size_t serialise(const msg_template_t *tmpl, uint8_t *buffer) {
+  ucdrBuffer cdr;
+  ucdr_init_buffer(&cdr, buffer + ENCAPSULATION_SIZE,
+                   MSG_TEMPLATE_MAX_SIZE - ENCAPSULATION_SIZE);
+  if (!tmpl->callbacks->cdr_serialize(tmpl->msg, &cdr) || cdr.error) {
+    return 0;
+  }
+  buffer[0] = 0;
+  buffer[1] = cdr.endianness == UCDR_LITTLE_ENDIANNESS ?
+                  ENCAPSULATION_CDR_LE :
+                  ENCAPSULATION_CDR_BE;
+  buffer[2] = 0;
+  buffer[3] = 0;
+  return ENCAPSULATION_SIZE + ucdr_buffer_length(&cdr);
+}
+#endif
+
+bool msg_template_init(msg_template_t *tmpl, const char *name,
+                       const rosidl_message_type_support_t *type_support,
+                       const void *msg) {
+  memset(tmpl, 0, sizeof(*tmpl));
+  tmpl->name = name;
+  tmpl->msg = msg;
+  tmpl->fallback = true;
+#if APP_MSG_TEMPLATES
+  // The same lookup rmw_microxrcedds does for rcl_publish().
+  const rosidl_message_type_support_t *xrce_type_support =
+      get_message_typesupport_handle(
+          type_support, ROSIDL_TYPESUPPORT_MICROXRCEDDS_C__IDENTIFIER_VALUE);
+  if (xrce_type_support == NULL) {
+    ESP_LOGE(TAG, "%s: no micro-ROS type support, using rcl_publish()",
+             name);
+    return false;
+  }
+  tmpl->callbacks =
+      (const message_type_support_callbacks_t *)xrce_type_support->data;
+  size_t size = serialise(tmpl, tmpl->buffer);
+  if (size == 0) {
+    ESP_LOGE(TAG, "%s: bigger than %d bytes, using rcl_publish()", name,
+             MSG_TEMPLATE_MAX_SIZE);
+    return false;
+  }
+  tmpl->serialized.buffer = tmpl->buffer;
+  tmpl->serialized.buffer_length = size;
+  tmpl->serialized.buffer_capacity = sizeof(tmpl->buffer);
+  tmpl->fallback = false;
+  ESP_LOGI(TAG, "%s: %u byte template", name, (unsigned int)size);
+#endif
+  return true;
+}
+
+bool msg_template_add_field(msg_template_t *tmpl, void *field,
+                            size_t size) {
+#if APP_MSG_TEMPLATES
+  if (tmpl->fallback) {
+    return false;
+  }
+  if (tmpl->field_count == MSG_TEMPLATE_MAX_FIELDS ||
+      size > FIELD_MAX_SIZE) {
+    ESP_LOGE(TAG, "%s: too many fields or too big, using rcl_publish()",
+             tmpl->name);
+    tmpl->fallback = true;
+    return false;
+  }
+  // Every byte of one pattern differs from the same byte of the other, and
+  // the bytes of each differ from each other, so a swapped field shows.
+  uint8_t pattern_a[FIELD_MAX_SIZE];
+  uint8_t pattern_b[FIELD_MAX_SIZE];
+  for (size_t i = 0; i < size; i++) {
+    pattern_a[i] = 0xa5 ^ i;
+    pattern_b[i] = 0x5a ^ i;
+  }
+  // Static to keep them off the stack.
+  static uint8_t buffer_a[MSG_TEMPLATE_MAX_SIZE];
+  static uint8_t buffer_b[MSG_TEMPLATE_MAX_SIZE];
+  uint8_t saved[FIELD_MAX_SIZE];
+  memcpy(saved, field, size);
+  memcpy(field, pattern_a, size);
+  size_t size_a = serialise(tmpl, buffer_a);
+  memcpy(field, pattern_b, size);
+  size_t size_b = serialise(tmpl, buffer_b);
+  memcpy(field, saved, size);
+
+  // The first and last bytes that differ.
+  size_t start = 0;
+  while (start < size_a && buffer_a[start] == buffer_b[start]) {
+    start++;
+  }
+  size_t end = size_a;
+  while (end > start && buffer_a[end - 1] == buffer_b[end - 1]) {
+    end--;
+  }
+  if (size_a == 0 || size_a != size_b || end - start != size ||
+      memcmp(buffer_a + start, pattern_a, size) != 0 ||
+      memcmp(buffer_b + start, pattern_b, size) != 0) {
+    ESP_LOGE(TAG, "%s: can't patch a %u byte field, using rcl_publish()",
+             tmpl->name, (unsigned int)size);
+    tmpl->fallback = true;
+    return false;
+  }
+  msg_template_field_t *added = &tmpl->fields[tmpl->field_count++];
+  added->source = field;
+  added->offset = start;
+  added->size = size;
+  return true;
+#else
+  return true;
+#endif
+}
+
+void msg_template_patch(msg_template_t *tmpl) {
+  for (size_t i = 0; i < tmpl->field_count; i++) {
+    const msg_template_field_t *field = &tmpl->fields[i];
+    memcpy(tmpl->buffer + field->offset, field->source, field->size);
+  }
+}
+
+rcl_ret_t msg_template_publish(msg_template_t *tmpl,
+                               const rcl_publisher_t *publisher) {
+  if (tmpl->fallback) {
+    return rcl_publish(publisher, tmpl->msg, NULL);
+  }
+  msg_template_patch(tmpl);
+  rcl_ret_t rc =
+      rcl_publish_serialized_message(publisher, &tmpl->serialized, NULL);
+  if (rc == RCL_RET_OK) {
+    tmpl->failures = 0;
+    return rc;
+  }
+  rcl_reset_error();
+  bool unsupported = rc == RCL_RET_UNSUPPORTED;
+  rc = rcl_publish(publisher, tmpl->msg, NULL);
+  if (rc == RCL_RET_OK) {
+    tmpl->failures++;
+  }
+  /* Foxy rcl returns the same error when the RMW can't send serialised
+   * messages at all as when it failed to send this one.  Only if it keeps
+   * failing while rcl_publish() works is it the former.
+   */
+  if (unsupported || tmpl->failures >= MSG_TEMPLATE_FALLBACK_FAILURES) {
+    tmpl->fallback = true;
+    DLOG_W(TAG, "%s: the RMW can't publish serialised messages, using "
+           "rcl_publish()", tmpl->name);
+  }
+  return rc;
+}
+
+void msg_template_benchmark(msg_template_t *tmpl,
+                            const rcl_publisher_t *publisher,
+                            uint32_t iterations) {
+#if APP_MSG_TEMPLATES
+  if (tmpl->callbacks == NULL || iterations == 0) {
+    return;
+  }
+  // What rcl_publish() does to the message against what the template does.
+  static uint8_t buffer[MSG_TEMPLATE_MAX_SIZE];
+  uint32_t start = app_cycles();
+  for (uint32_t i = 0; i < iterations; i++) {
+    serialise(tmpl, buffer);
+  }
+  uint32_t serialise_cycles = (app_cycles() - start) / iterations;
+  start = app_cycles();
+  for (uint32_t i = 0; i < iterations; i++) {
+    msg_template_patch(tmpl);
+  }
+  uint32_t patch_cycles = (app_cycles() - start) / iterations;
+
+  // The whole publish.  Only different if the RMW takes serialised messages.
+  uint32_t rcl_publish_cycles = 0;
+  uint32_t template_publish_cycles = 0;
+  uint32_t failures = 0;
+  if (publisher != NULL) {
+    start = app_cycles();
+    for (uint32_t i = 0; i < iterations; i++) {
+      if (rcl_publish(publisher, tmpl->msg, NULL) != RCL_RET_OK) {
+        failures++;
+      }
+    }
+    rcl_publish_cycles = (app_cycles() - start) / iterations;
+    start = app_cycles();
+    for (uint32_t i = 0; i < iterations; i++) {
+      if (msg_template_publish(tmpl, publisher) != RCL_RET_OK) {
+        failures++;
+      }
+    }
+    template_publish_cycles = (app_cycles() - start) / iterations;
+    rcl_reset_error();
+  }
+
+  ESP_LOGI(TAG,
+           "%s: %u " APP_CYCLES_UNIT " to serialise, %u to patch, %u per "
+           "rcl_publish(), %u per template publish%s, %u failures",
+           tmpl->name, (unsigned int)serialise_cycles,
+           (unsigned int)patch_cycles, (unsigned int)rcl_publish_cycles,
+           (unsigned int)template_publish_cycles,
+           tmpl->fallback ? " (fallen back)" : "", (unsigned int)failures);
+  bench_report(
+      "{\"app\":\"msg_template\",\"msg\":\"%s\",\"size\":%u,\"fields\":%u,"
+      "\"iterations\":%u,\"unit\":\"" APP_CYCLES_UNIT "\",\"serialise\":%u,"
+      "\"patch\":%u,\"rcl_publish\":%u,\"template_publish\":%u,"
+      "\"serialized_publish\":%s,\"failures\":%u}",
+      tmpl->name, (unsigned int)tmpl->serialized.buffer_length,
+      (unsigned int)tmpl->field_count, (unsigned int)iterations,
+      (unsigned int)serialise_cycles, (unsigned int)patch_cycles,
+      (unsigned int)rcl_publish_cycles,
+      (unsigned int)template_publish_cycles,
+      tmpl->fallback ? "false" : "true", (unsigned int)failures);
+#endif
+}
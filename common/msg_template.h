@@ -0,0 +1,102 @@
+#ifndef MSG_TEMPLATE_H
+#define MSG_TEMPLATE_H
+
+/* Pre-serialised messages with in-place field patching.
+ *
+ * Most fields of the messages the apps send never change, but rcl_publish()
+ * serialises all of them every time.  msg_template_init() serialises the
+ * message once, with its micro-ROS type support, into a buffer in the
+ * template.  msg_template_add_field() then finds where a field that does
+ * change ended up in the buffer, and msg_template_publish() copies just
+ * those fields from the message into the buffer and sends the buffer with
+ * rcl_publish_serialized_message().  So the app keeps filling in the message
+ * as before and calls msg_template_publish() instead of rcl_publish().
+ *
+ * A field is found by serialising the message twice, with the field set to
+ * two different patterns, and seeing which bytes change.  They must be the
+ * field's bytes unchanged, so only fixed size fields in the CPU's byte order
+ * can be added, e.g. a float, a stamp or a sequence's data.  Nothing else in
+ * the message may change after msg_template_init(), including the sizes of
+ * strings and sequences.
+ *
+ * rmw_microxrcedds for foxy can't publish serialised messages, so the apps
+ * default to APP_MSG_TEMPLATES 0, which makes msg_template_publish() just call
+ * rcl_publish().  With it set to 1 and an RMW that can't, a failed serialised
+ * publish is retried with rcl_publish().  The template falls back to
+ * rcl_publish() for good when rcl says the RMW doesn't support it, or, as foxy
+ * rcl reports every failure the same, after MSG_TEMPLATE_FALLBACK_FAILURES in
+ * a row that rcl_publish() then sent.  A one off failure doesn't.
+ * Only call from the executor task.
+ */
+
+#include <rcl/rcl.h>
+#include <rosidl_typesupport_microxrcedds_c/message_type_support.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#ifndef APP_MSG_TEMPLATES
+#define APP_MSG_TEMPLATES (0)
+#endif
+// Biggest serialised message, including the 4 byte encapsulation header.
+#ifndef MSG_TEMPLATE_MAX_SIZE
+#define MSG_TEMPLATE_MAX_SIZE (256)
+#endif
+#define MSG_TEMPLATE_MAX_FIELDS (4)
+#ifndef MSG_TEMPLATE_FALLBACK_FAILURES
+#define MSG_TEMPLATE_FALLBACK_FAILURES (3)
+#endif
+
+typedef struct {
+  const void *source;  // The field in the message.
+  uint16_t offset;     // Where it is in the buffer.
+  uint16_t size;
+} msg_template_field_t;
+
+typedef struct {
+  const char *name;  // For logging.
+  const void *msg;
+  const message_type_support_callbacks_t *callbacks;
+  rcl_serialized_message_t serialized;
+  msg_template_field_t fields[MSG_TEMPLATE_MAX_FIELDS];
+  size_t field_count;
+  bool fallback;  // Send the message with rcl_publish() instead.
+  // Serialised publishes in a row that failed when rcl_publish() didn't.
+  uint8_t failures;
+  uint8_t buffer[MSG_TEMPLATE_MAX_SIZE];
+} msg_template_t;
+
+/* Serialise `msg` into the template.  `msg` must stay where it is.  Returns
+ * false, and leaves the template to fall back to rcl_publish(), if the type
+ * support has no micro-ROS serialiser or the message is too big.
+ */
+bool msg_template_init(msg_template_t *tmpl, const char *name,
+                       const rosidl_message_type_support_t *type_support,
+                       const void *msg);
+
+/* Patch the `size` bytes at `field`, which is part of the message, on each
+ * publish.  `field` is briefly overwritten.  Returns false if the field
+ * can't be patched, in which case the template falls back to rcl_publish().
+ */
+bool msg_template_add_field(msg_template_t *tmpl, void *field,
+                            size_t size);
+
+// Copy the added fields from the message into the buffer.
+void msg_template_patch(msg_template_t *tmpl);
+
+// Patch and send the template, or send the message with rcl_publish().
+rcl_ret_t msg_template_publish(msg_template_t *tmpl,
+                               const rcl_publisher_t *publisher);
+
+/* Time `iterations` full serialisations of the message against patching the
+ * template and log and bench_report() the results.  If `publisher` isn't NULL,
+ * also time that many rcl_publish() calls against msg_template_publish().
+ * Those messages really are sent, so run it before the app starts sending.
+ */
+void msg_template_benchmark(msg_template_t *tmpl,
+                            const rcl_publisher_t *publisher,
+                            uint32_t iterations);
+
+#endif  // MSG_TEMPLATE_H
@@ -0,0 +1,115 @@
+#include "publish_policy.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "app_time.h"
+#include "bench_report.h"
+#include "deferred_log.h"
+
+static const char *TAG = "policy";
+
+static int64_t report_start_us = 0;
+
+void publish_policy_init(publish_policy_t *policy, const char *name,
+                         size_t value_count,
+                         const publish_policy_config_t *config) {
+  memset(policy, 0, sizeof(*policy));
+  policy->name = name;
+  policy->config = *config;
+  policy->value_count = value_count < PUBLISH_POLICY_MAX_VALUES ?
+                            value_count :
+                            PUBLISH_POLICY_MAX_VALUES;
+}
+
+static bool changed(const publish_policy_t *policy, const float *values) {
+  if (policy->config.deadband < 0.0f) {
+    return true;
+  }
+  for (size_t i = 0; i < policy->value_count; i++) {
+    float last = policy->last_sent[i];
+    if (isnan(values[i]) || isnan(last)) {
+      if (isnan(values[i]) != isnan(last)) {
+        return true;
+      }
+      continue;
+    }
+    float deadband = policy->config.relative_deadband * fabsf(last);
+    if (deadband < policy->config.deadband) {
+      deadband = policy->config.deadband;
+    }
+    if (fabsf(values[i] - last) > deadband) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool publish_policy_check(publish_policy_t *policy, const float *values,
+                          int64_t now_us) {
+  bool send;
+  if (!policy->has_sent) {
+    // Always send the first sample.
+    send = true;
+    policy->stats.sent++;
+  } else {
+    int64_t silence_ms = (now_us - policy->last_sent_us) / 1000;
+    if (silence_ms < policy->config.min_spacing_ms) {
+      send = false;
+      if (changed(policy, values)) {
+        policy->stats.too_soon++;
+      } else {
+        policy->stats.unchanged++;
+      }
+    } else if (changed(policy, values)) {
+      send = true;
+      policy->stats.sent++;
+    } else if (policy->config.max_silence_ms > 0 &&
+               silence_ms >= policy->config.max_silence_ms) {
+      send = true;
+      policy->stats.heartbeats++;
+    } else {
+      send = false;
+      policy->stats.unchanged++;
+    }
+  }
+  if (send) {
+    memcpy(policy->last_sent, values, policy->value_count * sizeof(float));
+    policy->last_sent_us = now_us;
+    policy->has_sent = true;
+  }
+  return send;
+}
+
+void publish_policy_report(publish_policy_t *policies, size_t count) {
+  int64_t now_us = app_time_us();
+  if (report_start_us == 0) {
+    report_start_us = now_us;
+  }
+  int64_t elapsed_us = now_us - report_start_us;
+  if (elapsed_us < (int64_t)PUBLISH_POLICY_REPORT_PERIOD_S * 1000000) {
+    return;
+  }
+  for (size_t i = 0; i < count; i++) {
+    publish_policy_t *policy = &policies[i];
+    const publish_policy_stats_t *stats = &policy->stats;
+    uint32_t sent = stats->sent + stats->heartbeats;
+    uint32_t suppressed = stats->unchanged + stats->too_soon;
+    float saved_pct =
+        sent + suppressed > 0 ? 100.0f * suppressed / (sent + suppressed) : 0;
+    DLOG_I(TAG,
+           "%s: %u sent, %u heartbeats, %u unchanged, %u too soon, "
+           "%.0f%% saved",
+           policy->name, stats->sent, stats->heartbeats, stats->unchanged,
+           stats->too_soon, saved_pct);
+    bench_report(
+        "{\"app\":\"publish_policy\",\"topic\":\"%s\",\"period_s\":%.1f,"
+        "\"sent\":%u,\"heartbeats\":%u,\"unchanged\":%u,\"too_soon\":%u,"
+        "\"saved_pct\":%.1f}",
+        policy->name, elapsed_us / 1000000.0, (unsigned int)stats->sent,
+        (unsigned int)stats->heartbeats, (unsigned int)stats->unchanged,
+        (unsigned int)stats->too_soon, saved_pct);
+    memset(&policy->stats, 0, sizeof(policy->stats));
+  }
+  report_start_us = now_us;
+}
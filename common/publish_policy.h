@@ -0,0 +1,77 @@
+#ifndef PUBLISH_POLICY_H
+#define PUBLISH_POLICY_H
+
+/* Change driven publishing.
+ *
+ * A topic's policy decides, for each new sample, whether it is worth
+ * sending.  A sample is one or more float values, e.g. a battery voltage or
+ * all the ranges of a batched scan.  publish_policy_check() says to send it
+ * if any value moved from the last value sent by more than the deadband,
+ * which is the bigger of `deadband` and `relative_deadband` times the last
+ * value.  A NaN only counts as a change when the last value wasn't NaN.
+ * Whatever the values do:
+ *   - a sample is sent if nothing has been sent for `max_silence_ms`, as a
+ *     heartbeat, so the data is never older than that.  0 for no heartbeat.
+ *   - nothing is sent less than `min_spacing_ms` after the last sample sent.
+ *     A change that comes too soon is compared again with the next sample.
+ * A negative deadband sends every sample, subject to `min_spacing_ms`.
+ *
+ * The policy counts the samples sent and suppressed, and
+ * publish_policy_report() logs them for a set of policies every
+ * PUBLISH_POLICY_REPORT_PERIOD_S.  A sample counts as sent when the policy
+ * passes it, whether it goes out straight away or from a store later.
+ *
+ * Not thread safe.  Use from the executor task only.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#ifndef PUBLISH_POLICY_REPORT_PERIOD_S
+#define PUBLISH_POLICY_REPORT_PERIOD_S (10)
+#endif
+// Most values in one sample.
+#define PUBLISH_POLICY_MAX_VALUES (8)
+
+typedef struct {
+  float deadband;
+  float relative_deadband;
+  uint32_t max_silence_ms;
+  uint32_t min_spacing_ms;
+} publish_policy_config_t;
+
+typedef struct {
+  uint32_t sent;        // Changed by more than the deadband.
+  uint32_t heartbeats;  // Sent after max_silence_ms without a change.
+  uint32_t unchanged;   // Suppressed, within the deadband.
+  uint32_t too_soon;    // Suppressed, changed within min_spacing_ms.
+} publish_policy_stats_t;
+
+typedef struct {
+  const char *name;  // For logging.  Must be a static string.
+  publish_policy_config_t config;
+  size_t value_count;
+  float last_sent[PUBLISH_POLICY_MAX_VALUES];
+  int64_t last_sent_us;
+  bool has_sent;
+  publish_policy_stats_t stats;  // Since the last report.
+} publish_policy_t;
+
+// `value_count` values per sample, at most PUBLISH_POLICY_MAX_VALUES.
+void publish_policy_init(publish_policy_t *policy, const char *name,
+                         size_t value_count,
+                         const publish_policy_config_t *config);
+/* Whether to send the sample `values`, taken at `now_us`.  If so, it is
+ * recorded as the last sample sent.
+ */
+bool publish_policy_check(publish_policy_t *policy, const float *values,
+                          int64_t now_us);
+/* Report the `count` policies in the array `policies`.  Call after each batch
+ * of checks.  Only reports once per period.
+ */
+void publish_policy_report(publish_policy_t *policies, size_t count);
+
+#endif  // PUBLISH_POLICY_H
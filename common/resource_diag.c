@@ -0,0 +1,248 @@
+#include "resource_diag.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "app_time.h"
+#include "bench_report.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "static_allocator.h"
+#include "u32_array.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#else
+#include <stdio.h>
+#endif
+
+#if APP_RESOURCE_DIAG
+#define HEADER_SIZE (8)
+#define NAME_WORDS (4)
+#define TASK_SIZE (NAME_WORDS + 2)
+#define MESSAGE_SIZE (HEADER_SIZE + RESOURCE_DIAG_MAX_TASKS * TASK_SIZE)
+
+typedef struct {
+  char name[NAME_WORDS * 4];
+  uint32_t cpu_per_mille;
+  uint32_t stack_free;
+} task_sample_t;
+
+// The run time of each task at the last sample, to take the difference.
+typedef struct {
+  TaskHandle_t handle;
+  uint32_t run_time;
+} task_run_time_t;
+
+static const char *TAG = "resources";
+
+static int64_t period_start_us = 0;
+static TaskStatus_t statuses[RESOURCE_DIAG_MAX_TASKS];
+/* The names are kept until the next sample, long after the deferred log has
+ * printed them.
+ */
+static task_sample_t tasks[RESOURCE_DIAG_MAX_TASKS];
+static size_t task_count = 0;
+static task_run_time_t run_times[RESOURCE_DIAG_MAX_TASKS];
+static size_t run_time_count = 0;
+static uint32_t last_total_run_time = 0;
+static uint32_t heap_free = 0;
+static uint32_t heap_min_free = RESOURCE_DIAG_UNKNOWN;
+static uint32_t heap_largest_block = RESOURCE_DIAG_UNKNOWN;
+static uint32_t arena_used = RESOURCE_DIAG_UNKNOWN;
+static uint32_t arena_size = RESOURCE_DIAG_UNKNOWN;
+static std_msgs__msg__UInt32MultiArray diag_msg;
+static uint32_t diag_data[MESSAGE_SIZE];
+
+static uint32_t last_run_time(TaskHandle_t handle, bool *found) {
+  for (size_t i = 0; i < run_time_count; i++) {
+    if (run_times[i].handle == handle) {
+      *found = true;
+      return run_times[i].run_time;
+    }
+  }
+  *found = false;
+  return 0;
+}
+
+static void sample_tasks(void) {
+  task_count = 0;
+#if configUSE_TRACE_FACILITY
+  static bool warned = false;
+  uint32_t total_run_time = 0;
+  UBaseType_t count = uxTaskGetSystemState(
+      statuses, RESOURCE_DIAG_MAX_TASKS, &total_run_time);
+  if (count == 0 && !warned) {
+    ESP_LOGW(TAG, "More than %d tasks, raise RESOURCE_DIAG_MAX_TASKS",
+             RESOURCE_DIAG_MAX_TASKS);
+    warned = true;
+  }
+  uint32_t period_run_time = total_run_time - last_total_run_time;
+  for (UBaseType_t i = 0; i < count; i++) {
+    const TaskStatus_t *status = &statuses[i];
+    task_sample_t *task = &tasks[task_count++];
+    strncpy(task->name, status->pcTaskName, sizeof(task->name) - 1);
+    task->name[sizeof(task->name) - 1] = '\0';
+    task->stack_free = status->usStackHighWaterMark;
+    task->cpu_per_mille = RESOURCE_DIAG_UNKNOWN;
+#if configGENERATE_RUN_TIME_STATS
+    bool found;
+    uint32_t last = last_run_time(status->xHandle, &found);
+    if (found && period_run_time > 0) {
+      task->cpu_per_mille = (uint32_t)(
+          (uint64_t)(status->ulRunTimeCounter - last) * 1000 /
+          period_run_time);
+    }
+#endif
+  }
+  // A task that is new this period gets its CPU from the next one.
+  run_time_count = count;
+  for (UBaseType_t i = 0; i < count; i++) {
+    run_times[i].handle = statuses[i].xHandle;
+    run_times[i].run_time = statuses[i].ulRunTimeCounter;
+  }
+  last_total_run_time = total_run_time;
+#else
+  static bool warned = false;
+  if (!warned) {
+    ESP_LOGW(TAG, "Enable the FreeRTOS trace facility in menuconfig for the "
+             "task figures");
+    warned = true;
+  }
+#endif
+}
+
+static void sample_heap(void) {
+#ifdef ESP_PLATFORM
+  heap_free = esp_get_free_heap_size();
+  heap_min_free = esp_get_minimum_free_heap_size();
+  heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+#else
+  // The memory the process could still get, as there is no fixed heap.
+  FILE *meminfo = fopen("/proc/meminfo", "r");
+  if (meminfo != NULL) {
+    char line[128];
+    unsigned long kb;
+    while (fgets(line, sizeof(line), meminfo) != NULL) {
+      if (sscanf(line, "MemAvailable: %lu kB", &kb) == 1) {
+        uint64_t bytes = (uint64_t)kb * 1024;
+        heap_free = bytes < RESOURCE_DIAG_UNKNOWN ?
+                        (uint32_t)bytes :
+                        RESOURCE_DIAG_UNKNOWN - 1;
+        break;
+      }
+    }
+    fclose(meminfo);
+  }
+  if (heap_min_free == RESOURCE_DIAG_UNKNOWN || heap_free < heap_min_free) {
+    heap_min_free = heap_free;
+  }
+#endif
+}
+
+static void sample_arena(void) {
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+  static_allocator_stats_t stats;
+  static_allocator_get_stats(&stats);
+  arena_used = (uint32_t)stats.current_bytes;
+  arena_size = STATIC_ALLOC_ARENA_SIZE;
+#endif
+}
+
+// Returns the words filled.
+static size_t fill_message(uint32_t period_ms) {
+  uint32_t *data = diag_data;
+  *data++ = RESOURCE_DIAG_VERSION;
+  *data++ = period_ms;
+  *data++ = heap_free;
+  *data++ = heap_min_free;
+  *data++ = heap_largest_block;
+  *data++ = arena_used;
+  *data++ = arena_size;
+  *data++ = (uint32_t)task_count;
+  for (size_t i = 0; i < task_count; i++) {
+    const task_sample_t *task = &tasks[i];
+    for (size_t word = 0; word < NAME_WORDS; word++) {
+      const uint8_t *chars = (const uint8_t *)&task->name[word * 4];
+      *data++ = chars[0] | chars[1] << 8 | chars[2] << 16 |
+                (uint32_t)chars[3] << 24;
+    }
+    *data++ = task->cpu_per_mille;
+    *data++ = task->stack_free;
+  }
+  return (size_t)(data - diag_data);
+}
+
+static void log_sample(int64_t period_us) {
+  const task_sample_t *least_stack = NULL;
+  const task_sample_t *busiest = NULL;
+  for (size_t i = 0; i < task_count; i++) {
+    const task_sample_t *task = &tasks[i];
+    // The Linux main thread has the process stack, which isn't measured.
+    if (task->stack_free > 0 &&
+        (least_stack == NULL || task->stack_free < least_stack->stack_free)) {
+      least_stack = task;
+    }
+    if (task->cpu_per_mille != RESOURCE_DIAG_UNKNOWN &&
+        (busiest == NULL || task->cpu_per_mille > busiest->cpu_per_mille)) {
+      busiest = task;
+    }
+    if (task->stack_free > 0 &&
+        task->stack_free < RESOURCE_DIAG_STACK_WARN_BYTES) {
+      DLOG_W(TAG, "%s: only %u bytes of stack left", task->name,
+             task->stack_free);
+    }
+  }
+  if (heap_free < RESOURCE_DIAG_HEAP_WARN_BYTES) {
+    DLOG_W(TAG, "Heap low: %u bytes free, %u at the least", heap_free,
+           heap_min_free);
+  }
+  DLOG_I(TAG, "Heap %u bytes free, %u at the least, %u tasks, least stack "
+         "%u bytes (%s)",
+         heap_free, heap_min_free, (uint32_t)task_count,
+         least_stack != NULL ? least_stack->stack_free : 0,
+         least_stack != NULL ? least_stack->name : "-");
+  if (arena_size != RESOURCE_DIAG_UNKNOWN) {
+    DLOG_I(TAG, "Arena %u/%u bytes in use", arena_used, arena_size);
+  }
+  bench_report(
+      "{\"app\":\"resource_diag\",\"period_s\":%.1f,\"heap_free\":%u,"
+      "\"heap_min_free\":%u,\"tasks\":%u,\"least_stack_task\":\"%s\","
+      "\"least_stack_free\":%u,\"busiest_task\":\"%s\","
+      "\"busiest_cpu_pct\":%.1f}",
+      period_us / 1000000.0, (unsigned int)heap_free,
+      (unsigned int)heap_min_free, (unsigned int)task_count,
+      least_stack != NULL ? least_stack->name : "",
+      least_stack != NULL ? (unsigned int)least_stack->stack_free : 0,
+      busiest != NULL ? busiest->name : "",
+      busiest != NULL ? busiest->cpu_per_mille / 10.0 : 0.0);
+}
+
+void resource_diag_publish(const rcl_publisher_t *publisher) {
+  int64_t now_us = app_time_us();
+  if (period_start_us == 0) {
+    // First call.  Take the run times to measure the first period from.
+    u32_array_init(&diag_msg, diag_data, MESSAGE_SIZE);
+    sample_tasks();
+    period_start_us = now_us;
+    return;
+  }
+  sample_tasks();
+  sample_heap();
+  sample_arena();
+  size_t size = fill_message((uint32_t)((now_us - period_start_us) / 1000));
+  (void)u32_array_publish(&diag_msg, "resources", publisher, size);
+  log_sample(now_us - period_start_us);
+  period_start_us = now_us;
+}
+
+#else
+
+void resource_diag_publish(const rcl_publisher_t *publisher) {
+  (void)publisher;
+}
+
+#endif  // APP_RESOURCE_DIAG
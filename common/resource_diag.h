@@ -0,0 +1,69 @@
+#ifndef RESOURCE_DIAG_H
+#define RESOURCE_DIAG_H
+
+/* Resource diagnostics: CPU, stacks, heap and the static arena.
+ *
+ * With APP_RESOURCE_DIAG set to 1 in app_config.h the app gets a
+ * `resource_diag` timer and publisher (see ENTITY_DIAG_PUBLISHERS in
+ * entity_table.h).  Every RESOURCE_DIAG_PERIOD_MS the timer samples:
+ *   - each task's share of one core over the period and its stack high water
+ *     mark, i.e. the bytes of its stack it has never used.
+ *   - the free heap, the least free heap since boot and the largest free
+ *     block.
+ *   - with APP_ALLOCATOR_STATIC, the bytes of the static arena in use.
+ * It publishes them as a std_msgs/UInt32MultiArray on `diagnostics/resources`
+ * and logs a summary, with a warning for each stack with less than
+ * RESOURCE_DIAG_STACK_WARN_BYTES left and for less than
+ * RESOURCE_DIAG_HEAP_WARN_BYTES of heap free.
+ * tools/resource_dump.py decodes the message.  The layout, all uint32:
+ *   version, period ms, heap free, heap min free, heap largest block,
+ *   arena bytes in use, arena size, task count,
+ *   then for each task: name (4 words of 4 characters, NUL padded, first
+ *   character in the low byte), CPU per mille of one core, stack free bytes.
+ * RESOURCE_DIAG_UNKNOWN is sent for a value that can't be measured.
+ *
+ * The RMW's static pools aren't sampled, as rmw_microxrcedds doesn't say how
+ * full they are.  Their limits are in the app's app-colcon.meta:
+ * gen_colcon_meta.bash sizes the RMW_UXRCE_MAX_* publishers, subscriptions,
+ * clients and services to app_entities.h exactly, and RMW_UXRCE_MAX_HISTORY,
+ * the buffers shared by everything that takes messages, to
+ * APP_RMW_MAX_HISTORY.
+ *
+ * On the ESP32 the tasks come from uxTaskGetSystemState(), which needs "Enable
+ * FreeRTOS trace facility" in menuconfig, and the CPU needs "Enable FreeRTOS
+ * to collect run time stats" too.  The heap is the default capability heap.
+ * On Linux the shim reports the tasks it created, with each thread's CPU time
+ * and a painted stack, and the appMain() thread as "main".  The free heap is
+ * the system's available memory, which stops at 4 GiB, and there is no
+ * largest block.
+ *
+ * Sampling walks the task list and the painted stacks, so keep the period in
+ * seconds.  Use from the executor task only.
+ */
+
+#include <rcl/rcl.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "entity_table.h"
+
+#define RESOURCE_DIAG_VERSION (2)
+#define RESOURCE_DIAG_UNKNOWN (0xffffffffu)
+// Most tasks reported.  FreeRTOS reports none if there are more.
+#ifndef RESOURCE_DIAG_MAX_TASKS
+#define RESOURCE_DIAG_MAX_TASKS (24)
+#endif
+#ifndef RESOURCE_DIAG_STACK_WARN_BYTES
+#define RESOURCE_DIAG_STACK_WARN_BYTES (512)
+#endif
+#ifndef RESOURCE_DIAG_HEAP_WARN_BYTES
+#define RESOURCE_DIAG_HEAP_WARN_BYTES (16 * 1024)
+#endif
+
+/* Sample, publish, log and start a new period.  Called by the resource_diag
+ * timer that ENTITY_REGISTRY_DEFINE() adds.  Publishing fails while the agent
+ * can't be reached, but the sample is still logged.
+ */
+void resource_diag_publish(const rcl_publisher_t *publisher);
+
+#endif  // RESOURCE_DIAG_H
@@ -0,0 +1,57 @@
+#include "spsc_ring.h"
+
+#include <string.h>
+
+bool spsc_ring_init(spsc_ring_t *ring, void *buffer, size_t item_size,
+                    uint32_t capacity) {
+  if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+    return false;
+  }
+  ring->buffer = (uint8_t *)buffer;
+  ring->item_size = item_size;
+  ring->capacity = capacity;
+  atomic_init(&ring->head, 0);
+  atomic_init(&ring->tail, 0);
+  atomic_init(&ring->overruns, 0);
+  return true;
+}
+
+static uint8_t *slot(spsc_ring_t *ring, unsigned int position) {
+  return ring->buffer + (position & (ring->capacity - 1)) * ring->item_size;
+}
+
+bool spsc_ring_push(spsc_ring_t *ring, const void *item) {
+  unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail >= ring->capacity) {
+    atomic_fetch_add_explicit(&ring->overruns, 1, memory_order_relaxed);
+    return false;
+  }
+  memcpy(slot(ring, head), item, ring->item_size);
+  // Publish the item after it has been written.
+  atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+  return true;
+}
+
+bool spsc_ring_pop(spsc_ring_t *ring, void *item) {
+  unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (head == tail) {
+    return false;
+  }
+  memcpy(item, slot(ring, tail), ring->item_size);
+  // Free the slot after it has been read.
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+uint32_t spsc_ring_pop_latest(spsc_ring_t *ring, void *item) {
+  unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&ring->head, memory_order_acquire);
+  if (head == tail) {
+    return 0;
+  }
+  memcpy(item, slot(ring, head - 1), ring->item_size);
+  atomic_store_explicit(&ring->tail, head, memory_order_release);
+  return head - tail;
+}
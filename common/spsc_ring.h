@@ -0,0 +1,44 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+/* Lock-free ring of fixed size items with one producer and one consumer.
+ *
+ * The producer only writes `head` and the consumer only writes `tail`, so the
+ * two can be on different tasks, or cores, without a lock.  A push to a full
+ * ring fails and is counted rather than overwriting, as the producer can't
+ * safely move `tail`.  The consumer can use spsc_ring_pop_latest() to drain
+ * the ring and keep only the newest item.
+ *
+ * The capacity must be a power of 2.  The buffer is provided by the caller,
+ * so there is no allocation.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+  uint8_t *buffer;
+  size_t item_size;
+  uint32_t capacity;
+  atomic_uint head;  // Next slot to write.  Written by the producer.
+  atomic_uint tail;  // Next slot to read.  Written by the consumer.
+  atomic_uint overruns;
+} spsc_ring_t;
+
+/* `buffer` must hold `capacity` items of `item_size` bytes.  Returns false if
+ * the capacity isn't a power of 2.
+ */
+bool spsc_ring_init(spsc_ring_t *ring, void *buffer, size_t item_size,
+                    uint32_t capacity);
+// Producer only.  Returns false and counts an overrun if the ring is full.
+bool spsc_ring_push(spsc_ring_t *ring, const void *item);
+// Consumer only.  Returns false if the ring is empty.
+bool spsc_ring_pop(spsc_ring_t *ring, void *item);
+/* Consumer only.  Empty the ring and copy the newest item.  Returns the number
+ * of items removed, 0 if it was empty, in which case `item` is unchanged.
+ */
+uint32_t spsc_ring_pop_latest(spsc_ring_t *ring, void *item);
+
+#endif  // SPSC_RING_H
@@ -0,0 +1,225 @@
+#include "static_allocator.h"
+
+#include <assert.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <rcutils/allocator.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deferred_log.h"
+#include "esp_log.h"
+
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+#define MIN_BLOCK (16)
+#define MIN_BLOCK_BITS (4)
+_Static_assert((STATIC_ALLOC_MAX_BLOCK & (STATIC_ALLOC_MAX_BLOCK - 1)) == 0,
+               "STATIC_ALLOC_MAX_BLOCK must be a power of 2");
+_Static_assert(STATIC_ALLOC_MAX_BLOCK >= MIN_BLOCK,
+               "STATIC_ALLOC_MAX_BLOCK is too small");
+#define CLASS_COUNT \
+  (31 - __builtin_clz(STATIC_ALLOC_MAX_BLOCK) - MIN_BLOCK_BITS + 1)
+
+static const char *TAG = "alloc";
+
+// Every block starts with a header.  8 bytes keeps the data 8 byte aligned.
+typedef struct {
+  uint32_t size_class;
+  uint32_t size;  // Bytes requested.
+} block_header_t;
+_Static_assert(sizeof(block_header_t) == 8, "Header must be 8 bytes");
+
+// Free blocks hold the free list link where the data was.
+typedef struct free_block {
+  block_header_t header;
+  struct free_block *next;
+} free_block_t;
+
+static _Alignas(8) uint8_t arena[STATIC_ALLOC_ARENA_SIZE];
+static size_t arena_used = 0;
+static free_block_t *free_lists[CLASS_COUNT];
+static SemaphoreHandle_t mutex = NULL;
+static bool sealed = false;
+static static_allocator_stats_t stats;
+
+static size_t class_size(uint32_t size_class) {
+  return (size_t)MIN_BLOCK << size_class;
+}
+
+// Smallest class that holds `size` bytes of data.  CLASS_COUNT if too big.
+static uint32_t class_for(size_t size) {
+  size_t block = size + sizeof(block_header_t);
+  uint32_t size_class = 0;
+  while (size_class < CLASS_COUNT && class_size(size_class) < block) {
+    size_class++;
+  }
+  return size_class;
+}
+
+static bool in_arena(const void *pointer) {
+  const uint8_t *p = (const uint8_t *)pointer;
+  return p >= arena && p < arena + sizeof(arena);
+}
+
+static void lock(void) { xSemaphoreTake(mutex, portMAX_DELAY); }
+static void unlock(void) { xSemaphoreGive(mutex); }
+
+// Called with the lock held.
+static void count_allocation(size_t size) {
+  stats.allocations++;
+  if (sealed) {
+    stats.late_allocations++;
+    DLOG_W(TAG, "%u byte allocation after startup (%u in total)",
+           (unsigned int)size, stats.late_allocations);
+#if STATIC_ALLOC_SEAL_ASSERT
+    assert(!"Allocation after startup");
+#endif
+  }
+}
+
+static void *arena_allocate(size_t size, void *state) {
+  (void)state;
+  uint32_t size_class = class_for(size);
+  lock();
+  count_allocation(size);
+  block_header_t *block = NULL;
+  if (size_class < CLASS_COUNT) {
+    if (free_lists[size_class] != NULL) {
+      block = &free_lists[size_class]->header;
+      free_lists[size_class] = free_lists[size_class]->next;
+    } else if (arena_used + class_size(size_class) <= sizeof(arena)) {
+      block = (block_header_t *)&arena[arena_used];
+      arena_used += class_size(size_class);
+      stats.arena_used = arena_used;
+    }
+  }
+  if (block == NULL) {
+    stats.overflows++;
+    unlock();
+    DLOG_W(TAG, "%u byte allocation overflowed to the heap",
+           (unsigned int)size);
+    return malloc(size);
+  }
+  block->size_class = size_class;
+  block->size = (uint32_t)size;
+  stats.current_bytes += class_size(size_class);
+  if (stats.current_bytes > stats.peak_bytes) {
+    stats.peak_bytes = stats.current_bytes;
+  }
+  unlock();
+  return block + 1;
+}
+
+static void arena_deallocate(void *pointer, void *state) {
+  (void)state;
+  if (pointer == NULL) {
+    return;
+  }
+  if (!in_arena(pointer)) {
+    free(pointer);
+    return;
+  }
+  free_block_t *block = (free_block_t *)((block_header_t *)pointer - 1);
+  uint32_t size_class = block->header.size_class;
+  lock();
+  stats.current_bytes -= class_size(size_class);
+  block->next = free_lists[size_class];
+  free_lists[size_class] = block;
+  unlock();
+}
+
+static void *arena_reallocate(void *pointer, size_t size, void *state) {
+  if (pointer == NULL) {
+    return arena_allocate(size, state);
+  }
+  if (!in_arena(pointer)) {
+    lock();
+    count_allocation(size);
+    unlock();
+    return realloc(pointer, size);
+  }
+  block_header_t *block = (block_header_t *)pointer - 1;
+  if (size + sizeof(block_header_t) <= class_size(block->size_class)) {
+    // Still fits.
+    block->size = (uint32_t)size;
+    return pointer;
+  }
+  void *new_pointer = arena_allocate(size, state);
+  if (new_pointer != NULL) {
+    memcpy(new_pointer, pointer, block->size);
+    arena_deallocate(pointer, state);
+  }
+  return new_pointer;
+}
+
+static void *arena_zero_allocate(size_t number_of_elements,
+                                 size_t size_of_element, void *state) {
+  size_t size = number_of_elements * size_of_element;
+  void *pointer = arena_allocate(size, state);
+  if (pointer != NULL) {
+    memset(pointer, 0, size);
+  }
+  return pointer;
+}
+
+#endif  // APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+
+rcl_allocator_t static_allocator_init(void) {
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+  if (mutex == NULL) {
+    mutex = xSemaphoreCreateMutex();
+  }
+  rcl_allocator_t allocator = rcutils_get_zero_initialized_allocator();
+  allocator.allocate = arena_allocate;
+  allocator.deallocate = arena_deallocate;
+  allocator.reallocate = arena_reallocate;
+  allocator.zero_allocate = arena_zero_allocate;
+#if STATIC_ALLOC_SET_DEFAULT
+  if (!rcutils_set_default_allocator(&allocator)) {
+    ESP_LOGE(TAG, "Failed to set the default allocator");
+  }
+#endif
+  ESP_LOGI(TAG, "Static arena of %u bytes", (unsigned int)sizeof(arena));
+  return allocator;
+#else
+  return rcl_get_default_allocator();
+#endif
+}
+
+void static_allocator_seal(void) {
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+  if (sealed) {
+    return;
+  }
+  lock();
+  sealed = true;
+  static_allocator_stats_t copy = stats;
+  unlock();
+  ESP_LOGI(TAG,
+           "Startup done: %u bytes in use, peak %u, arena %u of %u bytes, "
+           "%u allocations, %u overflows",
+           (unsigned int)copy.current_bytes, (unsigned int)copy.peak_bytes,
+           (unsigned int)copy.arena_used, (unsigned int)sizeof(arena),
+           (unsigned int)copy.allocations, (unsigned int)copy.overflows);
+#endif
+}
+
+void static_allocator_unseal(void) {
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+  lock();
+  sealed = false;
+  unlock();
+#endif
+}
+
+void static_allocator_get_stats(static_allocator_stats_t *stats_out) {
+  memset(stats_out, 0, sizeof(*stats_out));
+#if APP_ALLOCATOR == APP_ALLOCATOR_STATIC
+  if (mutex != NULL) {
+    lock();
+    *stats_out = stats;
+    unlock();
+  }
+#endif
+}
@@ -0,0 +1,79 @@
+#ifndef STATIC_ALLOCATOR_H
+#define STATIC_ALLOCATOR_H
+
+/* rcl allocator backed by a fixed static arena, so that micro-ROS doesn't
+ * fragment the heap over long uptimes.
+ *
+ * The arena is carved into blocks of power of two size classes, from 16 bytes
+ * up to STATIC_ALLOC_MAX_BLOCK.  Freed blocks go on a free list for their
+ * class and are reused, so a steady mix of allocations settles down without
+ * fragmenting.  Requests that don't fit (too big, or the arena is full) fall
+ * back to the heap and are counted as overflows.
+ *
+ * Startup ends when static_allocator_seal() is called.  app_spin() does this
+ * after the first spin, when the executor has created its wait set.  Any
+ * allocation after that is counted and logged, or asserts if
+ * STATIC_ALLOC_SEAL_ASSERT is 1.  The aim is zero allocations in steady state.
+ *
+ * Set APP_ALLOCATOR in app_config.h.
+ */
+
+#include <rcl/allocator.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#define APP_ALLOCATOR_DEFAULT (0)
+#define APP_ALLOCATOR_STATIC (1)
+#ifndef APP_ALLOCATOR
+#define APP_ALLOCATOR APP_ALLOCATOR_DEFAULT
+#endif
+
+// Size of the static arena in bytes.
+#ifndef STATIC_ALLOC_ARENA_SIZE
+#define STATIC_ALLOC_ARENA_SIZE (24 * 1024)
+#endif
+// Largest block.  Must be a power of 2.  Bigger requests use the heap.
+#ifndef STATIC_ALLOC_MAX_BLOCK
+#define STATIC_ALLOC_MAX_BLOCK (4096)
+#endif
+// 1 to assert on allocations after startup instead of counting them.
+#ifndef STATIC_ALLOC_SEAL_ASSERT
+#define STATIC_ALLOC_SEAL_ASSERT (0)
+#endif
+/* 1 to also make the arena the rcutils default allocator.  The rclc
+ * *_init_default() functions get their options from the default allocator, so
+ * without this only the support and executor use the arena.  Needs
+ * rcutils_set_default_allocator().  Not every micro-ROS rcutils for foxy has
+ * it, and then the build fails to link, so this is off by default.
+ */
+#ifndef STATIC_ALLOC_SET_DEFAULT
+#define STATIC_ALLOC_SET_DEFAULT (0)
+#endif
+
+typedef struct {
+  size_t current_bytes;  // Arena blocks in use, including their headers.
+  size_t peak_bytes;
+  size_t arena_used;     // Arena carved into blocks so far.
+  uint32_t allocations;
+  uint32_t overflows;    // Allocations that fell back to the heap.
+  uint32_t late_allocations;  // Allocations after static_allocator_seal().
+} static_allocator_stats_t;
+
+/* Returns the allocator for the app to pass to rclc_support_init() and
+ * rclc_executor_init().  With APP_ALLOCATOR_DEFAULT this is just
+ * rcl_get_default_allocator().  Call at the start of appMain(), before any
+ * messages are initialised.
+ */
+rcl_allocator_t static_allocator_init(void);
+// Mark the end of startup and log the usage.
+void static_allocator_seal(void);
+/* Allow allocations again without counting them, e.g. while the entities are
+ * recreated after a reconnect.  The next static_allocator_seal() logs the
+ * usage again.
+ */
+void static_allocator_unseal(void);
+void static_allocator_get_stats(static_allocator_stats_t *stats);
+
+#endif  // STATIC_ALLOCATOR_H
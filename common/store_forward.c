@@ -0,0 +1,53 @@
+#include "store_forward.h"
+
+#include <string.h>
+
+static uint8_t *sample_at(store_forward_t *store, size_t index) {
+  return store->buffer + ((store->head + index) % store->capacity) *
+                             store->sample_size;
+}
+
+static void push(store_forward_t *store, const void *sample) {
+  if (store->count > 0 && store->policy == STORE_FORWARD_COALESCE) {
+    memcpy(sample_at(store, store->count - 1), sample, store->sample_size);
+    store->stats.coalesced++;
+    return;
+  }
+  if (store->count == store->capacity) {
+    if (store->policy == STORE_FORWARD_DROP_NEWEST) {
+      store->stats.dropped++;
+      return;
+    }
+    // Overwrite the oldest.
+    store->head = (store->head + 1) % store->capacity;
+    store->count--;
+    store->stats.dropped++;
+  }
+  memcpy(sample_at(store, store->count), sample, store->sample_size);
+  store->count++;
+  store->stats.stored++;
+}
+
+bool store_forward_submit(store_forward_t *store, const void *sample,
+                          bool online) {
+  if (online && store->count == 0 && store->send(sample)) {
+    store->stats.sent++;
+    return true;
+  }
+  push(store, sample);
+  return false;
+}
+
+size_t store_forward_flush(store_forward_t *store, size_t max_samples) {
+  size_t flushed = 0;
+  while (flushed < max_samples && store->count > 0) {
+    if (!store->send(sample_at(store, 0))) {
+      break;
+    }
+    store->head = (store->head + 1) % store->capacity;
+    store->count--;
+    flushed++;
+  }
+  store->stats.flushed += flushed;
+  return flushed;
+}
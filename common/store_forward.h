@@ -0,0 +1,81 @@
+#ifndef STORE_FORWARD_H
+#define STORE_FORWARD_H
+
+/* Bounded store for samples produced while the agent is unreachable.
+ *
+ * Each topic has its own store of fixed size samples (an app defined struct,
+ * not a ROS message, as messages hold pointers).  store_forward_submit() sends
+ * a sample straight away when online and nothing is queued, otherwise it is
+ * stored so that the samples still go out in order.  When the store is full,
+ * or for state-like topics, the policy decides what is kept:
+ *
+ * STORE_FORWARD_OVERWRITE: Drop the oldest sample.  For streams where recent
+ *   history matters, e.g. ranges.
+ * STORE_FORWARD_COALESCE: Only keep the newest sample.  For state where only
+ *   the latest value matters, e.g. battery state.
+ * STORE_FORWARD_DROP_NEWEST: Keep the oldest samples and drop new ones.
+ *
+ * store_forward_flush() sends at most a given number of the oldest samples, so
+ * a backlog can be sent in small batches after a reconnect rather than all at
+ * once.  common/connection_manager.c does this.
+ *
+ * Not thread safe.  Use from the executor task only.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+  STORE_FORWARD_OVERWRITE,
+  STORE_FORWARD_COALESCE,
+  STORE_FORWARD_DROP_NEWEST,
+} store_forward_policy_t;
+
+// Send one sample.  Returns false if it wasn't sent, so it is kept.
+typedef bool (*store_forward_send_t)(const void *sample);
+
+typedef struct {
+  uint32_t sent;       // Sent straight away.
+  uint32_t stored;
+  uint32_t flushed;    // Sent from the store.
+  uint32_t dropped;
+  uint32_t coalesced;  // Replaced by a newer sample.
+} store_forward_stats_t;
+
+typedef struct {
+  const char *name;
+  uint8_t *buffer;
+  size_t sample_size;
+  size_t capacity;
+  store_forward_policy_t policy;
+  store_forward_send_t send;
+  size_t head;  // Oldest sample.
+  size_t count;
+  store_forward_stats_t stats;
+} store_forward_t;
+
+/* Define a store called `store` with room for `capacity` samples of type
+ * `sample_type`.
+ */
+#define STORE_FORWARD_DEFINE(store, sample_type, capacity_, policy_, send_) \
+  static sample_type store##_buffer[capacity_];                             \
+  static store_forward_t store = {.name = #store,                           \
+                                  .buffer = (uint8_t *)store##_buffer,      \
+                                  .sample_size = sizeof(sample_type),       \
+                                  .capacity = (capacity_),                  \
+                                  .policy = (policy_),                      \
+                                  .send = (send_)};
+
+/* Send the sample if `online` and nothing is queued, otherwise store it.
+ * Returns true if it was sent.
+ */
+bool store_forward_submit(store_forward_t *store, const void *sample,
+                          bool online);
+// Send up to `max_samples` of the oldest stored samples.  Returns the number.
+size_t store_forward_flush(store_forward_t *store, size_t max_samples);
+static inline size_t store_forward_count(const store_forward_t *store) {
+  return store->count;
+}
+
+#endif  // STORE_FORWARD_H
@@ -0,0 +1,32 @@
+#include "string_pool.h"
+
+#include <string.h>
+
+static char pool[STRING_POOL_SIZE];
+static size_t pool_used = 0;
+
+bool string_pool_init(rosidl_runtime_c__String *string, size_t capacity) {
+  // rosidl capacity includes the terminator.
+  if (pool_used + capacity + 1 > sizeof(pool)) {
+    return false;
+  }
+  string->data = &pool[pool_used];
+  string->data[0] = '\0';
+  string->size = 0;
+  string->capacity = capacity + 1;
+  pool_used += capacity + 1;
+  return true;
+}
+
+void string_pool_set(rosidl_runtime_c__String *string, const char *text) {
+  if (string->capacity == 0) {
+    return;
+  }
+  size_t size = strlen(text);
+  if (size >= string->capacity) {
+    size = string->capacity - 1;
+  }
+  memcpy(string->data, text, size);
+  string->data[size] = '\0';
+  string->size = size;
+}
@@ -0,0 +1,33 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+/* Fixed capacity strings for message buffers.
+ *
+ * Strings in messages that are received into, e.g. a service response, need
+ * their buffer allocated before the message is taken.  string_pool_init()
+ * gives a rosidl string a buffer from a static pool instead of the heap.  The
+ * buffers are never freed, so don't call __fini() on a message that uses them.
+ */
+
+#include <rosidl_runtime_c/string.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "app_config.h"
+
+// Total bytes in the pool, shared by all strings.
+#ifndef STRING_POOL_SIZE
+#define STRING_POOL_SIZE (512)
+#endif
+
+/* Give `string` an empty buffer that can hold `capacity` characters plus the
+ * terminator.  Returns false if the pool is used up.
+ */
+bool string_pool_init(rosidl_runtime_c__String *string, size_t capacity);
+
+/* Copy `text` into a string set up by string_pool_init(), truncating it to
+ * fit.  Does no allocation.
+ */
+void string_pool_set(rosidl_runtime_c__String *string, const char *text);
+
+#endif  // STRING_POOL_H
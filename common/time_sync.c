@@ -0,0 +1,59 @@
+#include "time_sync.h"
+
+#include <rmw_uros/options.h>
+
+#include "app_time.h"
+#include "esp_log.h"
+#include "executor_split.h"
+
+static const char *TAG = "time_sync";
+
+static bool synchronised = false;
+// Agent time minus app_time_us(), in ns.
+static int64_t offset_ns = 0;
+static int64_t last_sync_us = 0;
+
+bool time_sync_refresh(bool force) {
+  int64_t now_us = app_time_us();
+  if (!force && synchronised &&
+      now_us - last_sync_us < (int64_t)TIME_SYNC_PERIOD_S * 1000000) {
+    return true;
+  }
+  last_sync_us = now_us;
+  executor_split_lock();
+  bool ok = rmw_uros_sync_session(TIME_SYNC_TIMEOUT_MS) == RMW_RET_OK &&
+            rmw_uros_epoch_synchronized();
+  int64_t epoch_ns = rmw_uros_epoch_nanos();
+  int64_t local_us = app_time_us();
+  executor_split_unlock();
+  if (!ok) {
+    ESP_LOGW(TAG, "Failed to sync with the agent");
+    return false;
+  }
+  int64_t new_offset_ns = epoch_ns - local_us * 1000;
+  if (synchronised) {
+    // Positive if the local clock was slow.
+    ESP_LOGI(TAG, "Resynced, drift %d us",
+             (int)((new_offset_ns - offset_ns) / 1000));
+  } else {
+    ESP_LOGI(TAG, "Synced with the agent");
+  }
+  offset_ns = new_offset_ns;
+  synchronised = true;
+  return true;
+}
+
+bool time_sync_valid(void) { return synchronised; }
+
+int64_t time_sync_epoch_ns(int64_t time_us) {
+  if (!synchronised) {
+    return 0;
+  }
+  return time_us * 1000 + offset_ns;
+}
+
+void time_sync_stamp(builtin_interfaces__msg__Time *stamp, int64_t time_us) {
+  int64_t epoch_ns = time_sync_epoch_ns(time_us);
+  stamp->sec = (int32_t)(epoch_ns / 1000000000);
+  stamp->nanosec = (uint32_t)(epoch_ns % 1000000000);
+}
@@ -0,0 +1,41 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+/* Agent time for message stamps.
+ *
+ * time_sync_refresh() synchronises with the agent's clock using
+ * rmw_uros_sync_session() when the connection is made and then every
+ * TIME_SYNC_PERIOD_S.  The offset from app_time_us() is kept here rather than
+ * read from the session, so stamps still work while the agent can't be
+ * reached and samples taken offline get the time they were taken.  Each
+ * resync logs how far the clock had drifted.
+ *
+ * Until the first sync the stamps are 0, which tools/stamp_latency.py counts
+ * as unsynchronised.
+ */
+
+#include <builtin_interfaces/msg/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_config.h"
+
+#ifndef TIME_SYNC_PERIOD_S
+#define TIME_SYNC_PERIOD_S (60)
+#endif
+#ifndef TIME_SYNC_TIMEOUT_MS
+#define TIME_SYNC_TIMEOUT_MS (100)
+#endif
+
+/* Sync if it's due, or straight away if `force`.  Needs a session, so called
+ * by common/connection_manager.c.  Returns false if the sync failed.
+ */
+bool time_sync_refresh(bool force);
+bool time_sync_valid(void);
+// Agent time, in ns since the epoch, at `time_us` from app_time_us().  0 if
+// not synchronised yet.
+int64_t time_sync_epoch_ns(int64_t time_us);
+// Stamp `stamp` with the agent time at `time_us` from app_time_us().
+void time_sync_stamp(builtin_interfaces__msg__Time *stamp, int64_t time_us);
+
+#endif  // TIME_SYNC_H
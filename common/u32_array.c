@@ -0,0 +1,27 @@
+#include "u32_array.h"
+
+#include <rcl/error_handling.h>
+#include <string.h>
+
+#include "deferred_log.h"
+
+static const char *TAG = "u32_array";
+
+void u32_array_init(std_msgs__msg__UInt32MultiArray *msg, uint32_t *data,
+                    size_t capacity) {
+  memset(msg, 0, sizeof(*msg));
+  msg->data.data = data;
+  msg->data.capacity = capacity;
+}
+
+rcl_ret_t u32_array_publish(std_msgs__msg__UInt32MultiArray *msg,
+                            const char *name,
+                            const rcl_publisher_t *publisher, size_t size) {
+  msg->data.size = size;
+  rcl_ret_t rc = rcl_publish(publisher, msg, NULL);
+  if (rc != RCL_RET_OK) {
+    rcl_reset_error();
+    DLOG_W(TAG, "%s: publish failed: %d", name, (int)rc);
+  }
+  return rc;
+}
@@ -0,0 +1,27 @@
+#ifndef U32_ARRAY_H
+#define U32_ARRAY_H
+
+/* A std_msgs/UInt32MultiArray on a static buffer, for the topics that publish
+ * a flat array of uint32: executor_profile.h, resource_diag.h and the
+ * subscribers app's cmd_vel_ack.h.  The layout has no dimensions, just the
+ * data, which each of those headers documents.
+ */
+
+#include <rcl/rcl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "std_msgs/msg/u_int32_multi_array.h"
+
+// Points msg at data, which holds capacity words.  The size starts at 0.
+void u32_array_init(std_msgs__msg__UInt32MultiArray *msg, uint32_t *data,
+                    size_t capacity);
+/* Publishes the first size words of msg.  A failure is logged against name, a
+ * static string, and the rcl error is cleared.  Returns the rcl_publish()
+ * result.
+ */
+rcl_ret_t u32_array_publish(std_msgs__msg__UInt32MultiArray *msg,
+                            const char *name,
+                            const rcl_publisher_t *publisher, size_t size);
+
+#endif  // U32_ARRAY_H
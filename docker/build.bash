@@ -1,13 +1,18 @@
 #!/bin/bash
 set -e
 
+apps="publishers services subscribers latency"
+
 # Copy code over.
-rm -rf ~/ws/firmware/freertos_apps/apps/publishers
-cp -rf ~/code/publishers/ ~/ws/firmware/freertos_apps/apps
-rm -rf ~/ws/firmware/freertos_apps/apps/services
-cp -rf ~/code/services/ ~/ws/firmware/freertos_apps/apps
-rm -rf ~/ws/firmware/freertos_apps/apps/subscribers
-cp -rf ~/code/subscribers/ ~/ws/firmware/freertos_apps/apps
+for app in ${apps}
+do
+    # app-colcon.meta is generated from the app's entity table.
+    ~/code/tools/gen_colcon_meta.bash ~/code/${app}
+    rm -rf ~/ws/firmware/freertos_apps/apps/${app}
+    cp -rf ~/code/${app}/ ~/ws/firmware/freertos_apps/apps
+    # Code shared by all apps.
+    cp -f ~/code/common/* ~/ws/firmware/freertos_apps/apps/${app}
+done
 
 
 # Build the new code.
@@ -0,0 +1,69 @@
+#!/bin/bash
+# Builds an app as a Linux process.  Run setup_host.bash first.
+# Usage: build_host.bash [--local] <app> [OPTION=VALUE ...]
+# The micro-ROS libraries are built with the limits generated from the app's
+# entity table, as for the ESP32, so only that app is built.  Run it again to
+# switch apps.  Any OPTION=VALUE overrides a build option in the app's
+# app_config.h, e.g. SERVICE_REQUEST_PERIOD_MS=100.
+# --local builds for the local transport (pty or UNIX socket) instead of UDP.
+# See host/local_transport.h.
+set -e
+
+meta_option=--host
+meta_name=host-colcon.meta
+if [ "$1" == "--local" ]
+then
+    meta_option=--host-local
+    meta_name=host-local-colcon.meta
+    shift
+fi
+if [ $# -lt 1 ]
+then
+    echo "Usage: $0 [--local] <app> [OPTION=VALUE ...]"
+    exit 1
+fi
+app=$1
+shift
+meta_defines=""
+app_defines=""
+for option in "$@"
+do
+    meta_defines="${meta_defines} -D${option}"
+    app_defines="${app_defines:+${app_defines};}${option}"
+done
+
+# Make sure the meta matches the app's current entity table.
+~/code/tools/gen_colcon_meta.bash ${meta_option} ~/code/${app} ${meta_defines}
+
+cd ~/host_ws
+source /opt/ros/foxy/setup.bash
+# The apps are built straight from ~/code so no copying is needed.
+colcon build --metas ~/code/${app}/${meta_name} --base-paths src ~/code/host \
+    --packages-skip micro_ros_esp32_test_host
+colcon build --base-paths src ~/code/host \
+    --packages-select micro_ros_esp32_test_host \
+    --cmake-args -DHOST_APPS=${app} "-DHOST_APP_DEFINES=${app_defines}"
+source install/local_setup.bash
+
+echo
+if [ "${meta_option}" == "--host-local" ]
+then
+    echo "Start the agent in another terminal:"
+    echo "ros2 run micro_ros_agent micro_ros_agent pty"
+    echo
+    echo "Then run the app with the pty the agent printed:"
+    echo ". ~/host_ws/install/local_setup.bash"
+    echo "export RMW_IMPLEMENTATION=rmw_microxrcedds"
+    echo "HOST_AGENT_DEVICE=/dev/pts/N ros2 run micro_ros_esp32_test_host ${app}"
+    echo
+    echo "Or use ~/code/tools/local_bench.bash ${app}"
+else
+    echo "Start the agent in another terminal:"
+    echo "ros2 run micro_ros_agent micro_ros_agent udp4 --port 8888"
+    echo
+    echo "Then run the app using:"
+    echo ". ~/host_ws/install/local_setup.bash"
+    echo "export RMW_IMPLEMENTATION=rmw_microxrcedds"
+    echo "ros2 run micro_ros_esp32_test_host ${app}"
+fi
+echo
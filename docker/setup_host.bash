@@ -0,0 +1,30 @@
+#!/bin/bash
+# Sets up a workspace for building the apps as Linux processes.
+# Uses its own workspace as the micro-ROS host libraries conflict with the
+# ESP32 firmware workspace.
+set -e
+
+mkdir -p ~/host_ws/src
+cd ~/host_ws/src
+if [ ! -e ~/host_ws/src/micro_ros_setup ]
+then
+	git clone -b $ROS_DISTRO https://github.com/micro-ROS/micro_ros_setup.git
+fi
+
+source /opt/ros/foxy/setup.bash
+
+sudo apt update
+rosdep update
+cd ~/host_ws
+rosdep install --from-path src --ignore-src -y
+
+colcon build
+source install/local_setup.bash
+
+# Download the micro-ROS client libraries for Linux.
+ros2 run micro_ros_setup create_firmware_ws.sh host
+
+echo
+echo "Now build the apps using:"
+echo "./build_host.bash"
+echo
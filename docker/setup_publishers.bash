@@ -28,7 +28,9 @@ source install/local_setup.bash
 ros2 run micro_ros_setup create_firmware_ws.sh freertos esp32
 
 # Copy in our code and configure application.
+~/code/tools/gen_colcon_meta.bash ~/code/publishers
 cp -rf ~/code/publishers/ ~/ws/firmware/freertos_apps/apps
+cp -f ~/code/common/* ~/ws/firmware/freertos_apps/apps/publishers
 ros2 run micro_ros_setup configure_firmware.sh publishers -t udp -i 192.168.54.1 -p 8888
 
 echo
@@ -0,0 +1,127 @@
+#include "local_transport.h"
+
+#include <rmw_microxrcedds_c/config.h>
+
+#ifdef RMW_UXRCE_TRANSPORT_CUSTOM
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <rmw_uros/options.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#define UNIX_PREFIX "unix:"
+
+static const char *device = NULL;
+static int fd = -1;
+
+static bool open_unix_socket(const char *path) {
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path too long: %s\n", path);
+    return false;
+  }
+  strcpy(address.sun_path, path);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  if (connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  return true;
+}
+
+static bool open_pty(const char *path) {
+  fd = open(path, O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return false;
+  }
+  // No echo or line editing.  The agent sets its end up the same way.
+  struct termios tty;
+  if (tcgetattr(fd, &tty) == 0) {
+    cfmakeraw(&tty);
+    tcsetattr(fd, TCSANOW, &tty);
+  }
+  return true;
+}
+
+static bool transport_open(struct uxrCustomTransport *transport) {
+  bool opened = strncmp(device, UNIX_PREFIX, strlen(UNIX_PREFIX)) == 0 ?
+                    open_unix_socket(device + strlen(UNIX_PREFIX)) :
+                    open_pty(device);
+  if (!opened) {
+    fprintf(stderr, "Can't open %s: %s\n", device, strerror(errno));
+  }
+  return opened;
+}
+
+static bool transport_close(struct uxrCustomTransport *transport) {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+  return true;
+}
+
+static size_t transport_write(struct uxrCustomTransport *transport,
+                              const uint8_t *buffer, size_t length,
+                              uint8_t *error) {
+  size_t written = 0;
+  while (written < length) {
+    ssize_t rc = write(fd, buffer + written, length - written);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      *error = 1;
+      break;
+    }
+    written += rc;
+  }
+  return written;
+}
+
+static size_t transport_read(struct uxrCustomTransport *transport,
+                             uint8_t *buffer, size_t length, int timeout_ms,
+                             uint8_t *error) {
+  struct pollfd poll_fd = {.fd = fd, .events = POLLIN};
+  int ready = poll(&poll_fd, 1, timeout_ms);
+  if (ready <= 0) {
+    // A timeout isn't an error.
+    if (ready < 0 && errno != EINTR) {
+      *error = 1;
+    }
+    return 0;
+  }
+  ssize_t rc = read(fd, buffer, length);
+  if (rc <= 0) {
+    *error = 1;
+    return 0;
+  }
+  return rc;
+}
+
+bool local_transport_init(void) {
+  device = getenv("HOST_AGENT_DEVICE");
+  if (device == NULL) {
+    fprintf(stderr,
+            "Built for the local transport.  Set HOST_AGENT_DEVICE to the "
+            "agent's pty, or unix:<socket path>.\n");
+    return false;
+  }
+  printf("Local transport: %s\n", device);
+  return rmw_uros_set_custom_transport(true, NULL, transport_open,
+                                       transport_close, transport_write,
+                                       transport_read) == RMW_RET_OK;
+}
+#else
+bool local_transport_init(void) { return true; }
+#endif
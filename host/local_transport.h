@@ -0,0 +1,27 @@
+#ifndef LOCAL_TRANSPORT_H
+#define LOCAL_TRANSPORT_H
+
+/* Local transport for the Linux build.
+ *
+ * When rmw_microxrcedds is built with RMW_UXRCE_TRANSPORT=custom, e.g. with
+ * the app's host-local-colcon.meta, the apps talk to an agent on the same
+ * machine through a pseudo terminal or a UNIX domain socket instead of UDP.
+ * That leaves out the network stack, so the timings are just the client
+ * library, the executor and the agent.  The HOST_AGENT_DEVICE environment
+ * variable says where the agent is:
+ *   /dev/pts/N        The pseudo terminal of an agent started with
+ *                     "micro_ros_agent pty".
+ *   unix:/path/name   A stream socket.  The agent only does serial, so use
+ *                     socat to join the socket to a pty, see
+ *                     tools/local_bench.bash.
+ * Both are byte streams, so the XRCE serial framing is used.
+ *
+ * Does nothing with the UDP transport.
+ */
+
+#include <stdbool.h>
+
+// Call before appMain().  Returns false if the transport can't be set up.
+bool local_transport_init(void);
+
+#endif  // LOCAL_TRANSPORT_H
@@ -0,0 +1,30 @@
+/* Runs an app as a Linux process.  appMain() is called on the main thread in
+ * place of the ESP32's micro-ROS task.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host_main.h"
+#include "local_transport.h"
+
+void appMain(void *arg);
+
+static pthread_t app_thread;
+
+bool host_is_app_thread(void) {
+  return pthread_equal(pthread_self(), app_thread);
+}
+
+int main(int argc, char *argv[]) {
+  // Line buffer so the logs interleave sensibly when piped to a file.
+  setvbuf(stdout, NULL, _IOLBF, 0);
+  host_shim_init();
+  if (!local_transport_init()) {
+    return EXIT_FAILURE;
+  }
+  app_thread = pthread_self();
+  appMain(NULL);
+  return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef HOST_SHIM_ESP_LOG_H
+#define HOST_SHIM_ESP_LOG_H
+
+// ESP-IDF style logging to stdout, e.g. "I (1234) tag: message".
+
+#include <stdio.h>
+
+#include "freertos/task.h"
+
+#define HOST_LOG(letter, tag, format, ...)                              \
+  printf(letter " (%u) %s: " format "\n", (unsigned int)xTaskGetTickCount(), \
+         tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG("D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG("V", tag, format, ##__VA_ARGS__)
+
+#endif  // HOST_SHIM_ESP_LOG_H
@@ -0,0 +1,30 @@
+#ifndef HOST_SHIM_FREERTOS_H
+#define HOST_SHIM_FREERTOS_H
+
+/* Minimal FreeRTOS API for running the apps as Linux processes.
+ * Tasks are pthreads and ticks are milliseconds.
+ */
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void *TaskHandle_t;
+
+#define configTICK_RATE_HZ (1000)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define pdFALSE ((BaseType_t)0)
+#define pdTRUE ((BaseType_t)1)
+#define pdFAIL (pdFALSE)
+#define pdPASS (pdTRUE)
+#define tskIDLE_PRIORITY ((UBaseType_t)0)
+#define tskNO_AFFINITY ((BaseType_t)0x7fffffff)
+// uxTaskGetSystemState() is available and fills in the run time.
+#define configUSE_TRACE_FACILITY (1)
+#define configGENERATE_RUN_TIME_STATS (1)
+#define configMAX_TASK_NAME_LEN (16)
+
+#endif  // HOST_SHIM_FREERTOS_H
@@ -0,0 +1,14 @@
+#ifndef HOST_SHIM_SEMPHR_H
+#define HOST_SHIM_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+// Mutexes only.  Backed by pthread mutexes.
+typedef void *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif  // HOST_SHIM_SEMPHR_H
@@ -0,0 +1,57 @@
+#ifndef HOST_SHIM_TASK_H
+#define HOST_SHIM_TASK_H
+
+#include <sched.h>
+
+#include "freertos/FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+
+/* Tasks run as detached pthreads.  The stack size is in bytes, as on the
+ * ESP32.  Priorities are ignored as normal users can't set real time
+ * priorities on Linux.  The stacks are filled with a pattern so that the high
+ * water mark can be found, as FreeRTOS does.
+ */
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name,
+                       uint32_t stack_size, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle);
+// The core becomes the CPU affinity of the thread.
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name,
+                                   uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+/* Only vTaskDelete(NULL) is supported.  Ends the calling thread.  On the
+ * thread that runs appMain() it ends the process with a failure status, as
+ * the apps only get there after an RCCHECK has failed.
+ */
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+/* Bytes of the task's stack never used.  0 for the thread that runs appMain(),
+ * which has the process's stack.
+ */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+/* The fields of FreeRTOS's TaskStatus_t that the shim fills in.  The run time
+ * is the thread's CPU time in microseconds.
+ */
+typedef struct {
+  TaskHandle_t xHandle;
+  const char *pcTaskName;
+  UBaseType_t xTaskNumber;
+  uint32_t ulRunTimeCounter;
+  uint32_t usStackHighWaterMark;
+} TaskStatus_t;
+
+UBaseType_t uxTaskGetNumberOfTasks(void);
+/* The tasks created through the shim and still running, and the appMain()
+ * thread as "main".  Returns 0 if `size` is too small, as FreeRTOS does.
+ * `total_run_time` is the time since the process started, in microseconds.
+ */
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size,
+                                 uint32_t *total_run_time);
+#define taskYIELD() sched_yield()
+
+#endif  // HOST_SHIM_TASK_H
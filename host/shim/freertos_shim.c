@@ -0,0 +1,339 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "host_main.h"
+
+// Tasks that uxTaskGetSystemState() can report.  More than this still run.
+#define MAX_TASKS (16)
+// What the task stacks are filled with, to find the high water mark.
+#define STACK_FILL (0xa5)
+
+typedef struct {
+  bool used;
+  bool running;  // Set by the task itself, once `thread` is valid.
+  pthread_t thread;
+  char name[configMAX_TASK_NAME_LEN];
+  UBaseType_t number;
+  uint8_t *stack;
+  size_t stack_size;
+} task_entry_t;
+
+static pthread_mutex_t task_mutex = PTHREAD_MUTEX_INITIALIZER;
+static task_entry_t tasks[MAX_TASKS];
+static UBaseType_t task_number = 0;
+static pthread_t main_thread;
+// This thread's slot in `tasks`, or -1.
+static __thread int task_slot = -1;
+
+typedef struct {
+  TaskFunction_t function;
+  void *arg;
+  int slot;
+} task_start_t;
+
+// Reserve a slot for a new task, or return -1 if they are all taken.
+static int task_reserve(const char *name, uint8_t *stack, size_t stack_size) {
+  int slot = -1;
+  pthread_mutex_lock(&task_mutex);
+  for (int i = 0; i < MAX_TASKS; i++) {
+    if (!tasks[i].used) {
+      slot = i;
+      tasks[i].used = true;
+      tasks[i].running = false;
+      snprintf(tasks[i].name, sizeof(tasks[i].name), "%s", name);
+      tasks[i].number = ++task_number;
+      tasks[i].stack = stack;
+      tasks[i].stack_size = stack_size;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&task_mutex);
+  return slot;
+}
+
+/* The stack of a task that ended is not freed, as the thread is still on it.
+ * The tasks in the apps never end, so this doesn't matter.
+ */
+static void task_release(int slot) {
+  if (slot < 0) {
+    return;
+  }
+  pthread_mutex_lock(&task_mutex);
+  tasks[slot].used = false;
+  tasks[slot].running = false;
+  pthread_mutex_unlock(&task_mutex);
+}
+
+static void *task_start(void *arg) {
+  task_start_t start = *(task_start_t *)arg;
+  free(arg);
+  if (start.slot >= 0) {
+    pthread_mutex_lock(&task_mutex);
+    tasks[start.slot].thread = pthread_self();
+    tasks[start.slot].running = true;
+    pthread_mutex_unlock(&task_mutex);
+  }
+  task_slot = start.slot;
+  start.function(start.arg);
+  task_release(start.slot);
+  return NULL;
+}
+
+static BaseType_t create_thread(TaskFunction_t function, const char *name,
+                                uint32_t stack_size, void *arg,
+                                TaskHandle_t *handle, int cpu) {
+  task_start_t *start = malloc(sizeof(task_start_t));
+  if (start == NULL) {
+    return pdFAIL;
+  }
+  start->function = function;
+  start->arg = arg;
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+  // Linux needs more stack than the ESP32 for the same code.
+  size_t size = (size_t)stack_size * 4;
+  if (size < (size_t)PTHREAD_STACK_MIN) {
+    size = (size_t)PTHREAD_STACK_MIN;
+  }
+  void *stack = NULL;
+  if (posix_memalign(&stack, (size_t)sysconf(_SC_PAGESIZE), size) == 0) {
+    memset(stack, STACK_FILL, size);
+    pthread_attr_setstack(&attr, stack, size);
+    start->slot = task_reserve(name, stack, size);
+  } else {
+    stack = NULL;
+    pthread_attr_setstacksize(&attr, size);
+    start->slot = -1;
+  }
+  if (cpu >= 0) {
+    // Wrap so that a core that the host doesn't have still gives a thread.
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpu_count > 0) {
+      cpu %= (int)cpu_count;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+  }
+  pthread_t thread;
+  int rc = pthread_create(&thread, &attr, task_start, start);
+  pthread_attr_destroy(&attr);
+  if (rc != 0) {
+    fprintf(stderr, "Failed to create task '%s': %d\n", name, rc);
+    task_release(start->slot);
+    free(start);
+    free(stack);
+    return pdFAIL;
+  }
+  pthread_setname_np(thread, name);
+  if (handle != NULL) {
+    *handle = (TaskHandle_t)thread;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name,
+                       uint32_t stack_size, void *arg, UBaseType_t priority,
+                       TaskHandle_t *handle) {
+  (void)priority;
+  return create_thread(function, name, stack_size, arg, handle, -1);
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name,
+                                   uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  (void)priority;
+  int cpu = (core == tskNO_AFFINITY) ? -1 : (int)core;
+  return create_thread(function, name, stack_size, arg, handle, cpu);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (task != NULL) {
+    fprintf(stderr, "vTaskDelete() of another task is not supported\n");
+    return;
+  }
+  if (host_is_app_thread()) {
+    fprintf(stderr, "appMain task deleted, exiting\n");
+    exit(EXIT_FAILURE);
+  }
+  task_release(task_slot);
+  pthread_exit(NULL);
+}
+
+static struct timespec start_time;
+
+static void ticks_to_timespec(TickType_t ticks, struct timespec *ts) {
+  uint64_t ns = (uint64_t)start_time.tv_nsec +
+                (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL;
+  ts->tv_sec = start_time.tv_sec + (time_t)(ns / 1000000000ULL);
+  ts->tv_nsec = (long)(ns % 1000000000ULL);
+}
+
+void host_shim_init(void) {
+  clock_gettime(CLOCK_MONOTONIC, &start_time);
+  main_thread = pthread_self();
+}
+
+TickType_t xTaskGetTickCount(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t ms = (int64_t)(now.tv_sec - start_time.tv_sec) * 1000 +
+               (now.tv_nsec - start_time.tv_nsec) / 1000000;
+  return (TickType_t)(ms / portTICK_PERIOD_MS);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  struct timespec ts = {
+      .tv_sec = (time_t)(ticks * portTICK_PERIOD_MS / 1000),
+      .tv_nsec = (long)(ticks * portTICK_PERIOD_MS % 1000) * 1000000L,
+  };
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+  }
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment) {
+  *previous_wake += increment;
+  struct timespec wake;
+  ticks_to_timespec(*previous_wake, &wake);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) ==
+         EINTR) {
+  }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  return (TaskHandle_t)pthread_self();
+}
+
+// Call with task_mutex held.
+static uint32_t stack_high_water(const task_entry_t *task) {
+  size_t unused = 0;
+  while (unused < task->stack_size && task->stack[unused] == STACK_FILL) {
+    unused++;
+  }
+  return (uint32_t)unused;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  pthread_t thread = task == NULL ? pthread_self() : (pthread_t)task;
+  UBaseType_t unused = 0;
+  pthread_mutex_lock(&task_mutex);
+  for (int i = 0; i < MAX_TASKS; i++) {
+    if (tasks[i].running && pthread_equal(tasks[i].thread, thread)) {
+      unused = stack_high_water(&tasks[i]);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&task_mutex);
+  return unused;
+}
+
+static uint32_t thread_cpu_us(pthread_t thread) {
+  clockid_t clock;
+  struct timespec ts;
+  if (pthread_getcpuclockid(thread, &clock) != 0 ||
+      clock_gettime(clock, &ts) != 0) {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+  UBaseType_t count = 1;
+  pthread_mutex_lock(&task_mutex);
+  for (int i = 0; i < MAX_TASKS; i++) {
+    if (tasks[i].running) {
+      count++;
+    }
+  }
+  pthread_mutex_unlock(&task_mutex);
+  return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t size,
+                                 uint32_t *total_run_time) {
+  if (size == 0) {
+    return 0;
+  }
+  status[0] = (TaskStatus_t){
+      .xHandle = (TaskHandle_t)main_thread,
+      .pcTaskName = "main",
+      .xTaskNumber = 0,
+      .ulRunTimeCounter = thread_cpu_us(main_thread),
+      .usStackHighWaterMark = 0,
+  };
+  UBaseType_t count = 1;
+  // A task takes the mutex before it ends, so its thread is valid here.
+  pthread_mutex_lock(&task_mutex);
+  for (int i = 0; i < MAX_TASKS; i++) {
+    const task_entry_t *task = &tasks[i];
+    if (!task->running) {
+      continue;
+    }
+    if (count == size) {
+      count = 0;
+      break;
+    }
+    status[count++] = (TaskStatus_t){
+        .xHandle = (TaskHandle_t)task->thread,
+        .pcTaskName = task->name,
+        .xTaskNumber = task->number,
+        .ulRunTimeCounter = thread_cpu_us(task->thread),
+        .usStackHighWaterMark = stack_high_water(task),
+    };
+  }
+  pthread_mutex_unlock(&task_mutex);
+  if (total_run_time != NULL) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    *total_run_time =
+        (uint32_t)((int64_t)(now.tv_sec - start_time.tv_sec) * 1000000 +
+                   (now.tv_nsec - start_time.tv_nsec) / 1000);
+  }
+  return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  pthread_mutex_t *mutex = malloc(sizeof(pthread_mutex_t));
+  if (mutex != NULL) {
+    pthread_mutex_init(mutex, NULL);
+  }
+  return mutex;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  pthread_mutex_t *mutex = (pthread_mutex_t *)semaphore;
+  if (ticks == portMAX_DELAY) {
+    return (pthread_mutex_lock(mutex) == 0) ? pdTRUE : pdFALSE;
+  }
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  uint64_t ns = (uint64_t)deadline.tv_nsec +
+                (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL;
+  deadline.tv_sec += (time_t)(ns / 1000000000ULL);
+  deadline.tv_nsec = (long)(ns % 1000000000ULL);
+  return (pthread_mutex_timedlock(mutex, &deadline) == 0) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  return (pthread_mutex_unlock((pthread_mutex_t *)semaphore) == 0) ? pdTRUE
+                                                                   : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  pthread_mutex_destroy((pthread_mutex_t *)semaphore);
+  free(semaphore);
+}
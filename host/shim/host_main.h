@@ -0,0 +1,11 @@
+#ifndef HOST_MAIN_H
+#define HOST_MAIN_H
+
+#include <stdbool.h>
+
+// Called by main() before anything else uses the shim.
+void host_shim_init(void);
+// True on the thread that runs appMain().
+bool host_is_app_thread(void);
+
+#endif  // HOST_MAIN_H
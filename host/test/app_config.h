@@ -0,0 +1,10 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* Build options for the host checks of the common modules.  They aren't an
+ * app, so this only has what the modules under test need.
+ */
+
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+
+#endif  // APP_CONFIG_H
@@ -0,0 +1,24 @@
+#include "test_check.h"
+
+#include "deferred_log.h"
+
+int test_failures = 0;
+
+int test_result(void) {
+  if (test_failures != 0) {
+    printf("%d checks failed\n", test_failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
+
+// The modules under test log through the deferred log, which isn't started.
+void dlog_write(uint8_t level, const char *tag, const char *format,
+                const dlog_arg_t *args, size_t arg_count) {
+  (void)level;
+  (void)tag;
+  (void)format;
+  (void)args;
+  (void)arg_count;
+}
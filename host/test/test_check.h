@@ -0,0 +1,45 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+/* A very small test harness for the host checks of the common modules.
+ *
+ * Each test is a function that uses CHECK() and CHECK_EQ().  A failed check
+ * prints where it was and is counted, and the test carries on.  main() runs
+ * the tests with TEST_RUN() and returns test_result(), which ctest takes as
+ * pass or fail.
+ */
+
+#include <stdio.h>
+
+extern int test_failures;
+
+#define CHECK(condition)                                                   \
+  do {                                                                     \
+    if (!(condition)) {                                                    \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      test_failures++;                                                     \
+    }                                                                      \
+  } while (0)
+
+// For integer values, so both are printed on failure.
+#define CHECK_EQ(actual, expected)                                     \
+  do {                                                                 \
+    long long actual_ = (long long)(actual);                           \
+    long long expected_ = (long long)(expected);                       \
+    if (actual_ != expected_) {                                        \
+      printf("%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, \
+             #actual, actual_, expected_);                             \
+      test_failures++;                                                 \
+    }                                                                  \
+  } while (0)
+
+#define TEST_RUN(test)     \
+  do {                     \
+    printf("%s\n", #test); \
+    test();                \
+  } while (0)
+
+// Prints the summary.  Returns the exit status for main().
+int test_result(void);
+
+#endif  // TEST_CHECK_H
@@ -0,0 +1,176 @@
+/* Host checks for common/publish_policy.c. */
+#include <math.h>
+#include <stdbool.h>
+
+#include "publish_policy.h"
+#include "test_check.h"
+
+#define MS (1000LL)
+
+static const publish_policy_config_t plain_config = {
+    .deadband = 0.1f,
+    .relative_deadband = 0,
+    .max_silence_ms = 0,
+    .min_spacing_ms = 0,
+};
+
+static bool check_one(publish_policy_t *policy, float value, int64_t now_us) {
+  return publish_policy_check(policy, &value, now_us);
+}
+
+static void test_first_sample_sent(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &plain_config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 1.0f, 1 * MS));
+  CHECK_EQ(policy.stats.sent, 1);
+  CHECK_EQ(policy.stats.unchanged, 1);
+}
+
+// Changes are measured from the last value sent, so a slow drift is sent.
+static void test_deadband_from_last_sent(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &plain_config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 1.06f, 1 * MS));
+  CHECK(!check_one(&policy, 0.95f, 2 * MS));
+  CHECK(check_one(&policy, 1.12f, 3 * MS));
+  CHECK(!check_one(&policy, 1.06f, 4 * MS));
+  CHECK_EQ(policy.stats.sent, 2);
+  CHECK_EQ(policy.stats.unchanged, 3);
+}
+
+static void test_relative_deadband(void) {
+  const publish_policy_config_t config = {
+      .deadband = 0.01f,
+      .relative_deadband = 0.05f,
+  };
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &config);
+  CHECK(check_one(&policy, 10.0f, 0));
+  // 5% of 10 is bigger than the absolute deadband.
+  CHECK(!check_one(&policy, 10.4f, 1 * MS));
+  CHECK(check_one(&policy, 10.6f, 2 * MS));
+  // Near zero the absolute deadband takes over.
+  CHECK(check_one(&policy, 0.0f, 3 * MS));
+  CHECK(!check_one(&policy, 0.005f, 4 * MS));
+  CHECK(check_one(&policy, 0.02f, 5 * MS));
+}
+
+static void test_nan_transitions(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &plain_config);
+  CHECK(check_one(&policy, NAN, 0));
+  CHECK(!check_one(&policy, NAN, 1 * MS));
+  CHECK(check_one(&policy, 1.0f, 2 * MS));
+  CHECK(check_one(&policy, NAN, 3 * MS));
+  CHECK(!check_one(&policy, NAN, 4 * MS));
+  CHECK_EQ(policy.stats.sent, 3);
+}
+
+static void test_negative_deadband_sends_all(void) {
+  const publish_policy_config_t config = {.deadband = -1};
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &config);
+  for (int i = 0; i < 5; i++) {
+    CHECK(check_one(&policy, 1.0f, i * MS));
+  }
+  CHECK_EQ(policy.stats.sent, 5);
+}
+
+static void test_heartbeat(void) {
+  const publish_policy_config_t config = {
+      .deadband = 0.1f,
+      .max_silence_ms = 100,
+  };
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 1.0f, 99 * MS));
+  CHECK(check_one(&policy, 1.0f, 100 * MS));
+  // The heartbeat restarts the silence.
+  CHECK(!check_one(&policy, 1.0f, 150 * MS));
+  CHECK(check_one(&policy, 1.0f, 200 * MS));
+  CHECK_EQ(policy.stats.sent, 1);
+  CHECK_EQ(policy.stats.heartbeats, 2);
+}
+
+static void test_no_heartbeat(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &plain_config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 1.0f, 1000000 * MS));
+  CHECK_EQ(policy.stats.heartbeats, 0);
+}
+
+// A change that comes too soon is held back and compared again later.
+static void test_min_spacing(void) {
+  const publish_policy_config_t config = {
+      .deadband = 0.1f,
+      .min_spacing_ms = 50,
+  };
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 2.0f, 10 * MS));
+  CHECK(!check_one(&policy, 1.0f, 20 * MS));
+  CHECK_EQ(policy.stats.too_soon, 1);
+  CHECK_EQ(policy.stats.unchanged, 1);
+  CHECK(check_one(&policy, 2.0f, 50 * MS));
+  // Back within the deadband of 2 by the time it may send, so not sent.
+  CHECK(!check_one(&policy, 3.0f, 60 * MS));
+  CHECK(!check_one(&policy, 2.05f, 110 * MS));
+}
+
+// The spacing wins over a heartbeat that is due, and over a negative deadband.
+static void test_min_spacing_beats_heartbeat(void) {
+  const publish_policy_config_t config = {
+      .deadband = -1,
+      .max_silence_ms = 10,
+      .min_spacing_ms = 100,
+  };
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 1, &config);
+  CHECK(check_one(&policy, 1.0f, 0));
+  CHECK(!check_one(&policy, 1.0f, 50 * MS));
+  CHECK(check_one(&policy, 1.0f, 100 * MS));
+  CHECK_EQ(policy.stats.heartbeats, 0);
+  CHECK_EQ(policy.stats.too_soon, 1);
+}
+
+// Any value moving sends the sample, and all the values become the last sent.
+static void test_several_values(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", 3, &plain_config);
+  float values[3] = {1.0f, 2.0f, 3.0f};
+  CHECK(publish_policy_check(&policy, values, 0));
+  values[0] = 1.05f;
+  values[2] = 3.2f;
+  CHECK(publish_policy_check(&policy, values, 1 * MS));
+  values[0] = 1.12f;
+  values[2] = 3.25f;
+  // 1.12 is within 0.1 of the 1.05 sent last time.
+  CHECK(!publish_policy_check(&policy, values, 2 * MS));
+}
+
+static void test_value_count_limit(void) {
+  publish_policy_t policy;
+  publish_policy_init(&policy, "test", PUBLISH_POLICY_MAX_VALUES + 4,
+                      &plain_config);
+  CHECK_EQ(policy.value_count, PUBLISH_POLICY_MAX_VALUES);
+}
+
+int main(void) {
+  TEST_RUN(test_first_sample_sent);
+  TEST_RUN(test_deadband_from_last_sent);
+  TEST_RUN(test_relative_deadband);
+  TEST_RUN(test_nan_transitions);
+  TEST_RUN(test_negative_deadband_sends_all);
+  TEST_RUN(test_heartbeat);
+  TEST_RUN(test_no_heartbeat);
+  TEST_RUN(test_min_spacing);
+  TEST_RUN(test_min_spacing_beats_heartbeat);
+  TEST_RUN(test_several_values);
+  TEST_RUN(test_value_count_limit);
+  return test_result();
+}
@@ -0,0 +1,210 @@
+/* Host checks for common/store_forward.c. */
+#include <stdbool.h>
+#include <string.h>
+
+#include "store_forward.h"
+#include "test_check.h"
+
+#define MAX_SENT (32)
+
+// What the send function was given, and whether it should fail.
+static int sent[MAX_SENT];
+static size_t sent_count;
+static bool send_fails;
+
+static bool send(const void *sample) {
+  if (send_fails || sent_count == MAX_SENT) {
+    return false;
+  }
+  sent[sent_count++] = *(const int *)sample;
+  return true;
+}
+
+static void reset_sent(void) {
+  sent_count = 0;
+  send_fails = false;
+}
+
+// An empty store of 3 ints with `policy`.
+static void init_store(store_forward_t *store, int *buffer,
+                       store_forward_policy_t policy) {
+  memset(store, 0, sizeof(*store));
+  store->name = "test";
+  store->buffer = (uint8_t *)buffer;
+  store->sample_size = sizeof(int);
+  store->capacity = 3;
+  store->policy = policy;
+  store->send = send;
+  reset_sent();
+}
+
+static void submit_all(store_forward_t *store, int first, int last,
+                       bool online) {
+  for (int value = first; value <= last; value++) {
+    store_forward_submit(store, &value, online);
+  }
+}
+
+static void test_online_sends_straight_away(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  int value = 7;
+  CHECK(store_forward_submit(&store, &value, true));
+  CHECK_EQ(sent_count, 1);
+  CHECK_EQ(sent[0], 7);
+  CHECK_EQ(store_forward_count(&store), 0);
+  CHECK_EQ(store.stats.sent, 1);
+  CHECK_EQ(store.stats.stored, 0);
+}
+
+static void test_offline_stores_and_flushes_in_order(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  submit_all(&store, 1, 3, false);
+  CHECK_EQ(sent_count, 0);
+  CHECK_EQ(store_forward_count(&store), 3);
+  CHECK_EQ(store_forward_flush(&store, 8), 3);
+  CHECK_EQ(sent_count, 3);
+  CHECK_EQ(sent[0], 1);
+  CHECK_EQ(sent[1], 2);
+  CHECK_EQ(sent[2], 3);
+  CHECK_EQ(store.stats.stored, 3);
+  CHECK_EQ(store.stats.flushed, 3);
+}
+
+// A new sample must not overtake the ones still queued.
+static void test_online_with_backlog_queues(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  submit_all(&store, 1, 1, false);
+  int value = 2;
+  CHECK(!store_forward_submit(&store, &value, true));
+  CHECK_EQ(sent_count, 0);
+  CHECK_EQ(store_forward_flush(&store, 8), 2);
+  CHECK_EQ(sent[0], 1);
+  CHECK_EQ(sent[1], 2);
+}
+
+static void test_failed_send_is_kept(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  send_fails = true;
+  int value = 5;
+  CHECK(!store_forward_submit(&store, &value, true));
+  CHECK_EQ(store_forward_count(&store), 1);
+  // A flush stops at the first failure and keeps the sample.
+  CHECK_EQ(store_forward_flush(&store, 8), 0);
+  CHECK_EQ(store_forward_count(&store), 1);
+  send_fails = false;
+  CHECK_EQ(store_forward_flush(&store, 8), 1);
+  CHECK_EQ(sent[0], 5);
+  CHECK_EQ(store.stats.sent, 0);
+  CHECK_EQ(store.stats.flushed, 1);
+}
+
+static void test_flush_batch_limit(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  submit_all(&store, 1, 3, false);
+  CHECK_EQ(store_forward_flush(&store, 2), 2);
+  CHECK_EQ(store_forward_count(&store), 1);
+  CHECK_EQ(store_forward_flush(&store, 2), 1);
+  CHECK_EQ(sent_count, 3);
+  CHECK_EQ(sent[2], 3);
+  CHECK_EQ(store_forward_flush(&store, 2), 0);
+}
+
+static void test_overwrite_drops_oldest(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  submit_all(&store, 1, 5, false);
+  CHECK_EQ(store_forward_count(&store), 3);
+  CHECK_EQ(store.stats.dropped, 2);
+  CHECK_EQ(store_forward_flush(&store, 8), 3);
+  CHECK_EQ(sent[0], 3);
+  CHECK_EQ(sent[1], 4);
+  CHECK_EQ(sent[2], 5);
+}
+
+// Move the head round the buffer more than once, with partial flushes.
+static void test_overwrite_head_wraps(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_OVERWRITE);
+  submit_all(&store, 1, 3, false);
+  CHECK_EQ(store_forward_flush(&store, 2), 2);
+  submit_all(&store, 4, 7, false);
+  // 3 and 4 were overwritten.
+  CHECK_EQ(store.stats.dropped, 2);
+  CHECK_EQ(store_forward_flush(&store, 1), 1);
+  submit_all(&store, 8, 8, false);
+  reset_sent();
+  CHECK_EQ(store_forward_flush(&store, 8), 3);
+  CHECK_EQ(sent[0], 6);
+  CHECK_EQ(sent[1], 7);
+  CHECK_EQ(sent[2], 8);
+  CHECK(store.head < store.capacity);
+}
+
+static void test_coalesce_keeps_newest(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_COALESCE);
+  submit_all(&store, 1, 5, false);
+  CHECK_EQ(store_forward_count(&store), 1);
+  CHECK_EQ(store.stats.stored, 1);
+  CHECK_EQ(store.stats.coalesced, 4);
+  CHECK_EQ(store.stats.dropped, 0);
+  CHECK_EQ(store_forward_flush(&store, 8), 1);
+  CHECK_EQ(sent[0], 5);
+}
+
+// Unlike overwrite, coalescing never drops a sample to make room.
+static void test_coalesce_at_capacity_one(void) {
+  int buffer[1];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_COALESCE);
+  store.capacity = 1;
+  submit_all(&store, 1, 3, false);
+  CHECK_EQ(store_forward_count(&store), 1);
+  CHECK_EQ(store.stats.dropped, 0);
+  CHECK_EQ(store_forward_flush(&store, 8), 1);
+  CHECK_EQ(sent[0], 3);
+  // Empty again, so the next one goes straight out.
+  int value = 4;
+  CHECK(store_forward_submit(&store, &value, true));
+  CHECK_EQ(sent[1], 4);
+}
+
+static void test_drop_newest_keeps_oldest(void) {
+  int buffer[3];
+  store_forward_t store;
+  init_store(&store, buffer, STORE_FORWARD_DROP_NEWEST);
+  submit_all(&store, 1, 5, false);
+  CHECK_EQ(store_forward_count(&store), 3);
+  CHECK_EQ(store.stats.dropped, 2);
+  CHECK_EQ(store_forward_flush(&store, 8), 3);
+  CHECK_EQ(sent[0], 1);
+  CHECK_EQ(sent[1], 2);
+  CHECK_EQ(sent[2], 3);
+}
+
+int main(void) {
+  TEST_RUN(test_online_sends_straight_away);
+  TEST_RUN(test_offline_stores_and_flushes_in_order);
+  TEST_RUN(test_online_with_backlog_queues);
+  TEST_RUN(test_failed_send_is_kept);
+  TEST_RUN(test_flush_batch_limit);
+  TEST_RUN(test_overwrite_drops_oldest);
+  TEST_RUN(test_overwrite_head_wraps);
+  TEST_RUN(test_coalesce_keeps_newest);
+  TEST_RUN(test_coalesce_at_capacity_one);
+  TEST_RUN(test_drop_newest_keeps_oldest);
+  return test_result();
+}
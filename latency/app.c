@@ -0,0 +1,349 @@
+#include <rcl/error_handling.h>
+#include <rcl/rcl.h>
+#include <rclc/executor.h>
+#include <rclc/rclc.h>
+#include <rcutils/error_handling.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "app_config.h"
+#include "app_entities.h"
+#include "app_spin.h"
+#include "app_time.h"
+#include "bench_report.h"
+#include "deferred_log.h"
+#include "entity_registry.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "histogram.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "static_allocator.h"
+#include "std_msgs/msg/u_int8_multi_array.h"
+
+#define RCCHECK(fn)                                                 \
+  {                                                                 \
+    rcl_ret_t temp_rc = fn;                                         \
+    if ((temp_rc != RCL_RET_OK)) {                                  \
+      printf("Failed status on line %d: %d. Aborting.\n", __LINE__, \
+             (int)temp_rc);                                         \
+      vTaskDelete(NULL);                                            \
+    }                                                               \
+  }
+#define RCSOFTCHECK(fn)                                               \
+  {                                                                   \
+    rcl_ret_t temp_rc = fn;                                           \
+    if ((temp_rc != RCL_RET_OK)) {                                    \
+      printf("Failed status on line %d: %d. Continuing.\n", __LINE__, \
+             (int)temp_rc);                                           \
+    }                                                                 \
+  }
+
+// Pings, pongs and timers are listed in app_entities.h.
+ENTITY_REGISTRY_DEFINE(entities)
+
+// Logging name.
+static const char *TAG = "latency";
+
+/* Ping payload header.  The rest of the payload is padding.  The echo node
+ * sends the bytes back unchanged, so only this app needs to understand them.
+ */
+typedef struct {
+  uint32_t point;
+  uint32_t seq;
+  int64_t sent_us;
+} ping_header_t;
+_Static_assert(sizeof(ping_header_t) == 16, "Header must not be padded");
+
+// Point number used for the pings sent while waiting for the echo node.
+#define WAIT_POINT (UINT32_MAX)
+
+static const uint32_t k_sizes[] = LATENCY_SIZES;
+static const uint32_t k_rates_hz[] = LATENCY_RATES_HZ;
+#define SIZE_COUNT (sizeof(k_sizes) / sizeof(k_sizes[0]))
+#define RATE_COUNT (sizeof(k_rates_hz) / sizeof(k_rates_hz[0]))
+// Reliable points then best effort points.
+#define POINT_COUNT (2 * SIZE_COUNT * RATE_COUNT)
+
+typedef enum {
+  STATE_WAIT_FOR_ECHO,
+  STATE_SENDING,
+  STATE_DRAINING,
+  STATE_DONE,
+} state_t;
+
+// One point of the sweep.
+typedef struct {
+  bool best_effort;
+  uint32_t size;
+  uint32_t rate_hz;
+} point_t;
+
+static state_t state = STATE_WAIT_FOR_ECHO;
+static uint32_t point_index = 0;
+static point_t point;
+static uint32_t pings_to_send = 0;
+static int64_t drain_end_us = 0;
+
+// Results for the current point.
+static histogram_t rtt_histogram;
+static uint32_t sent = 0;
+static uint32_t received = 0;
+static uint32_t late = 0;
+static uint32_t publish_failures = 0;
+static uint32_t last_rtt_us = 0;
+static uint64_t jitter_sum_us = 0;
+static uint32_t jitter_count = 0;
+
+static std_msgs__msg__UInt8MultiArray ping_msg;
+
+static bool get_point(uint32_t index, point_t *p) {
+  if (index >= POINT_COUNT) {
+    return false;
+  }
+  p->best_effort = index >= POINT_COUNT / 2;
+  index %= POINT_COUNT / 2;
+  p->size = k_sizes[index / RATE_COUNT];
+  p->rate_hz = k_rates_hz[index % RATE_COUNT];
+  return true;
+}
+
+static void set_ping_period(int64_t period_ns) {
+  int64_t old_period;
+  RCSOFTCHECK(rcl_timer_exchange_period(&timer_ping, period_ns, &old_period));
+  RCSOFTCHECK(rcl_timer_reset(&timer_ping));
+}
+
+static void reset_results(void) {
+  histogram_reset(&rtt_histogram);
+  sent = 0;
+  received = 0;
+  late = 0;
+  publish_failures = 0;
+  last_rtt_us = 0;
+  jitter_sum_us = 0;
+  jitter_count = 0;
+}
+
+// Why the point can't be run, or NULL if it can.
+static const char *skip_reason(const point_t *p) {
+  if (p->size < sizeof(ping_header_t)) {
+    return "smaller than the ping header";
+  }
+  if (p->size > LATENCY_MAX_SIZE) {
+    return "larger than LATENCY_MAX_SIZE";
+  }
+  if (p->best_effort && p->size > LATENCY_BEST_EFFORT_MAX_SIZE) {
+    return "larger than LATENCY_BEST_EFFORT_MAX_SIZE";
+  }
+  if (p->rate_hz == 0) {
+    return "a rate of 0";
+  }
+  return NULL;
+}
+
+// Move on to the next point of the sweep that can be run.
+static void start_next_point(void) {
+  while (get_point(point_index, &point)) {
+    const char *reason = skip_reason(&point);
+    if (reason == NULL) {
+      break;
+    }
+    ESP_LOGW(TAG, "Skipping %s point of %u bytes at %u Hz: %s",
+             point.best_effort ? "best effort" : "reliable",
+             (unsigned int)point.size, (unsigned int)point.rate_hz, reason);
+    point_index++;
+  }
+  if (point_index >= POINT_COUNT) {
+    state = STATE_DONE;
+    return;
+  }
+  reset_results();
+  pings_to_send = point.rate_hz * LATENCY_POINT_DURATION_S * LATENCY_BURST;
+  ping_msg.data.size = point.size;
+  state = STATE_SENDING;
+  ESP_LOGI(TAG, "Point %u: %s, %u bytes, %u Hz", (unsigned int)point_index,
+           point.best_effort ? "best effort" : "reliable",
+           (unsigned int)point.size, (unsigned int)point.rate_hz);
+  set_ping_period(RCL_S_TO_NS(1) / point.rate_hz);
+}
+
+static void report_point(void) {
+  uint32_t lost = sent - received;
+  bench_report(
+      "{\"app\":\"latency\",\"qos\":\"%s\",\"size\":%u,\"rate_hz\":%u,"
+      "\"burst\":%u,\"duration_s\":%u,\"sent\":%u,\"received\":%u,"
+      "\"lost\":%u,\"late\":%u,"
+      "\"publish_failures\":%u,\"min_us\":%u,\"mean_us\":%u,\"p50_us\":%u,"
+      "\"p99_us\":%u,\"p999_us\":%u,\"max_us\":%u,\"jitter_us\":%u}",
+      point.best_effort ? "best_effort" : "reliable",
+      (unsigned int)point.size, (unsigned int)point.rate_hz,
+      (unsigned int)LATENCY_BURST, (unsigned int)LATENCY_POINT_DURATION_S,
+      (unsigned int)sent, (unsigned int)received, (unsigned int)lost,
+      (unsigned int)late, (unsigned int)publish_failures,
+      (unsigned int)(received ? rtt_histogram.min : 0),
+      (unsigned int)histogram_mean(&rtt_histogram),
+      (unsigned int)histogram_percentile(&rtt_histogram, 50.0),
+      (unsigned int)histogram_percentile(&rtt_histogram, 99.0),
+      (unsigned int)histogram_percentile(&rtt_histogram, 99.9),
+      (unsigned int)rtt_histogram.max,
+      (unsigned int)(jitter_count ? jitter_sum_us / jitter_count : 0));
+}
+
+static void send_ping(uint32_t point_number, bool best_effort) {
+  ping_header_t header = {
+      .point = point_number,
+      .seq = sent,
+      .sent_us = app_time_us(),
+  };
+  memcpy(ping_msg.data.data, &header, sizeof(header));
+  rcl_publisher_t *publisher =
+      best_effort ? &publisher_ping_best_effort : &publisher_ping_reliable;
+  if (rcl_publish(publisher, &ping_msg, NULL) != RCL_RET_OK) {
+    publish_failures++;
+  }
+  sent++;
+  app_spin_published();
+}
+
+static void timer_callback(rcl_timer_t *timer, int64_t last_call_time) {
+  if (timer == NULL) {
+    return;
+  }
+  switch (state) {
+    case STATE_WAIT_FOR_ECHO:
+      ping_msg.data.size = sizeof(ping_header_t);
+      send_ping(WAIT_POINT, false);
+      break;
+    case STATE_SENDING:
+      for (int i = 0; i < LATENCY_BURST && sent < pings_to_send; i++) {
+        send_ping(point_index, point.best_effort);
+      }
+      if (sent >= pings_to_send) {
+        drain_end_us = app_time_us() + (int64_t)LATENCY_DRAIN_MS * 1000;
+        state = STATE_DRAINING;
+      }
+      break;
+    case STATE_DRAINING:
+      if (app_time_us() >= drain_end_us) {
+        report_point();
+        point_index++;
+        start_next_point();
+        if (state == STATE_DONE) {
+          ESP_LOGI(TAG, "Sweep complete");
+#ifndef ESP_PLATFORM
+          // Lets a script run the sweep and then read BENCH_OUTPUT.
+          exit(EXIT_SUCCESS);
+#else
+          set_ping_period(RCL_S_TO_NS(1));
+#endif
+        }
+      }
+      break;
+    case STATE_DONE:
+      break;
+  }
+}
+
+// Shared by both pong subscriptions.
+static void subscription_callback_pong(const void *msg_in) {
+  int64_t now_us = app_time_us();
+  const std_msgs__msg__UInt8MultiArray *msg =
+      (const std_msgs__msg__UInt8MultiArray *)msg_in;
+  if (msg->data.size < sizeof(ping_header_t)) {
+    return;
+  }
+  ping_header_t header;
+  memcpy(&header, msg->data.data, sizeof(header));
+  if (state == STATE_WAIT_FOR_ECHO) {
+    if (header.point == WAIT_POINT) {
+      ESP_LOGI(TAG, "Echo node found, starting sweep");
+      point_index = 0;
+      start_next_point();
+    }
+    return;
+  }
+  if (header.point != point_index ||
+      (state != STATE_SENDING && state != STATE_DRAINING)) {
+    // Arrived after its point was reported.
+    late++;
+    return;
+  }
+  int64_t rtt_us = now_us - header.sent_us;
+  if (rtt_us < 0) {
+    rtt_us = 0;
+  }
+  histogram_record(&rtt_histogram, (uint32_t)rtt_us);
+  // Jitter is the mean difference between consecutive round trip times.
+  if (received > 0) {
+    jitter_sum_us += (rtt_us > last_rtt_us) ? rtt_us - last_rtt_us
+                                            : last_rtt_us - rtt_us;
+    jitter_count++;
+  }
+  last_rtt_us = (uint32_t)rtt_us;
+  received++;
+  DLOG_D(TAG, "pong %u rtt %d us", header.seq, (int32_t)rtt_us);
+}
+
+static void create_messages(void) {
+  std_msgs__msg__UInt8MultiArray__init(&ping_msg);
+  rosidl_runtime_c__uint8__Sequence__init(&ping_msg.data, LATENCY_MAX_SIZE);
+  memset(ping_msg.data.data, 0, LATENCY_MAX_SIZE);
+  // The pong buffers need room for the largest message before they are used.
+  rosidl_runtime_c__uint8__Sequence__init(&subscriber_msg_pong_reliable.data,
+                                          LATENCY_MAX_SIZE);
+  rosidl_runtime_c__uint8__Sequence__init(
+      &subscriber_msg_pong_best_effort.data, LATENCY_MAX_SIZE);
+}
+
+static void destroy_messages(void) {
+  std_msgs__msg__UInt8MultiArray__fini(&ping_msg);
+  std_msgs__msg__UInt8MultiArray__fini(&subscriber_msg_pong_reliable);
+  std_msgs__msg__UInt8MultiArray__fini(&subscriber_msg_pong_best_effort);
+}
+
+void appMain(void *arg) {
+  // Start the deferred logging task first so that it is ready for the
+  // callbacks.
+  dlog_init();
+
+  // The arena allocator, if APP_ALLOCATOR is APP_ALLOCATOR_STATIC.
+  rcl_allocator_t allocator = static_allocator_init();
+  rclc_support_t support;
+
+  // Create messages.
+  create_messages();
+
+  // Create init_options.
+  RCCHECK(rclc_support_init(&support, 0, NULL, &allocator));
+
+  // Create node.
+  rcl_node_t node = rcl_get_zero_initialized_node();
+  RCCHECK(rclc_node_init_default(&node, TAG, "", &support));
+
+  // Create publishers, subscribers and timers.
+  ESP_LOGI(TAG, "Creating entities");
+  RCCHECK(entity_registry_init(&entities, &node, &support));
+
+  // Create executor.
+  ESP_LOGI(TAG, "Creating executor");
+  rclc_executor_t executor = rclc_executor_get_zero_initialized_executor();
+  RCCHECK(rclc_executor_init(&executor, &support.context,
+                             APP_EXECUTOR_HANDLE_COUNT, &allocator));
+  RCCHECK(entity_registry_add_to_executor(&entities, &executor));
+
+  // Spin until the sweep is done.
+  ESP_LOGI(TAG, "Waiting for tools/pingpong_echo.py...");
+  app_spin(&executor, &entities);
+
+  // Free resources.  Probably never called on the ESP32.
+  ESP_LOGI(TAG, "Free resources");
+  RCCHECK(entity_registry_fini(&entities, &node))
+  RCCHECK(rcl_node_fini(&node))
+  destroy_messages();
+
+  vTaskDelete(NULL);
+}
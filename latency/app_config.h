@@ -0,0 +1,75 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* Build options for the latency benchmark app.
+ * Options that change app_entities.h change app-colcon.meta, so run
+ * tools/gen_colcon_meta.bash and do a full rebuild after changing them.
+ * The sweep and transport options can be overridden with -D, which
+ * tools/tuning_matrix.bash does.
+ */
+
+// The sweep.  Every size is run at every rate, first on the reliable topics
+// and then on the best effort topics.
+// Payload sizes in bytes.  Must be at least 16 (the ping header).
+#ifndef LATENCY_SIZES
+#define LATENCY_SIZES {16, 256, 1024}
+#endif
+// Ping rates in Hz.
+#ifndef LATENCY_RATES_HZ
+#define LATENCY_RATES_HZ {10, 50, 100}
+#endif
+// Pings sent back to back at each tick of the rate, e.g. 6 to look like a
+// burst of range messages.
+#ifndef LATENCY_BURST
+#define LATENCY_BURST (1)
+#endif
+// How long to send pings for at each point of the sweep.
+#ifndef LATENCY_POINT_DURATION_S
+#define LATENCY_POINT_DURATION_S (10)
+#endif
+// Time to wait for late pongs after the last ping of a point.  Pongs that
+// arrive after this are counted as lost.
+#define LATENCY_DRAIN_MS (1000)
+
+// Largest size in LATENCY_SIZES.  Sets the size of the message buffers.
+#ifndef LATENCY_MAX_SIZE
+#define LATENCY_MAX_SIZE (1024)
+#endif
+// Best effort streams can't fragment, so a message has to fit in one
+// transport MTU (APP_TRANSPORT_MTU) with the headers.  Larger sizes are
+// skipped.
+#ifndef LATENCY_BEST_EFFORT_MAX_SIZE
+#define LATENCY_BEST_EFFORT_MAX_SIZE (APP_TRANSPORT_MTU - 112)
+#endif
+
+// Period of the ping timer while waiting for the echo node to start.
+#define LATENCY_WAIT_PERIOD_MS (100)
+
+// The reliable stream needs a history of 3 to fragment LATENCY_MAX_SIZE bytes.
+#ifndef APP_RMW_MAX_HISTORY
+#define APP_RMW_MAX_HISTORY (4)
+#endif
+
+// Time every executor callback and publish the histograms on
+// diagnostics/executor_profile.  See common/executor_profile.h.
+#ifndef APP_EXECUTOR_PROFILE
+#define APP_EXECUTOR_PROFILE (0)
+#endif
+
+// Publish the tasks' CPU and stack, the heap and the static arena use on
+// diagnostics/resources.  See common/resource_diag.h.
+#ifndef APP_RESOURCE_DIAG
+#define APP_RESOURCE_DIAG (0)
+#endif
+
+// Spin loop.  SPIN_MODE_EVENT or SPIN_MODE_POLL.  See common/app_spin.h.
+#define APP_SPIN_MODE SPIN_MODE_EVENT
+
+// rcl allocator.  APP_ALLOCATOR_STATIC or APP_ALLOCATOR_DEFAULT.  See
+// common/static_allocator.h.
+#define APP_ALLOCATOR APP_ALLOCATOR_STATIC
+
+// Deferred logging level for the hot paths.  See common/deferred_log.h.
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+
+#endif  // APP_CONFIG_H
@@ -0,0 +1,40 @@
+#ifndef APP_ENTITIES_H
+#define APP_ENTITIES_H
+
+/* Entities used by the latency benchmark app.  See common/entity_table.h.
+ * ********** IMPORTANT: Run tools/gen_colcon_meta.bash after changing this
+ * file to update app-colcon.meta.  *********
+ *
+ * tools/pingpong_echo.py sends each ping back on the matching pong topic
+ * with the same QoS.
+ */
+
+#include "app_config.h"
+#include "entity_table.h"
+
+#define APP_PUBLISHERS(PUBLISHER)                               \
+  PUBLISHER(ping_reliable, std_msgs, UInt8MultiArray,           \
+            "latency/ping_reliable", ENTITY_QOS_RELIABLE)       \
+  PUBLISHER(ping_best_effort, std_msgs, UInt8MultiArray,        \
+            "latency/ping_best_effort", ENTITY_QOS_BEST_EFFORT) \
+  ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                          \
+  ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+
+#define APP_SUBSCRIPTIONS(SUBSCRIPTION)                            \
+  SUBSCRIPTION(pong_reliable, std_msgs, UInt8MultiArray,           \
+               "latency/pong_reliable", ENTITY_QOS_RELIABLE,       \
+               subscription_callback_pong)                         \
+  SUBSCRIPTION(pong_best_effort, std_msgs, UInt8MultiArray,        \
+               "latency/pong_best_effort", ENTITY_QOS_BEST_EFFORT, \
+               subscription_callback_pong)
+
+#define APP_CLIENTS(CLIENT)
+
+#define APP_SERVICES(SERVICE)
+
+#define APP_TIMERS(TIMER)                             \
+  TIMER(ping, LATENCY_WAIT_PERIOD_MS, timer_callback) \
+  ENTITY_PROFILE_TIMERS(TIMER)                        \
+  ENTITY_DIAG_TIMERS(TIMER)
+
+#endif  // APP_ENTITIES_H
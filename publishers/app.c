@@ -1,3 +1,4 @@
+#include <math.h>
 #include <rcl/error_handling.h>
 #include <rcl/rcl.h>
 #include <rclc/executor.h>
@@ -7,23 +8,28 @@
 #include <stdio.h>
 #include <unistd.h>
 
-#ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#endif
 
+#include "app_config.h"
+#include "app_entities.h"
+#include "app_spin.h"
+#include "app_time.h"
+#include "connection_manager.h"
+#include "deferred_log.h"
+#include "entity_registry.h"
 #include "esp_log.h"
+#include "msg_template.h"
+#include "publish_policy.h"
+#include "publish_stats.h"
+#include "range_acquisition.h"
+#include "rosidl_runtime_c/primitives_sequence_functions.h"
+#include "sensor_msgs/msg/laser_scan.h"
 #include "sensor_msgs/msg/range.h"
+#include "static_allocator.h"
+#include "store_forward.h"
+#include "time_sync.h"
 
-#define RCCHECK(fn)                                                 \
-  {                                                                 \
-    rcl_ret_t temp_rc = fn;                                         \
-    if ((temp_rc != RCL_RET_OK)) {                                  \
-      printf("Failed status on line %d: %d. Aborting.\n", __LINE__, \
-             (int)temp_rc);                                         \
-      vTaskDelete(NULL);                                            \
-    }                                                               \
-  }
 #define RCSOFTCHECK(fn)                                               \
   {                                                                   \
     rcl_ret_t temp_rc = fn;                                           \
@@ -33,175 +39,292 @@
     }                                                                 \
   }
 
-// Tick definitions.
-#define TICK_RATE_HZ (10)
-#define MS_PER_TICK (1000 / TICK_RATE_HZ)
-#define US_PER_TICK (MS_PER_TICK * 1000)
-
-// Number of executor handles: 1 timer, 0 subscribers, 0 services.
-// Publishers don't count as they are driven by the timer.
-// NOTE: UPDATE app-colcon.meta IF YOU CHANGE THIS VALUE!
-#define EXECUTOR_HANDLE_COUNT (1)
-
-rcl_publisher_t publisher_range_1;
-rcl_publisher_t publisher_range_2;
-rcl_publisher_t publisher_range_3;
-rcl_publisher_t publisher_range_4;
-rcl_publisher_t publisher_range_5;
-rcl_publisher_t publisher_range_6;
+// Publishers, timers and callbacks are listed in app_entities.h.
+ENTITY_REGISTRY_DEFINE(entities)
 
 // Logging name.
 static const char *TAG = "test";
-// Standard topic/service names.
-static const char *k_range_1 = "sensors/tof1";
-static const char *k_range_2 = "sensors/tof2";
-static const char *k_range_3 = "sensors/tof3";
-static const char *k_range_4 = "sensors/tof4";
-static const char *k_range_5 = "sensors/tof5";
-static const char *k_range_6 = "sensors/tof6";
-
-// Messages to publish.  Be lazy and use the same message for all range sensors.
-static sensor_msgs__msg__Range *range_msg = NULL;
-
-static void publish_range_1(void) {
-  // ToF so say infrared.
-  range_msg->radiation_type = sensor_msgs__msg__Range__INFRARED;
-  range_msg->field_of_view = 0.1;
-  range_msg->min_range = 0.1;
-  range_msg->max_range = 4.0;
-  range_msg->range = 1.1;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_1, range_msg, NULL);
-  RCLC_UNUSED(rc);
+
+// Per-message logging floods the deferred log at stress rates.
+#define LOG_EACH_PUBLISH (STRESS_RATE_HZ == 0)
+
+// One reading from each ToF sensor.  Kept in range_store until it is sent.
+typedef struct {
+  float ranges[RANGE_SENSOR_COUNT];
+  int64_t times_us[RANGE_SENSOR_COUNT];  // When each reading was taken.
+  uint32_t due_mask;  // Readings the publish policy passed.  Bit 0 is ToF 1.
+} range_sample_t;
+
+static const publish_policy_config_t range_policy_config = {
+    .deadband = RANGE_DEADBAND_M,
+    .relative_deadband = RANGE_DEADBAND_RELATIVE,
+    .max_silence_ms = RANGE_MAX_SILENCE_MS,
+    .min_spacing_ms = RANGE_MIN_SPACING_MS,
+};
+
+#if PUBLISH_MODE == PUBLISH_MODE_BATCHED
+// Message to publish.  One scan "ray" per ToF sensor.
+static sensor_msgs__msg__LaserScan range_batch_msg;
+// range_batch_msg serialised once.  Only the ranges and stamp are patched.
+static msg_template_t range_template;
+
+static bool create_messages(void) {
+  if (!sensor_msgs__msg__LaserScan__init(&range_batch_msg)) {
+    return false;
+  }
+  // ToF so the "angles" are just the sensor indices.
+  range_batch_msg.angle_min = 0.0;
+  range_batch_msg.angle_max = RANGE_SENSOR_COUNT - 1;
+  range_batch_msg.angle_increment = 1.0;
+  range_batch_msg.range_min = 0.1;
+  range_batch_msg.range_max = 4.0;
+  if (!rosidl_runtime_c__float__Sequence__init(&range_batch_msg.ranges,
+                                               RANGE_SENSOR_COUNT)) {
+    return false;
+  }
+  msg_template_init(&range_template, "range_batch",
+                    ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, LaserScan),
+                    &range_batch_msg);
+  msg_template_add_field(&range_template, range_batch_msg.ranges.data,
+                         RANGE_SENSOR_COUNT * sizeof(float));
+  msg_template_add_field(&range_template, &range_batch_msg.header.stamp,
+                         sizeof(range_batch_msg.header.stamp));
+  return true;
 }
 
-static void publish_range_2(void) {
-  range_msg->range = 1.2;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_2, range_msg, NULL);
-  RCLC_UNUSED(rc);
+static void destroy_messages(void) {
+  sensor_msgs__msg__LaserScan__fini(&range_batch_msg);
 }
 
-static void publish_range_3(void) {
-  range_msg->range = 1.3;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_3, range_msg, NULL);
-  RCLC_UNUSED(rc);
+static bool publish_ranges(const void *sample_in) {
+  const range_sample_t *sample = (const range_sample_t *)sample_in;
+  // The shared stamp is the oldest reading, so the age is never understated.
+  int64_t oldest_us = sample->times_us[0];
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    range_batch_msg.ranges.data[i] = sample->ranges[i];
+    if (sample->times_us[i] < oldest_us) {
+      oldest_us = sample->times_us[i];
+    }
+  }
+  time_sync_stamp(&range_batch_msg.header.stamp, oldest_us);
+  if (LOG_EACH_PUBLISH) {
+    DLOG_I(TAG, "Sending %u ranges", (unsigned int)RANGE_SENSOR_COUNT);
+  }
+  rcl_ret_t rc =
+      publish_stats_publish_template(&publisher_range_batch, &range_template);
+  app_spin_published();
+  return rc == RCL_RET_OK;
 }
 
-static void publish_range_4(void) {
-  range_msg->range = 1.4;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_4, range_msg, NULL);
-  RCLC_UNUSED(rc);
+// One policy for the whole scan.
+#define RANGE_POLICY_COUNT (1)
+_Static_assert(RANGE_SENSOR_COUNT <= PUBLISH_POLICY_MAX_VALUES,
+               "Too many ranges for one publish policy");
+
+// Messages sent per timer tick.
+#define MESSAGES_PER_TICK (1)
+// Where the template benchmark sends its messages.
+#define BENCHMARK_PUBLISHER (&publisher_range_batch)
+#else
+// The diagnostics publishers, if any, come after the range publishers.
+_Static_assert(APP_PUBLISHER_COUNT - ENTITY_COUNT(ENTITY_PROFILE_PUBLISHERS) -
+                       ENTITY_COUNT(ENTITY_DIAG_PUBLISHERS) ==
+                   RANGE_SENSOR_COUNT,
+               "Need one publisher per range sensor");
+
+// Message to publish.  Be lazy and use the same message for all range sensors.
+static sensor_msgs__msg__Range range_msg;
+// range_msg serialised once.  Only the range and stamp are patched.
+static msg_template_t range_template;
+
+static bool create_messages(void) {
+  if (!sensor_msgs__msg__Range__init(&range_msg)) {
+    return false;
+  }
+  // ToF so say infrared.
+  range_msg.radiation_type = sensor_msgs__msg__Range__INFRARED;
+  range_msg.field_of_view = 0.1;
+  range_msg.min_range = 0.1;
+  range_msg.max_range = 4.0;
+  msg_template_init(&range_template, "range",
+                    ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
+                    &range_msg);
+  msg_template_add_field(&range_template, &range_msg.range,
+                         sizeof(range_msg.range));
+  msg_template_add_field(&range_template, &range_msg.header.stamp,
+                         sizeof(range_msg.header.stamp));
+  return true;
 }
 
-static void publish_range_5(void) {
-  range_msg->range = 1.5;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_5, range_msg, NULL);
-  RCLC_UNUSED(rc);
+static void destroy_messages(void) {
+  sensor_msgs__msg__Range__fini(&range_msg);
 }
 
-static void publish_range_6(void) {
-  range_msg->range = 1.6;
-  ESP_LOGI(TAG, "Sending range: %f", range_msg->range);
-  rcl_ret_t rc = rcl_publish(&publisher_range_6, range_msg, NULL);
-  RCLC_UNUSED(rc);
+/* The sample counts as sent if any of its ranges were published.  Sending it
+ * again would repeat the ones that did go.  Only the readings that the publish
+ * policies passed are sent.
+ */
+static bool publish_ranges(const void *sample_in) {
+  const range_sample_t *sample = (const range_sample_t *)sample_in;
+  bool sent = false;
+  // The range publishers are in sensor order.
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    if ((sample->due_mask & (1u << i)) == 0) {
+      continue;
+    }
+    range_msg.range = sample->ranges[i];
+    time_sync_stamp(&range_msg.header.stamp, sample->times_us[i]);
+    if (LOG_EACH_PUBLISH) {
+      DLOG_I(TAG, "Sending range: %f", range_msg.range);
+    }
+    if (publish_stats_publish_template(entities.publishers[i].handle,
+                                       &range_template) == RCL_RET_OK) {
+      sent = true;
+    }
+    app_spin_published();
+  }
+  return sent;
 }
 
+// One policy per sensor.
+#define RANGE_POLICY_COUNT (RANGE_SENSOR_COUNT)
+
+// Messages sent per timer tick.
+#define MESSAGES_PER_TICK (RANGE_SENSOR_COUNT)
+// Where the template benchmark sends its messages.
+#define BENCHMARK_PUBLISHER (entities.publishers[0].handle)
+#endif
+
+// Samples taken while the agent can't be reached.  See common/store_forward.h.
+STORE_FORWARD_DEFINE(range_store, range_sample_t, RANGE_STORE_CAPACITY,
+                     STORE_FORWARD_OVERWRITE, publish_ranges)
+static store_forward_t *const stores[] = {&range_store};
+
+static publish_policy_t range_policies[RANGE_POLICY_COUNT];
+
+// Named after the topics.  The range publishers are in sensor order.
+static void create_policies(void) {
+  for (size_t i = 0; i < RANGE_POLICY_COUNT; i++) {
+    publish_policy_init(&range_policies[i], entities.publishers[i].topic,
+                        RANGE_SENSOR_COUNT / RANGE_POLICY_COUNT,
+                        &range_policy_config);
+  }
+}
+
+// Set the sample's due mask.  Returns false if no reading is due.
+static bool check_policies(range_sample_t *sample, int64_t now_us) {
+#if RANGE_POLICY_COUNT == 1
+  bool due = publish_policy_check(&range_policies[0], sample->ranges, now_us);
+  sample->due_mask = due ? (1u << RANGE_SENSOR_COUNT) - 1 : 0;
+#else
+  sample->due_mask = 0;
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    if (publish_policy_check(&range_policies[i], &sample->ranges[i],
+                             now_us)) {
+      sample->due_mask |= 1u << i;
+    }
+  }
+#endif
+  return sample->due_mask != 0;
+}
+
+/* Also called by the connection manager while offline, with a NULL timer.  The
+ * sample still goes into the store.
+ */
 static void timer_callback(rcl_timer_t *timer, int64_t last_call_time) {
-  ESP_LOGI(TAG, "Timer called.");
-  if (timer != NULL) {
-    publish_range_1();
-    publish_range_2();
-    publish_range_3();
-    publish_range_4();
-    publish_range_5();
-    publish_range_6();
+  if (LOG_EACH_PUBLISH) {
+    DLOG_I(TAG, "Timer called.");
   }
+  // The newest reading from each sensor.  A sensor with no new reading keeps
+  // its last one, with its old stamp.  NaN until the first reading.
+  static range_sample_t sample;
+  static bool sample_started = false;
+  if (!sample_started) {
+    sample_started = true;
+    for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+      sample.ranges[i] = NAN;
+      sample.times_us[i] = app_time_us();
+    }
+  }
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    range_reading_t reading;
+    if (range_acquisition_latest(i, &reading)) {
+      sample.ranges[i] = reading.range_m;
+      sample.times_us[i] = reading.time_us;
+    }
+  }
+  if (check_policies(&sample, app_time_us())) {
+    store_forward_submit(&range_store, &sample, connection_manager_connected());
+  }
+  publish_stats_report();
+  publish_policy_report(range_policies, RANGE_POLICY_COUNT);
+  range_acquisition_report();
 }
 
-void appMain(void *arg) {
-  rcl_allocator_t allocator = rcl_get_default_allocator();
-  rclc_support_t support;
-
-  // Create messages.
-  range_msg = sensor_msgs__msg__Range__create();
-
-  // Create init_options.
-  RCCHECK(rclc_support_init(&support, 0, NULL, &allocator));
-
-  // Create node.
-  rcl_node_t node = rcl_get_zero_initialized_node();
-  RCCHECK(rclc_node_init_default(&node, TAG, "", &support));
-
-  // Create publishers.
-  ESP_LOGI(TAG, "Creating publishers");
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_1, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_1));
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_2, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_2));
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_3, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_3));
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_4, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_4));
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_5, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_5));
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_range_6, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Range),
-      k_range_6));
-
-  // Create timer.
-  ESP_LOGI(TAG, "Creating timers");
-  rcl_timer_t timer = rcl_get_zero_initialized_timer();
-  const unsigned int timer_timeout = 1000;
-  RCCHECK(rclc_timer_init_default(&timer, &support, RCL_MS_TO_NS(timer_timeout),
-                                  timer_callback));
-
-  // Create executor.
-  ESP_LOGI(TAG, "Creating executor");
-  rclc_executor_t executor = rclc_executor_get_zero_initialized_executor();
-  RCCHECK(rclc_executor_init(&executor, &support.context, EXECUTOR_HANDLE_COUNT,
-                             &allocator));
-  unsigned int rcl_wait_timeout = 1000;  // in ms
-  RCCHECK(rclc_executor_set_timeout(&executor, RCL_MS_TO_NS(rcl_wait_timeout)));
-  RCCHECK(rclc_executor_add_timer(&executor, &timer));
-
-
-  // Spin until the power is disconnected or reset pressed.
-  ESP_LOGI(TAG, "Spinning...");
-  while (1) {
-    rclc_executor_spin_some(&executor, 100);
-    usleep(US_PER_TICK);
+/* The entity table timer period is in ms, so set the stress rate here.  Called
+ * each time the timer is created.
+ */
+static void set_stress_rate(void) {
+#if STRESS_RATE_HZ > 0
+  int64_t old_period;
+  RCSOFTCHECK(rcl_timer_exchange_period(&timer_ranges,
+                                        1000000000LL / STRESS_RATE_HZ,
+                                        &old_period));
+  RCSOFTCHECK(rcl_timer_reset(&timer_ranges));
+  ESP_LOGI(TAG, "Stress mode: %d Hz", STRESS_RATE_HZ);
+#endif
+}
+
+static void on_connected(void) {
+  set_stress_rate();
+#if MSG_TEMPLATE_BENCHMARK > 0
+  // Only the first time.  The benchmark sends 2 * MSG_TEMPLATE_BENCHMARK
+  // messages.
+  static bool benchmarked = false;
+  if (!benchmarked) {
+    benchmarked = true;
+    msg_template_benchmark(&range_template, BENCHMARK_PUBLISHER,
+                           MSG_TEMPLATE_BENCHMARK);
   }
+#endif
+}
 
-  // Free resources.  Probably never called on the ESP32.
-  ESP_LOGI(TAG, "Free resources");
-  RCCHECK(rcl_publisher_fini(&publisher_range_1, &node))
-  RCCHECK(rcl_publisher_fini(&publisher_range_2, &node))
-  RCCHECK(rcl_publisher_fini(&publisher_range_3, &node))
-  RCCHECK(rcl_publisher_fini(&publisher_range_4, &node))
-  RCCHECK(rcl_publisher_fini(&publisher_range_5, &node))
-  RCCHECK(rcl_node_fini(&node))
-  sensor_msgs__msg__Range__destroy(range_msg);
+void appMain(void *arg) {
+  // Start the deferred logging task first so that it is ready for the
+  // callbacks.
+  dlog_init();
+
+  // The arena allocator, if APP_ALLOCATOR is APP_ALLOCATOR_STATIC.
+  rcl_allocator_t allocator = static_allocator_init();
+
+  // Create messages.  publish_ranges() needs their buffers.
+  if (!create_messages()) {
+    printf("Failed to create the messages. Aborting.\n");
+    vTaskDelete(NULL);
+  }
+  create_policies();
+  // Start reading the sensors.
+  range_acquisition_start(&RANGE_SENSOR_DRIVER);
+#if STRESS_RATE_HZ > 0
+  publish_stats_init((float)STRESS_RATE_HZ * MESSAGES_PER_TICK);
+#else
+  publish_stats_init(1000.0 / RANGE_TIMER_PERIOD_MS * MESSAGES_PER_TICK);
+#endif
 
+  // Create the entities whenever the agent can be reached and keep taking
+  // ranges when it can't.  Never returns.
+  const connection_manager_config_t config = {
+      .registry = &entities,
+      .node_name = TAG,
+      .allocator = &allocator,
+      .on_connected = on_connected,
+      .on_disconnected = NULL,
+      .stores = stores,
+      .store_count = sizeof(stores) / sizeof(stores[0]),
+  };
+  connection_manager_run(&config);
+
+  // Probably never get here but this is for completeness.
+  destroy_messages();
   vTaskDelete(NULL);
 }
@@ -0,0 +1,129 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* Build options for the publishers app.
+ * Options that change app_entities.h change app-colcon.meta, so run
+ * tools/gen_colcon_meta.bash and do a full rebuild after changing them.
+ */
+
+// Publishing modes.
+// PUBLISH_MODE_PER_SENSOR: One Range message per ToF sensor per tick.
+// PUBLISH_MODE_BATCHED: All ToF readings from one tick are packed into a
+// single LaserScan message with a shared stamp and sent in one write.  Use
+// tools/tof_unpacker.py on the host to republish them as per-sensor Range
+// topics.
+#define PUBLISH_MODE_PER_SENSOR (0)
+#define PUBLISH_MODE_BATCHED (1)
+#ifndef PUBLISH_MODE
+#define PUBLISH_MODE PUBLISH_MODE_PER_SENSOR
+#endif
+
+// Number of ToF sensors.
+#define RANGE_SENSOR_COUNT (6)
+
+// Period of the timer that publishes the ranges.
+#define RANGE_TIMER_PERIOD_MS (1000)
+
+// Range sensor driver.  See range_sensor.h.
+#define RANGE_SENSOR_DRIVER range_sensor_synthetic
+// Each sensor is read on its own task at this period.  See
+// range_acquisition.h.
+#define RANGE_SAMPLE_PERIOD_MS (100)
+// Readings buffered per sensor between publishes.  Must be a power of 2 and
+// hold more than one RANGE_TIMER_PERIOD_MS of readings, otherwise the newest
+// are dropped.
+#define RANGE_RING_SIZE (16)
+// Time taken by each synthetic read.
+#define RANGE_SYNTHETIC_READ_MS (20)
+
+// Stress mode.  0 to publish every RANGE_TIMER_PERIOD_MS.  Otherwise the range
+// timer runs at this rate, from 1 Hz up to a few kHz, and the per-message
+// logging is turned off.  Either way, the achieved and requested message rates
+// are reported every PUBLISH_REPORT_PERIOD_S.  See publish_stats.h.
+#ifndef STRESS_RATE_HZ
+#define STRESS_RATE_HZ (0)
+#endif
+
+// Range samples kept while the agent can't be reached.  The oldest are
+// dropped when it is full.  See common/connection_manager.h.
+#ifndef RANGE_STORE_CAPACITY
+#define RANGE_STORE_CAPACITY (64)
+#endif
+
+// Range topics to publish best effort instead of reliable.  Bit 0 is ToF 1,
+// bit 1 is ToF 2 and so on.  In batched mode bit 0 sets the batch topic.
+#ifndef RANGE_BEST_EFFORT_MASK
+#define RANGE_BEST_EFFORT_MASK (0x00)
+#endif
+#define RANGE_QOS(sensor)                              \
+  ((((RANGE_BEST_EFFORT_MASK) >> ((sensor)-1)) & 1) ? \
+       ENTITY_QOS_BEST_EFFORT :                        \
+       ENTITY_QOS_RELIABLE)
+
+/* Only send a range when it has changed.  See common/publish_policy.h.  A
+ * reading is sent if it moved by more than RANGE_DEADBAND_M, or
+ * RANGE_DEADBAND_RELATIVE of the last reading sent if that is bigger, or if
+ * nothing has been sent for RANGE_MAX_SILENCE_MS.  Readings are never sent
+ * less than RANGE_MIN_SPACING_MS apart.  In batched mode the scan is sent if
+ * any sensor's reading is due.  A deadband of -1 sends every reading, which
+ * stress mode does so that the achieved rate means something.
+ */
+#ifndef RANGE_DEADBAND_M
+#if STRESS_RATE_HZ > 0
+#define RANGE_DEADBAND_M (-1)
+#else
+#define RANGE_DEADBAND_M (0.01)
+#endif
+#endif
+#ifndef RANGE_DEADBAND_RELATIVE
+#define RANGE_DEADBAND_RELATIVE (0.02)
+#endif
+#ifndef RANGE_MAX_SILENCE_MS
+#define RANGE_MAX_SILENCE_MS (5000)
+#endif
+#ifndef RANGE_MIN_SPACING_MS
+#define RANGE_MIN_SPACING_MS (0)
+#endif
+
+// Send the range messages from templates serialised at start up, patching
+// just the ranges and stamps.  Off by default, as rmw_microxrcedds for
+// foxy can't publish serialised messages.  See common/msg_template.h.
+#ifndef APP_MSG_TEMPLATES
+#define APP_MSG_TEMPLATES (0)
+#endif
+// When first connected, time this many serialisations and publishes of the
+// range message each way, generic and template.  0 for none.  Needs
+// APP_MSG_TEMPLATES 1.
+#ifndef MSG_TEMPLATE_BENCHMARK
+#define MSG_TEMPLATE_BENCHMARK (0)
+#endif
+
+// Create the entities without waiting for the agent to confirm each one.
+// Changes app-colcon.meta.  See common/entity_table.h.
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT (0)
+#endif
+
+// Time every executor callback and publish the histograms on
+// diagnostics/executor_profile.  See common/executor_profile.h.
+#ifndef APP_EXECUTOR_PROFILE
+#define APP_EXECUTOR_PROFILE (1)
+#endif
+
+// Publish the tasks' CPU and stack, the heap and the static arena use on
+// diagnostics/resources.  See common/resource_diag.h.
+#ifndef APP_RESOURCE_DIAG
+#define APP_RESOURCE_DIAG (1)
+#endif
+
+// Spin loop.  SPIN_MODE_EVENT or SPIN_MODE_POLL.  See common/app_spin.h.
+#define APP_SPIN_MODE SPIN_MODE_EVENT
+
+// rcl allocator.  APP_ALLOCATOR_STATIC or APP_ALLOCATOR_DEFAULT.  See
+// common/static_allocator.h.
+#define APP_ALLOCATOR APP_ALLOCATOR_STATIC
+
+// Deferred logging level for the hot paths.  See common/deferred_log.h.
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+
+#endif  // APP_CONFIG_H
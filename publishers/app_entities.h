@@ -0,0 +1,42 @@
+#ifndef APP_ENTITIES_H
+#define APP_ENTITIES_H
+
+/* Entities used by the publishers app.  See common/entity_table.h.
+ * ********** IMPORTANT: Run tools/gen_colcon_meta.bash after changing this
+ * file to update app-colcon.meta.  *********
+ */
+
+#include "app_config.h"
+#include "entity_table.h"
+
+#if PUBLISH_MODE == PUBLISH_MODE_BATCHED
+#define APP_PUBLISHERS(PUBLISHER)                                     \
+  PUBLISHER(range_batch, sensor_msgs, LaserScan, "sensors/tof_batch", \
+            RANGE_QOS(1))                                             \
+  ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                                \
+  ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+#else
+// NOTE: The range publishers must be first and in sensor order.
+#define APP_PUBLISHERS(PUBLISHER)                                      \
+  PUBLISHER(range_1, sensor_msgs, Range, "sensors/tof1", RANGE_QOS(1)) \
+  PUBLISHER(range_2, sensor_msgs, Range, "sensors/tof2", RANGE_QOS(2)) \
+  PUBLISHER(range_3, sensor_msgs, Range, "sensors/tof3", RANGE_QOS(3)) \
+  PUBLISHER(range_4, sensor_msgs, Range, "sensors/tof4", RANGE_QOS(4)) \
+  PUBLISHER(range_5, sensor_msgs, Range, "sensors/tof5", RANGE_QOS(5)) \
+  PUBLISHER(range_6, sensor_msgs, Range, "sensors/tof6", RANGE_QOS(6)) \
+  ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                                 \
+  ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+#endif
+
+#define APP_SUBSCRIPTIONS(SUBSCRIPTION)
+
+#define APP_CLIENTS(CLIENT)
+
+#define APP_SERVICES(SERVICE)
+
+#define APP_TIMERS(TIMER)                              \
+  TIMER(ranges, RANGE_TIMER_PERIOD_MS, timer_callback) \
+  ENTITY_PROFILE_TIMERS(TIMER)                         \
+  ENTITY_DIAG_TIMERS(TIMER)
+
+#endif  // APP_ENTITIES_H
@@ -0,0 +1,75 @@
+#include "publish_stats.h"
+
+#include "app_time.h"
+#include "bench_report.h"
+#include "deferred_log.h"
+
+static const char *TAG = "publish";
+
+static float requested_rate = 0.0;
+// Counts since the last report.
+static int64_t report_start_us = 0;
+static uint32_t published = 0;
+static uint32_t failures = 0;
+static uint32_t stalls = 0;
+static int64_t max_publish_us = 0;
+// Totals since start up.
+static uint32_t total_failures = 0;
+static uint32_t total_stalls = 0;
+
+void publish_stats_init(float requested_per_s) {
+  requested_rate = requested_per_s;
+  report_start_us = app_time_us();
+}
+
+// Count one publish that started at start_us.
+static rcl_ret_t count_publish(rcl_ret_t rc, int64_t start_us) {
+  int64_t publish_us = app_time_us() - start_us;
+  if (rc == RCL_RET_OK) {
+    published++;
+  } else {
+    failures++;
+    total_failures++;
+  }
+  if (publish_us > PUBLISH_STALL_US) {
+    stalls++;
+    total_stalls++;
+  }
+  if (publish_us > max_publish_us) {
+    max_publish_us = publish_us;
+  }
+  return rc;
+}
+
+rcl_ret_t publish_stats_publish_template(const rcl_publisher_t *publisher,
+                                         msg_template_t *tmpl) {
+  int64_t start_us = app_time_us();
+  return count_publish(msg_template_publish(tmpl, publisher), start_us);
+}
+
+void publish_stats_report(void) {
+  int64_t now_us = app_time_us();
+  int64_t elapsed_us = now_us - report_start_us;
+  if (elapsed_us < (int64_t)PUBLISH_REPORT_PERIOD_S * 1000000) {
+    return;
+  }
+  float achieved_rate = published * 1000000.0 / elapsed_us;
+  DLOG_I(TAG,
+         "%.1f msgs/s achieved of %.1f requested, %u failures, %u stalls, "
+         "max publish %d us",
+         achieved_rate, requested_rate, failures, stalls,
+         (int32_t)max_publish_us);
+  bench_report(
+      "{\"app\":\"publishers\",\"requested_per_s\":%.1f,"
+      "\"achieved_per_s\":%.1f,\"published\":%u,\"failures\":%u,"
+      "\"stalls\":%u,\"max_publish_us\":%d,\"total_failures\":%u,"
+      "\"total_stalls\":%u}",
+      requested_rate, achieved_rate, (unsigned int)published,
+      (unsigned int)failures, (unsigned int)stalls, (int)max_publish_us,
+      (unsigned int)total_failures, (unsigned int)total_stalls);
+  report_start_us = now_us;
+  published = 0;
+  failures = 0;
+  stalls = 0;
+  max_publish_us = 0;
+}
@@ -0,0 +1,37 @@
+#ifndef PUBLISH_STATS_H
+#define PUBLISH_STATS_H
+
+/* Publish counters for the range publishers.
+ *
+ * publish_stats_publish_template() wraps msg_template_publish(), which sends
+ * with rcl_publish() when APP_MSG_TEMPLATES is 0.  It counts the messages
+ * sent, the failed publishes and the stalls, i.e. publishes that took longer
+ * than PUBLISH_STALL_US.  publish_stats_report() logs the
+ * achieved rate against the requested rate every PUBLISH_REPORT_PERIOD_S, and
+ * writes the same figures as a bench_report() line.
+ *
+ * Only call from the executor task.
+ */
+
+#include <rcl/rcl.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "msg_template.h"
+
+// A publish that takes longer than this is counted as a stall.
+#ifndef PUBLISH_STALL_US
+#define PUBLISH_STALL_US (10 * 1000)
+#endif
+#ifndef PUBLISH_REPORT_PERIOD_S
+#define PUBLISH_REPORT_PERIOD_S (10)
+#endif
+
+// requested_per_s is the number of messages per second the app tries to send.
+void publish_stats_init(float requested_per_s);
+rcl_ret_t publish_stats_publish_template(const rcl_publisher_t *publisher,
+                                         msg_template_t *tmpl);
+// Call after each batch of publishes.  Only reports once per period.
+void publish_stats_report(void);
+
+#endif  // PUBLISH_STATS_H
@@ -0,0 +1,98 @@
+#include "range_acquisition.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdatomic.h>
+
+#include "app_config.h"
+#include "app_time.h"
+#include "deferred_log.h"
+#include "esp_log.h"
+#include "spsc_ring.h"
+
+#define TASK_STACK_SIZE (2048)
+// Below the executor task.  The reads mostly block anyway.
+#define TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+#ifndef RANGE_ACQUISITION_REPORT_PERIOD_S
+#define RANGE_ACQUISITION_REPORT_PERIOD_S (10)
+#endif
+
+_Static_assert(RANGE_RING_SIZE * RANGE_SAMPLE_PERIOD_MS > RANGE_TIMER_PERIOD_MS,
+               "RANGE_RING_SIZE is too small for the publish period");
+
+static const char *TAG = "range";
+
+typedef struct {
+  spsc_ring_t ring;
+  range_reading_t buffer[RANGE_RING_SIZE];
+  // Written by the sensor task.
+  atomic_uint reads;
+  atomic_uint failures;
+  // Written by the consumer.
+  uint32_t stale;
+} sensor_state_t;
+
+static const range_sensor_driver_t *sensor_driver = NULL;
+static sensor_state_t sensors[RANGE_SENSOR_COUNT];
+static int64_t report_start_us = 0;
+
+static void sensor_task(void *arg) {
+  size_t index = (size_t)arg;
+  sensor_state_t *sensor = &sensors[index];
+  if (!sensor_driver->init(index)) {
+    ESP_LOGE(TAG, "Failed to start %s sensor %u", sensor_driver->name,
+             (unsigned int)index + 1);
+  }
+  TickType_t last_wake = xTaskGetTickCount();
+  while (1) {
+    range_reading_t reading;
+    if (sensor_driver->read(index, &reading.range_m)) {
+      reading.time_us = app_time_us();
+      atomic_fetch_add(&sensor->reads, 1);
+      spsc_ring_push(&sensor->ring, &reading);
+    } else {
+      atomic_fetch_add(&sensor->failures, 1);
+    }
+    // Fixed rate unless a read takes longer than the period.
+    vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(RANGE_SAMPLE_PERIOD_MS));
+  }
+}
+
+void range_acquisition_start(const range_sensor_driver_t *driver) {
+  sensor_driver = driver;
+  report_start_us = app_time_us();
+  ESP_LOGI(TAG, "Reading %u %s sensors every %u ms",
+           (unsigned int)RANGE_SENSOR_COUNT, driver->name,
+           (unsigned int)RANGE_SAMPLE_PERIOD_MS);
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    spsc_ring_init(&sensors[i].ring, sensors[i].buffer,
+                   sizeof(range_reading_t), RANGE_RING_SIZE);
+    // Spread the sensors over both cores.
+    xTaskCreatePinnedToCore(sensor_task, "range", TASK_STACK_SIZE, (void *)i,
+                            TASK_PRIORITY, NULL, (BaseType_t)(i % 2));
+  }
+}
+
+bool range_acquisition_latest(size_t index, range_reading_t *reading) {
+  if (spsc_ring_pop_latest(&sensors[index].ring, reading) == 0) {
+    sensors[index].stale++;
+    return false;
+  }
+  return true;
+}
+
+void range_acquisition_report(void) {
+  int64_t now_us = app_time_us();
+  if (now_us - report_start_us <
+      (int64_t)RANGE_ACQUISITION_REPORT_PERIOD_S * 1000000) {
+    return;
+  }
+  report_start_us = now_us;
+  for (size_t i = 0; i < RANGE_SENSOR_COUNT; i++) {
+    sensor_state_t *sensor = &sensors[i];
+    DLOG_I(TAG, "ToF %u: %u reads, %u failed, %u overruns, %u stale",
+           (unsigned int)i + 1, atomic_load(&sensor->reads),
+           atomic_load(&sensor->failures),
+           atomic_load(&sensor->ring.overruns), sensor->stale);
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef RANGE_ACQUISITION_H
+#define RANGE_ACQUISITION_H
+
+/* Reads the range sensors off the executor task.
+ *
+ * Each sensor has its own task that reads it every RANGE_SAMPLE_PERIOD_MS and
+ * pushes the reading into the sensor's SPSC ring (common/spsc_ring.h).  The
+ * publish timer calls range_acquisition_latest() to take the newest reading
+ * and throw away any older ones, so a slow or stuck sensor only makes its own
+ * reading stale.  It never holds up the executor or the other sensors.
+ *
+ * range_acquisition_report() logs, for each sensor, how many readings were
+ * taken, how many reads failed, how many readings were dropped because the
+ * ring was full and how many publishes had no new reading, all since start
+ * up.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "range_sensor.h"
+
+typedef struct {
+  int64_t time_us;  // When the read finished.
+  float range_m;
+} range_reading_t;
+
+// Start one task per sensor.
+void range_acquisition_start(const range_sensor_driver_t *driver);
+/* Take the newest reading of sensor `index`.  Returns false, leaving `reading`
+ * unchanged, if there hasn't been a new one since the last call.  Only call
+ * from one task.
+ */
+bool range_acquisition_latest(size_t index, range_reading_t *reading);
+// Only reports once per RANGE_ACQUISITION_REPORT_PERIOD_S.
+void range_acquisition_report(void);
+
+#endif  // RANGE_ACQUISITION_H
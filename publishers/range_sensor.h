@@ -0,0 +1,29 @@
+#ifndef RANGE_SENSOR_H
+#define RANGE_SENSOR_H
+
+/* Interface to the ToF range sensors.
+ *
+ * A driver reads one sensor at a time.  read() may block, e.g. on an I2C
+ * transfer, as it is only called from that sensor's acquisition task.  See
+ * range_acquisition.h.
+ *
+ * Set RANGE_SENSOR_DRIVER in app_config.h to pick the driver.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+  const char *name;
+  // Called once on the sensor's task before the first read.
+  bool (*init)(size_t index);
+  // Returns false if there was no valid reading.
+  bool (*read)(size_t index, float *range_m);
+} range_sensor_driver_t;
+
+/* Made up ranges for testing, e.g. on Linux.  Each sensor follows a slow sine
+ * wave and each read takes RANGE_SYNTHETIC_READ_MS, like a real ToF read.
+ */
+extern const range_sensor_driver_t range_sensor_synthetic;
+
+#endif  // RANGE_SENSOR_H
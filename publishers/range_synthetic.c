@@ -0,0 +1,30 @@
+#include <math.h>
+#include <unistd.h>
+
+#include "app_config.h"
+#include "app_time.h"
+#include "range_sensor.h"
+
+// Range in the middle of the sine wave and its amplitude.
+#define MID_RANGE_M (1.1f)
+#define AMPLITUDE_M (0.5f)
+// Period of the sine wave for sensor 1.  Each sensor is a bit slower.
+#define WAVE_PERIOD_S (5.0f)
+
+static bool synthetic_init(size_t index) { return true; }
+
+static bool synthetic_read(size_t index, float *range_m) {
+  // Pretend to wait for the sensor.
+  usleep(RANGE_SYNTHETIC_READ_MS * 1000);
+  float t = app_time_us() / 1e6f;
+  float period = WAVE_PERIOD_S + index;
+  *range_m = MID_RANGE_M + 0.1f * index +
+             AMPLITUDE_M * sinf(2.0f * (float)M_PI * t / period);
+  return true;
+}
+
+const range_sensor_driver_t range_sensor_synthetic = {
+    .name = "synthetic",
+    .init = synthetic_init,
+    .read = synthetic_read,
+};
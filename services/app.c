@@ -7,192 +7,306 @@
 #include <rclc/rclc.h>
 #include <rcutils/error_handling.h>
 #include <std_msgs/msg/int32.h>
-#include <stdio.h>
 #include <unistd.h>
 
+#include "app_config.h"
+#include "app_entities.h"
+#include "app_spin.h"
+#include "app_time.h"
+#include "async_client.h"
+#include "bench_report.h"
+#include "connection_manager.h"
+#include "deferred_log.h"
+#include "entity_registry.h"
+#include "executor_split.h"
 #include "geometry_msgs/msg/twist.h"
+#include "msg_template.h"
+#include "publish_policy.h"
 #include "sensor_msgs/msg/battery_state.h"
+#include "static_allocator.h"
 #include "std_srvs/srv/set_bool.h"
+#include "store_forward.h"
+#include "string_pool.h"
+#include "time_sync.h"
 
-#define RCCHECK(fn)                                                 \
-  {                                                                 \
-    rcl_ret_t temp_rc = fn;                                         \
-    if ((temp_rc != RCL_RET_OK)) {                                  \
-      printf("Failed status on line %d: %d. Aborting.\n", __LINE__, \
-             (int)temp_rc);                                         \
-      vTaskDelete(NULL);                                            \
-    }                                                               \
-  }
-#define RCSOFTCHECK(fn)                                               \
-  {                                                                   \
-    rcl_ret_t temp_rc = fn;                                           \
-    if ((temp_rc != RCL_RET_OK)) {                                    \
-      printf("Failed status on line %d: %d. Continuing.\n", __LINE__, \
-             (int)temp_rc);                                           \
-    }                                                                 \
-  }
-
-/* Number of executor handles. One for each timer, service and subscriber.
- * Publishers don't count as they are driven by the timer.
- * ********** IMPORTANT: CHANGE VALUES IN app-colcon.meta.  *********
- */
-#define TIMER_HANDLE_COUNT (1)
-#define CLIENT_HANDLE_COUNT (3)
-#define SUBSCRIBER_HANDLE_COUNT (1)
-#define EXECUTOR_HANDLE_COUNT \
-  (TIMER_HANDLE_COUNT + CLIENT_HANDLE_COUNT + SUBSCRIBER_HANDLE_COUNT)
+// Publishers, subscribers, clients, timers and callbacks are listed in
+// app_entities.h.
+ENTITY_REGISTRY_DEFINE(entities)
 
 // Logging name.
 static const char *TAG = "swarm_trooper";
-// Standard topic names.
-static const char *k_battery_state = "battery_state";
-// This caused add_subscriber to abort.
-// static const char *k_cmd_vel_1 = "cmd_vel/1";
-static const char *k_cmd_vel_1 = "cmd_vel_1";
-static const char *service_name_1 = "set_bool_1";
-static const char *service_name_2 = "set_bool_2";
-static const char *service_name_3 = "set_bool_3";
-
-static rcl_publisher_t publisher_battery_state;
-static rcl_subscription_t subscriber_cmd_vel_1;
 // Messages to publish.
-static sensor_msgs__msg__BatteryState *battery_state_msg = NULL;
-// Service "messages".
-static std_srvs__srv__SetBool_Response result_1;
-static std_srvs__srv__SetBool_Response result_2;
-static std_srvs__srv__SetBool_Response result_3;
-
-static void publish_battery_state(void) {
-  battery_state_msg->voltage = 1.3;
-  ESP_LOGI(TAG, "Sending msg: %f", battery_state_msg->voltage);
-  rcl_ret_t rc = rcl_publish(&publisher_battery_state, battery_state_msg, NULL);
-  RCLC_UNUSED(rc);
-}
+static sensor_msgs__msg__BatteryState battery_state_msg;
+// battery_state_msg serialised once.  Only the voltage and stamp are patched.
+static msg_template_t battery_state_template;
 
-static void timer_callback(rcl_timer_t *timer, int64_t last_call_time) {
-  ESP_LOGI(TAG, "Timer called.");
-  if (timer != NULL) {
-    publish_battery_state();
-  }
+// Battery reading.  Kept in battery_store until it is sent.
+typedef struct {
+  int64_t time_us;
+  float voltage;
+} battery_sample_t;
+
+static bool publish_battery_state(const void *sample_in) {
+  const battery_sample_t *sample = (const battery_sample_t *)sample_in;
+  battery_state_msg.voltage = sample->voltage;
+  time_sync_stamp(&battery_state_msg.header.stamp, sample->time_us);
+  DLOG_I(TAG, "Sending msg: %f", battery_state_msg.voltage);
+  rcl_ret_t rc =
+      msg_template_publish(&battery_state_template, &publisher_battery_state);
+  app_spin_published();
+  return rc == RCL_RET_OK;
 }
 
+// Only the latest battery state matters, so a reconnect sends just one.
+STORE_FORWARD_DEFINE(battery_store, battery_sample_t, 1,
+                     STORE_FORWARD_COALESCE, publish_battery_state)
+static store_forward_t *const stores[] = {&battery_store};
+
+static const publish_policy_config_t battery_policy_config = {
+    .deadband = BATTERY_DEADBAND_V,
+    .relative_deadband = 0,
+    .max_silence_ms = BATTERY_MAX_SILENCE_MS,
+    .min_spacing_ms = 0,
+};
+static publish_policy_t battery_policy;
+
 static void subscription_callback_cmd_vel_1(const void *msg_in) {
   const geometry_msgs__msg__Twist *msg =
       (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
+  DLOG_I(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
 }
 
-static void client_callback(const void *msg) {
-  std_srvs__srv__SetBool_Response *msgin =
-      (std_srvs__srv__SetBool_Response *)msg;
-  static int call_count = 0;
-  if (call_count == 0) {
-    msgin->success = true;
-    sprintf(msgin->message.data, "%s", "Success");
-  } else {
-    msgin->success = false;
-    sprintf(msgin->message.data, "%s", "Fail");
+/* SetBool requests.  All the clients are SetBool clients, in the same order
+ * as set_bool_clients.
+ */
+#define REPORT_PERIOD_US (10 * 1000000LL)
+static async_client_t set_bool_clients[APP_CLIENT_COUNT];
+static int64_t report_start_us = 0;
+
+static void create_clients(void) {
+  for (size_t i = 0; i < APP_CLIENT_COUNT; i++) {
+    // The handles are reinitialised on each reconnect but don't move.
+    async_client_init(&set_bool_clients[i], entities.clients[i].handle,
+                      entities.clients[i].service, SERVICE_REQUEST_TIMEOUT_MS);
+    // The response message needs its buffer before a response is taken.
+    std_srvs__srv__SetBool_Response *response =
+        (std_srvs__srv__SetBool_Response *)entities.clients[i].response;
+    if (!string_pool_init(&response->message, SET_BOOL_MESSAGE_CAPACITY)) {
+      ESP_LOGE(TAG, "String pool too small for %s",
+               entities.clients[i].service);
+    }
   }
-  printf("Sending service 1 response %d, '%s'\n", msgin->success,
-         msgin->message.data);
 }
 
-void appMain(void *arg) {
-  rcl_allocator_t allocator = rcl_get_default_allocator();
-  rclc_support_t support;
+static void report_clients(void) {
+  for (size_t i = 0; i < APP_CLIENT_COUNT; i++) {
+    async_client_stats_t stats;
+    async_client_take_stats(&set_bool_clients[i], &stats);
+    int64_t average_us =
+        stats.completed ? stats.round_trip_sum_us / stats.completed : 0;
+    DLOG_I(TAG,
+           "%s: %u of %u done, %u timeouts, round trip avg %d us, max %d us",
+           set_bool_clients[i].name, stats.completed, stats.sent,
+           stats.timed_out, (int32_t)average_us,
+           (int32_t)stats.round_trip_max_us);
+    if (stats.rejected != 0 || stats.unmatched != 0) {
+      DLOG_W(TAG, "%s: %u requests rejected, %u unmatched responses",
+             set_bool_clients[i].name, stats.rejected, stats.unmatched);
+    }
+    bench_report(
+        "{\"app\":\"services\",\"client\":\"%s\",\"sent\":%u,"
+        "\"completed\":%u,\"timed_out\":%u,\"rejected\":%u,"
+        "\"round_trip_avg_us\":%d,\"round_trip_max_us\":%d}",
+        set_bool_clients[i].name, (unsigned int)stats.sent,
+        (unsigned int)stats.completed, (unsigned int)stats.timed_out,
+        (unsigned int)stats.rejected, (int)average_us,
+        (int)stats.round_trip_max_us);
+  }
+}
 
-  // Initialise messages.
-  battery_state_msg = sensor_msgs__msg__BatteryState__create();
+/* SetBool servers for the actuators.  The response messages are set up once
+ * and then only point at one of two fixed strings, so a call does no
+ * allocation or formatting.
+ */
+static bool actuator_state[APP_SERVICE_COUNT];
+static rosidl_runtime_c__String state_messages[2];
+// Handling time, since the last report.
+static uint32_t service_calls = 0;
+static int64_t service_time_sum_us = 0;
+static int64_t service_time_max_us = 0;
 
-  // Create init_options
-  RCCHECK(rclc_support_init(&support, 0, NULL, &allocator));
+static void create_service_responses(void) {
+  if (!string_pool_init(&state_messages[0], 3) ||
+      !string_pool_init(&state_messages[1], 3)) {
+    ESP_LOGE(TAG, "String pool too small for the service responses");
+    return;
+  }
+  string_pool_set(&state_messages[0], "off");
+  string_pool_set(&state_messages[1], "on");
+  for (size_t i = 0; i < APP_SERVICE_COUNT; i++) {
+    std_srvs__srv__SetBool_Response *response =
+        (std_srvs__srv__SetBool_Response *)entities.services[i].response;
+    response->message = state_messages[0];
+  }
+}
 
-  // Create node
-  rcl_node_t node = rcl_get_zero_initialized_node();
-  RCCHECK(rclc_node_init_default(&node, TAG, "", &support));
+// Shared by all the actuator services.
+static void service_callback_actuator(const void *request_in,
+                                      void *response_out) {
+  int64_t start_us = app_time_us();
+  const std_srvs__srv__SetBool_Request *request =
+      (const std_srvs__srv__SetBool_Request *)request_in;
+  std_srvs__srv__SetBool_Response *response =
+      (std_srvs__srv__SetBool_Response *)response_out;
+  int index = entity_registry_find_service(&entities, request_in);
+  if (index < 0) {
+    response->success = false;
+    return;
+  }
+  actuator_state[index] = request->data;
+  response->success = true;
+  response->message = state_messages[request->data ? 1 : 0];
+  int64_t time_us = app_time_us() - start_us;
+  service_calls++;
+  service_time_sum_us += time_us;
+  if (time_us > service_time_max_us) {
+    service_time_max_us = time_us;
+  }
+  DLOG_D(TAG, "%s set to %d", entities.services[index].service,
+         request->data);
+}
 
-  // Create publishers.
-  ESP_LOGI(TAG, "Creating publishers");
+static void report_services(void) {
+  DLOG_I(TAG, "Services: %u calls, handling time avg %d us, max %d us",
+         service_calls,
+         (int32_t)(service_calls ? service_time_sum_us / service_calls : 0),
+         (int32_t)service_time_max_us);
+  service_calls = 0;
+  service_time_sum_us = 0;
+  service_time_max_us = 0;
+}
 
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_battery_state, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, BatteryState),
-      k_battery_state));
-
-  // Create subscribers.
-  ESP_LOGI(TAG, "Creating subscribers");
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_1, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_1));
-
-  // Create service.
-  ESP_LOGI(TAG, "Creating service clients");
-  rcl_client_t client_1;
-  RCCHECK(rclc_client_init_default(
-      &client_1, &node, ROSIDL_GET_SRV_TYPE_SUPPORT(std_srvs, srv, SetBool),
-      service_name_1));
-  /* Failed here with error code 1.
-  Added debug to these files.
-  firmware/mcu_ws/uros/rcl/rcl/src/rcl/client.c
-  firmware/mcu_ws/uros/rmw_microxrcedds/rmw_microxrcedds_c/src/rmw_client.c
-  Needed to set -DRMW_UXRCE_MAX_CLIENTS in app-colcon.meta to match number of
-  service clients.
-  */
-
-  rcl_client_t client_2;
-  RCCHECK(rclc_client_init_default(
-      &client_2, &node, ROSIDL_GET_SRV_TYPE_SUPPORT(std_srvs, srv, SetBool),
-      service_name_2));
-
-  rcl_client_t client_3;
-  RCCHECK(rclc_client_init_default(
-      &client_3, &node, ROSIDL_GET_SRV_TYPE_SUPPORT(std_srvs, srv, SetBool),
-      service_name_3));
-
-  // Create timer.
-  ESP_LOGI(TAG, "Creating timers");
-  rcl_timer_t timer = rcl_get_zero_initialized_timer();
-  const unsigned int timer_timeout_ms = 1000;
-  RCCHECK(rclc_timer_init_default(
-      &timer, &support, RCL_MS_TO_NS(timer_timeout_ms), timer_callback));
-
-  // Create executor.
-  ESP_LOGI(TAG, "Creating executor");
-  rclc_executor_t executor = rclc_executor_get_zero_initialized_executor();
-  RCCHECK(rclc_executor_init(&executor, &support.context, EXECUTOR_HANDLE_COUNT,
-                             &allocator));
-  unsigned int rcl_wait_timeout_ms = 1000;  // in ms
-  RCCHECK(
-      rclc_executor_set_timeout(&executor, RCL_MS_TO_NS(rcl_wait_timeout_ms)));
-  RCCHECK(rclc_executor_add_timer(&executor, &timer));
-
-  ESP_LOGI(TAG, "Adding subs");
-  geometry_msgs__msg__Twist twist_msg_1;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_1, &twist_msg_1,
-      &subscription_callback_cmd_vel_1, ON_NEW_DATA));
-
-  ESP_LOGI(TAG, "Adding services");
-  RCCHECK(rclc_executor_add_client(&executor, &client_1, &result_1,
-                                   client_callback));
-  RCCHECK(rclc_executor_add_client(&executor, &client_2, &result_2,
-                                   client_callback));
-  RCCHECK(rclc_executor_add_client(&executor, &client_3, &result_3,
-                                   client_callback));
-
-  // Spin forever.
-  ESP_LOGI(TAG, "Spinning...");
-  while (1) {
-    rclc_executor_spin(&executor);
+// Logs the figures every REPORT_PERIOD_US.
+static void report(void) {
+  if (app_time_us() - report_start_us < REPORT_PERIOD_US) {
+    return;
+  }
+  report_start_us = app_time_us();
+  if (SERVICE_REQUEST_PERIOD_MS > 0) {
+    report_clients();
+  }
+  report_services();
+}
+
+/* Also called by the connection manager while offline, with a NULL timer.  The
+ * sample still goes into the store.
+ */
+static void timer_callback(rcl_timer_t *timer, int64_t last_call_time) {
+  DLOG_I(TAG, "Timer called.");
+  battery_sample_t sample = {.time_us = app_time_us(), .voltage = 1.3};
+  if (publish_policy_check(&battery_policy, &sample.voltage, sample.time_us)) {
+    store_forward_submit(&battery_store, &sample,
+                         connection_manager_connected());
+  }
+  publish_policy_report(&battery_policy, 1);
+  report();
+}
+
+// The responses to the requests in flight will never arrive.
+static void cancel_requests(void) {
+  for (size_t i = 0; i < APP_CLIENT_COUNT; i++) {
+    async_client_cancel_all(&set_bool_clients[i]);
+  }
+}
+
+#if SERVICE_REQUEST_PERIOD_MS > 0
+static std_srvs__srv__SetBool_Request set_bool_request;
+
+static void set_bool_done(async_client_t *client, const void *response_in,
+                          async_client_status_t status, void *context) {
+  if (status == ASYNC_CLIENT_TIMEOUT) {
+    DLOG_W(TAG, "%s: request timed out", client->name);
+    return;
+  }
+  const std_srvs__srv__SetBool_Response *response =
+      (const std_srvs__srv__SetBool_Response *)response_in;
+  // The message text is overwritten by the next response, so just log its
+  // length.
+  DLOG_D(TAG, "%s: success %d, %u character message", client->name,
+         response->success, (unsigned int)response->message.size);
+}
+
+// Sends a batch of actuator commands on each client.
+static void request_timer_callback(rcl_timer_t *timer,
+                                   int64_t last_call_time) {
+  if (timer == NULL) {
+    return;
   }
+  for (size_t i = 0; i < APP_CLIENT_COUNT; i++) {
+    async_client_t *client = &set_bool_clients[i];
+    async_client_check_timeouts(client);
+    for (int n = 0; n < SERVICE_REQUESTS_PER_TICK &&
+                    async_client_in_flight(client) < ASYNC_CLIENT_MAX_IN_FLIGHT;
+         n++) {
+      set_bool_request.data = !set_bool_request.data;
+      if (async_client_send(client, &set_bool_request, set_bool_done, NULL) !=
+          RCL_RET_OK) {
+        break;
+      }
+      // The request is in its slot, so its response can be taken here.
+      executor_split_yield();
+    }
+  }
+}
+#endif
+
+// Shared by all the clients.  Passes the response to its async client.
+static void client_callback(const void *msg_in, rmw_request_id_t *header) {
+  int index = entity_registry_find_client(&entities, msg_in);
+  if (index < 0) {
+    return;
+  }
+  async_client_handle_response(&set_bool_clients[index], msg_in, header);
+}
+
+void appMain(void *arg) {
+  // Start the deferred logging task first so that it is ready for the
+  // callbacks.
+  dlog_init();
+
+  // The arena allocator, if APP_ALLOCATOR is APP_ALLOCATOR_STATIC.
+  rcl_allocator_t allocator = static_allocator_init();
+
+  // Initialise messages.
+  sensor_msgs__msg__BatteryState__init(&battery_state_msg);
+  msg_template_init(
+      &battery_state_template, "battery_state",
+      ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, BatteryState),
+      &battery_state_msg);
+  msg_template_add_field(&battery_state_template, &battery_state_msg.voltage,
+                         sizeof(battery_state_msg.voltage));
+  msg_template_add_field(&battery_state_template,
+                         &battery_state_msg.header.stamp,
+                         sizeof(battery_state_msg.header.stamp));
+  publish_policy_init(&battery_policy, "battery_state", 1,
+                      &battery_policy_config);
+  create_clients();
+  create_service_responses();
+
+  // Create the entities whenever the agent can be reached.  Never returns.
+  const connection_manager_config_t config = {
+      .registry = &entities,
+      .node_name = TAG,
+      .allocator = &allocator,
+      .on_connected = NULL,
+      .on_disconnected = cancel_requests,
+      .stores = stores,
+      .store_count = sizeof(stores) / sizeof(stores[0]),
+  };
+  connection_manager_run(&config);
+
   // Probably never get here but this is for completeness.
-  // Free resources.
-  ESP_LOGI(TAG, "Free resources");
-  RCCHECK(rcl_client_fini(&client_1, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_1, &node));
-  RCCHECK(rcl_publisher_fini(&publisher_battery_state, &node))
-  RCCHECK(rcl_node_fini(&node))
-  sensor_msgs__msg__BatteryState__destroy(battery_state_msg);
+  sensor_msgs__msg__BatteryState__fini(&battery_state_msg);
   // Delete this task!
   vTaskDelete(NULL);
 }
@@ -0,0 +1,81 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* Build options for the services app.
+ * Options that change app_entities.h change app-colcon.meta, so run
+ * tools/gen_colcon_meta.bash and do a full rebuild after changing them.
+ */
+
+// Period of the timer that publishes the battery state.
+#define BATTERY_TIMER_PERIOD_MS (1000)
+// Only send the battery state when the voltage moves by more than
+// BATTERY_DEADBAND_V, or nothing has been sent for BATTERY_MAX_SILENCE_MS.  A
+// deadband of -1 sends every reading.  See common/publish_policy.h.
+#ifndef BATTERY_DEADBAND_V
+#define BATTERY_DEADBAND_V (0.02)
+#endif
+#ifndef BATTERY_MAX_SILENCE_MS
+#define BATTERY_MAX_SILENCE_MS (5000)
+#endif
+
+// SetBool requests on the set_bool_N clients.  See common/async_client.h.
+// Period of the timer that sends the requests and checks for timeouts.  0, the
+// default, sends none, as nothing in this repo serves set_bool_N except
+// tools/swarm_load.py.  Set it to e.g. 100 for that.
+#ifndef SERVICE_REQUEST_PERIOD_MS
+#define SERVICE_REQUEST_PERIOD_MS (0)
+#endif
+// Requests sent on each client per tick, if there are free slots.
+#define SERVICE_REQUESTS_PER_TICK (2)
+// A request with no response after this long is completed as timed out.
+#define SERVICE_REQUEST_TIMEOUT_MS (500)
+// Requests that can be in flight on each client.
+#define ASYNC_CLIENT_MAX_IN_FLIGHT (4)
+// Longest SetBool response message kept.  Longer ones fail to deserialise.
+#define SET_BOOL_MESSAGE_CAPACITY (32)
+// The agent can send the responses to all the in-flight requests at once, so
+// the reliable input stream needs room for them.
+#define APP_RMW_MAX_HISTORY ASYNC_CLIENT_MAX_IN_FLIGHT
+
+// Run the subscriptions, clients and services on a second executor, on their
+// own task pinned to the other core.  See common/executor_split.h.
+#ifndef APP_EXECUTOR_SPLIT
+#define APP_EXECUTOR_SPLIT (0)
+#endif
+
+// Send the battery state from a template serialised at start up, patching
+// just the voltage and stamp.  Off by default, as rmw_microxrcedds for
+// foxy can't publish serialised messages.  See common/msg_template.h.
+#ifndef APP_MSG_TEMPLATES
+#define APP_MSG_TEMPLATES (0)
+#endif
+
+// Create the entities without waiting for the agent to confirm each one.
+// Changes app-colcon.meta.  See common/entity_table.h.
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT (0)
+#endif
+
+// Time every executor callback and publish the histograms on
+// diagnostics/executor_profile.  See common/executor_profile.h.
+#ifndef APP_EXECUTOR_PROFILE
+#define APP_EXECUTOR_PROFILE (1)
+#endif
+
+// Publish the tasks' CPU and stack, the heap and the static arena use on
+// diagnostics/resources.  See common/resource_diag.h.
+#ifndef APP_RESOURCE_DIAG
+#define APP_RESOURCE_DIAG (1)
+#endif
+
+// Spin loop.  SPIN_MODE_EVENT or SPIN_MODE_POLL.  See common/app_spin.h.
+#define APP_SPIN_MODE SPIN_MODE_EVENT
+
+// rcl allocator.  APP_ALLOCATOR_STATIC or APP_ALLOCATOR_DEFAULT.  See
+// common/static_allocator.h.
+#define APP_ALLOCATOR APP_ALLOCATOR_STATIC
+
+// Deferred logging level for the hot paths.  See common/deferred_log.h.
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+
+#endif  // APP_CONFIG_H
@@ -0,0 +1,51 @@
+#ifndef APP_ENTITIES_H
+#define APP_ENTITIES_H
+
+/* Entities used by the services app.  See common/entity_table.h.
+ * ********** IMPORTANT: Run tools/gen_colcon_meta.bash after changing this
+ * file to update app-colcon.meta.  *********
+ */
+
+#include "app_config.h"
+#include "entity_table.h"
+
+#define APP_PUBLISHERS(PUBLISHER)                                      \
+  PUBLISHER(battery_state, sensor_msgs, BatteryState, "battery_state", \
+            ENTITY_QOS_RELIABLE)                                       \
+  ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                                 \
+  ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+
+// NOTE: "cmd_vel/1" caused add_subscriber to abort.
+#define APP_SUBSCRIPTIONS(SUBSCRIPTION)                      \
+  SUBSCRIPTION(cmd_vel_1, geometry_msgs, Twist, "cmd_vel_1", \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel_1)
+
+#define APP_CLIENTS(CLIENT)                                            \
+  CLIENT(set_bool_1, std_srvs, SetBool, "set_bool_1", client_callback) \
+  CLIENT(set_bool_2, std_srvs, SetBool, "set_bool_2", client_callback) \
+  CLIENT(set_bool_3, std_srvs, SetBool, "set_bool_3", client_callback)
+
+// The actuators this app controls.
+#define APP_SERVICES(SERVICE)                           \
+  SERVICE(actuator_1, std_srvs, SetBool, "actuator_1", \
+          service_callback_actuator)                   \
+  SERVICE(actuator_2, std_srvs, SetBool, "actuator_2", \
+          service_callback_actuator)                   \
+  SERVICE(actuator_3, std_srvs, SetBool, "actuator_3", \
+          service_callback_actuator)
+
+// Sends the SetBool requests, if turned on in app_config.h.
+#if SERVICE_REQUEST_PERIOD_MS > 0
+#define SERVICE_REQUEST_TIMERS(TIMER) \
+  TIMER(requests, SERVICE_REQUEST_PERIOD_MS, request_timer_callback)
+#else
+#define SERVICE_REQUEST_TIMERS(TIMER)
+#endif
+
+#define APP_TIMERS(TIMER)                                 \
+  TIMER(battery, BATTERY_TIMER_PERIOD_MS, timer_callback) \
+  SERVICE_REQUEST_TIMERS(TIMER)                           \
+  ENTITY_PROFILE_TIMERS(TIMER)                            \
+  ENTITY_DIAG_TIMERS(TIMER)
+
+#endif  // APP_ENTITIES_H
@@ -7,143 +7,138 @@
 #include <rclc/rclc.h>
 #include <rcutils/error_handling.h>
 #include <std_msgs/msg/int32.h>
-#include <stdio.h>
 #include <unistd.h>
 
+#include "app_config.h"
+#include "app_entities.h"
+#include "app_spin.h"
+#include "app_time.h"
+#include "cmd_vel_ack.h"
+#include "cmd_vel_mailbox.h"
+#include "connection_manager.h"
+#include "deferred_log.h"
+#include "entity_registry.h"
 #include "geometry_msgs/msg/twist.h"
+#include "motion_control.h"
+#include "msg_template.h"
+#include "publish_policy.h"
 #include "sensor_msgs/msg/battery_state.h"
+#include "static_allocator.h"
+#include "store_forward.h"
+#include "time_sync.h"
 
-#define RCCHECK(fn)                                                 \
-  {                                                                 \
-    rcl_ret_t temp_rc = fn;                                         \
-    if ((temp_rc != RCL_RET_OK)) {                                  \
-      printf("Failed status on line %d: %d. Aborting.\n", __LINE__, \
-             (int)temp_rc);                                         \
-      vTaskDelete(NULL);                                            \
-    }                                                               \
-  }
-#define RCSOFTCHECK(fn)                                               \
-  {                                                                   \
-    rcl_ret_t temp_rc = fn;                                           \
-    if ((temp_rc != RCL_RET_OK)) {                                    \
-      printf("Failed status on line %d: %d. Continuing.\n", __LINE__, \
-             (int)temp_rc);                                           \
-    }                                                                 \
-  }
-
-/* Number of executor handles.
- * Publishers don't count as they are driven by the timer.
- * ********** IMPORTANT: CHANGE VALUES IN app-colcon.meta.  *********
- */
-#define TIMER_HANDLE_COUNT (1)
-#define SUBSCRIBER_HANDLE_COUNT (6)
-#define EXECUTOR_HANDLE_COUNT (TIMER_HANDLE_COUNT + SUBSCRIBER_HANDLE_COUNT)
-
-rcl_publisher_t publisher_battery_state;
-rcl_subscription_t subscriber_cmd_vel_1;
-rcl_subscription_t subscriber_cmd_vel_2;
-rcl_subscription_t subscriber_cmd_vel_3;
-rcl_subscription_t subscriber_cmd_vel_4;
-rcl_subscription_t subscriber_cmd_vel_5;
-rcl_subscription_t subscriber_cmd_vel_6;
+// Publishers, subscribers, timers and callbacks are listed in app_entities.h.
+ENTITY_REGISTRY_DEFINE(entities)
+_Static_assert(APP_SUBSCRIPTION_COUNT == CMD_VEL_CHANNEL_COUNT,
+               "Need one subscriber per cmd_vel channel");
 
 // Logging name.
 static const char *TAG = "swarm_trooper";
-// Standard topic names.
-static const char *k_battery_state = "battery_state";
-// This caused add_subscriber to abort.
-// static const char *k_cmd_vel_1 = "cmd_vel/1";
-static const char *k_cmd_vel_1 = "cmd_vel_1";
-static const char *k_cmd_vel_2 = "cmd_vel_2";
-static const char *k_cmd_vel_3 = "cmd_vel_3";
-static const char *k_cmd_vel_4 = "cmd_vel_4";
-static const char *k_cmd_vel_5 = "cmd_vel_5";
-static const char *k_cmd_vel_6 = "cmd_vel_6";
 // Messages to publish.
-static sensor_msgs__msg__BatteryState *battery_state_msg = NULL;
-
-static void publish_battery_state(void) {
-  battery_state_msg->voltage = 1.3;
-  ESP_LOGI(TAG, "Sending msg: %f", battery_state_msg->voltage);
-  rcl_ret_t rc = rcl_publish(&publisher_battery_state, battery_state_msg, NULL);
-  RCLC_UNUSED(rc);
+static sensor_msgs__msg__BatteryState battery_state_msg;
+// battery_state_msg serialised once.  Only the voltage and stamp are patched.
+static msg_template_t battery_state_template;
+
+// Battery reading.  Kept in battery_store until it is sent.
+typedef struct {
+  int64_t time_us;
+  float voltage;
+} battery_sample_t;
+
+static bool publish_battery_state(const void *sample_in) {
+  const battery_sample_t *sample = (const battery_sample_t *)sample_in;
+  battery_state_msg.voltage = sample->voltage;
+  time_sync_stamp(&battery_state_msg.header.stamp, sample->time_us);
+  DLOG_I(TAG, "Sending msg: %f", battery_state_msg.voltage);
+  rcl_ret_t rc =
+      msg_template_publish(&battery_state_template, &publisher_battery_state);
+  app_spin_published();
+  return rc == RCL_RET_OK;
 }
 
+// Only the latest battery state matters, so a reconnect sends just one.
+STORE_FORWARD_DEFINE(battery_store, battery_sample_t, 1,
+                     STORE_FORWARD_COALESCE, publish_battery_state)
+static store_forward_t *const stores[] = {&battery_store};
+
+static const publish_policy_config_t battery_policy_config = {
+    .deadband = BATTERY_DEADBAND_V,
+    .relative_deadband = 0,
+    .max_silence_ms = BATTERY_MAX_SILENCE_MS,
+    .min_spacing_ms = 0,
+};
+static publish_policy_t battery_policy;
+
+/* Also called by the connection manager while offline, with a NULL timer.  The
+ * sample still goes into the store.
+ */
 static void timer_callback(rcl_timer_t *timer, int64_t last_call_time) {
-  ESP_LOGI(TAG, "Timer called.");
-  if (timer != NULL) {
-    publish_battery_state();
+  DLOG_I(TAG, "Timer called.");
+  battery_sample_t sample = {.time_us = app_time_us(), .voltage = 1.3};
+  if (publish_policy_check(&battery_policy, &sample.voltage, sample.time_us)) {
+    store_forward_submit(&battery_store, &sample,
+                         connection_manager_connected());
   }
+  publish_policy_report(&battery_policy, 1);
 }
 
-static void subscription_callback_cmd_vel_1(const void *msg_in) {
-  const geometry_msgs__msg__Twist *msg =
-      (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
-}
-
-static void subscription_callback_cmd_vel_2(const void *msg_in) {
-  const geometry_msgs__msg__Twist *msg =
-      (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
-}
-
-static void subscription_callback_cmd_vel_3(const void *msg_in) {
-  const geometry_msgs__msg__Twist *msg =
-      (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
-}
-
-static void subscription_callback_cmd_vel_4(const void *msg_in) {
-  const geometry_msgs__msg__Twist *msg =
-      (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
-}
-
-static void subscription_callback_cmd_vel_5(const void *msg_in) {
+/* Shared by all the cmd_vel subscribers.  The channel is found from the
+ * message buffer that the executor passes in.  The Twist is only stored in the
+ * channel's mailbox.  The motion control task acts on it at its own rate.
+ */
+static void subscription_callback_cmd_vel(const void *msg_in) {
   const geometry_msgs__msg__Twist *msg =
       (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
+  int channel = entity_registry_find_subscription(&entities, msg_in);
+  if (channel < 0) {
+    return;
+  }
+  cmd_vel_ack_record((size_t)channel, msg);
+  cmd_vel_mailbox_write((size_t)channel, msg);
+  DLOG_D(TAG, "%s %d called. ang.x %f", __func__, channel + 1,
+         msg->angular.x);
 }
 
-static void subscription_callback_cmd_vel_6(const void *msg_in) {
-  const geometry_msgs__msg__Twist *msg =
-      (const geometry_msgs__msg__Twist *)msg_in;
-  ESP_LOGI(TAG, "%s called. ang.x %f", __func__, msg->angular.x);
+#if CMD_VEL_ACK
+static void cmd_vel_ack_timer_callback(rcl_timer_t *timer,
+                                       int64_t last_call_time) {
+  if (timer != NULL) {
+    cmd_vel_ack_publish(&publisher_cmd_vel_ack);
+  }
 }
+#endif
 
 void appMain(void *arg) {
-  rcl_allocator_t allocator = rcl_get_default_allocator();
-  rclc_support_t support;
-
-  // Initialise messages.
-  battery_state_msg = sensor_msgs__msg__BatteryState__create();
+  // Start the deferred logging task first so that it is ready for the
+  // callbacks.
+  dlog_init();
 
-  // Create init_options
-  RCCHECK(rclc_support_init(&support, 0, NULL, &allocator));
+  // The arena allocator, if APP_ALLOCATOR is APP_ALLOCATOR_STATIC.
+  rcl_allocator_t allocator = static_allocator_init();
 
-  // Create node
-  rcl_node_t node = rcl_get_zero_initialized_node();
-  RCCHECK(rclc_node_init_default(&node, TAG, "", &support));
-
-  // Create publishers.
-  ESP_LOGI(TAG, "Creating publishers");
-
-  RCCHECK(rclc_publisher_init_default(
-      &publisher_battery_state, &node,
+  // Initialise messages.
+  sensor_msgs__msg__BatteryState__init(&battery_state_msg);
+  msg_template_init(
+      &battery_state_template, "battery_state",
       ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, BatteryState),
-      k_battery_state));
-
-  // Create subscribers.
-  ESP_LOGI(TAG, "Creating subscribers");
-  /* If rclc_subscription_init_default() fails, these are some of the return
-    values.  Most are defined in firmware/mcu_ws/install/include/rcl/types.h
-    1 = RCL_RET_ERROR = RMW_RET_ERROR - This is most common.
-    10 = RCL_RET_BAD_ALLOC = RMW_RET_BAD_ALLOC
-    11 = RCL_RET_INVALID_ARGUMENT
-    100 = RCL_RET_ALREADY_INIT
-    103 = RCL_RET_TOPIC_NAME_INVALID
-    200 = RCL_RET_NODE_INVALID
+      &battery_state_msg);
+  msg_template_add_field(&battery_state_template, &battery_state_msg.voltage,
+                         sizeof(battery_state_msg.voltage));
+  msg_template_add_field(&battery_state_template,
+                         &battery_state_msg.header.stamp,
+                         sizeof(battery_state_msg.header.stamp));
+  publish_policy_init(&battery_policy, "battery_state", 1,
+                      &battery_policy_config);
+
+  cmd_vel_ack_init();
+
+  // Start acting on the cmd_vel messages.  The channels stop by themselves
+  // while the agent can't be reached.
+  motion_control_init();
+
+  /* Create the entities whenever the agent can be reached.  Never returns.
+    If an entity fails to be created, entity_registry_init() prints its name
+    and the return value.  See common/entity_registry.c for the common values.
     Most errors originate from rcl_subscription_init in
     firmware/mcu_ws/uros/rcl/rcl/src/rcl/subscription.c
 
@@ -152,98 +147,19 @@ void appMain(void *arg) {
     $ ros2 run micro_ros_setup build_firmware.sh
     NOTE: The build is slow, so put lots of debugging in one go and then rebuild.
   */
+  const connection_manager_config_t config = {
+      .registry = &entities,
+      .node_name = TAG,
+      .allocator = &allocator,
+      .on_connected = NULL,
+      .on_disconnected = NULL,
+      .stores = stores,
+      .store_count = sizeof(stores) / sizeof(stores[0]),
+  };
+  connection_manager_run(&config);
 
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_1, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_1));
-
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_2, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_2));
-      // Fails here with two subs. Both subs work one at a time but not together.
-      // The first subscriber works but the second fails.
-      // Therefore it is nothing to do with the code but is something else.
-
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_3, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_3));
-
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_4, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_4));
-
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_5, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_5));
-
-  RCCHECK(rclc_subscription_init_default(
-      &subscriber_cmd_vel_5, &node,
-      ROSIDL_GET_MSG_TYPE_SUPPORT(geometry_msgs, msg, Twist), k_cmd_vel_6));
-
-  // Create timer.
-  ESP_LOGI(TAG, "Creating timers");
-  rcl_timer_t timer = rcl_get_zero_initialized_timer();
-  const unsigned int timer_timeout_ms = 1000;
-  RCCHECK(rclc_timer_init_default(&timer, &support, RCL_MS_TO_NS(timer_timeout_ms),
-                                  timer_callback));
-
-  // Create executor.
-  ESP_LOGI(TAG, "Creating executor");
-  rclc_executor_t executor = rclc_executor_get_zero_initialized_executor();
-  RCCHECK(rclc_executor_init(&executor, &support.context, EXECUTOR_HANDLE_COUNT,
-                             &allocator));
-  unsigned int rcl_wait_timeout_ms = 1000;  // in ms
-  RCCHECK(rclc_executor_set_timeout(&executor, RCL_MS_TO_NS(rcl_wait_timeout_ms)));
-  RCCHECK(rclc_executor_add_timer(&executor, &timer));
-
-  ESP_LOGI(TAG, "Adding subs");
-  geometry_msgs__msg__Twist twist_msg_1;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_1, &twist_msg_1,
-      &subscription_callback_cmd_vel_1, ON_NEW_DATA));
-
-  geometry_msgs__msg__Twist twist_msg_2;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_2, &twist_msg_2,
-      &subscription_callback_cmd_vel_2, ON_NEW_DATA));
-
-  geometry_msgs__msg__Twist twist_msg_3;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_3, &twist_msg_3,
-      &subscription_callback_cmd_vel_3, ON_NEW_DATA));
-
-  geometry_msgs__msg__Twist twist_msg_4;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_4, &twist_msg_4,
-      &subscription_callback_cmd_vel_4, ON_NEW_DATA));
-
-  geometry_msgs__msg__Twist twist_msg_5;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_5, &twist_msg_5,
-      &subscription_callback_cmd_vel_5, ON_NEW_DATA));
-
-  geometry_msgs__msg__Twist twist_msg_6;
-  RCCHECK(rclc_executor_add_subscription(
-      &executor, &subscriber_cmd_vel_6, &twist_msg_6,
-      &subscription_callback_cmd_vel_6, ON_NEW_DATA));
-
-  // Spin forever.
-  ESP_LOGI(TAG, "Spinning...");
-  while (1) {
-    rclc_executor_spin(&executor);
-  }
   // Probably never get here but this is for completeness.
-  // Free resources.
-  ESP_LOGI(TAG, "Free resources");
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_6, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_5, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_4, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_3, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_2, &node));
-  RCCHECK(rcl_subscription_fini(&subscriber_cmd_vel_1, &node));
-  RCCHECK(rcl_publisher_fini(&publisher_battery_state, &node))
-  RCCHECK(rcl_node_fini(&node))
-  sensor_msgs__msg__BatteryState__destroy(battery_state_msg);
+  sensor_msgs__msg__BatteryState__fini(&battery_state_msg);
   // Delete this task!
   vTaskDelete(NULL);
 }
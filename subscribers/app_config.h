@@ -0,0 +1,99 @@
+#ifndef APP_CONFIG_H
+#define APP_CONFIG_H
+
+/* Build options for the subscribers app.
+ * Options that change app_entities.h change app-colcon.meta, so run
+ * tools/gen_colcon_meta.bash and do a full rebuild after changing them.
+ */
+
+// Period of the timer that publishes the battery state.
+#define BATTERY_TIMER_PERIOD_MS (1000)
+// Only send the battery state when the voltage moves by more than
+// BATTERY_DEADBAND_V, or nothing has been sent for BATTERY_MAX_SILENCE_MS.  A
+// deadband of -1 sends every reading.  See common/publish_policy.h.
+#ifndef BATTERY_DEADBAND_V
+#define BATTERY_DEADBAND_V (0.02)
+#endif
+#ifndef BATTERY_MAX_SILENCE_MS
+#define BATTERY_MAX_SILENCE_MS (5000)
+#endif
+
+// Number of cmd_vel channels.  One subscriber each.
+#define CMD_VEL_CHANNEL_COUNT (6)
+// Period of the motion control loop that reads the cmd_vel mailboxes.
+#define MOTION_CONTROL_PERIOD_MS (20)
+// A channel is stopped if no cmd_vel is received for this long.
+#define CMD_VEL_TIMEOUT_MS (500)
+
+/* When the motion control task takes a new set of commands.  Each period it
+ * reads all the mailboxes before driving any channel, then takes the new set
+ * if the trigger fires or drives the channels with the previous set if not.
+ *   CMD_VEL_TRIGGER_ALWAYS      Every period, the newest value of each channel.
+ *   CMD_VEL_TRIGGER_ANY         Any channel has a new command.
+ *   CMD_VEL_TRIGGER_ALL         Every channel has a new command.
+ *   CMD_VEL_TRIGGER_CHANNEL(n)  Channel n, 1 to CMD_VEL_CHANNEL_COUNT, has a
+ *                               new command.
+ * See subscribers/motion_control.h.
+ */
+#define CMD_VEL_TRIGGER_ALWAYS (0)
+#define CMD_VEL_TRIGGER_ANY (-1)
+#define CMD_VEL_TRIGGER_ALL (-2)
+#define CMD_VEL_TRIGGER_CHANNEL(n) (n)
+#ifndef CMD_VEL_TRIGGER
+#define CMD_VEL_TRIGGER CMD_VEL_TRIGGER_ALWAYS
+#endif
+
+// Publish an acknowledgement of each tagged cmd_vel for
+// tools/cmd_vel_replay.py.  Changes app-colcon.meta.  See
+// subscribers/cmd_vel_ack.h.
+#ifndef CMD_VEL_ACK
+#define CMD_VEL_ACK (0)
+#endif
+// How often the acknowledgements are sent.
+#define CMD_VEL_ACK_PERIOD_MS (50)
+// Acknowledgements kept between sends.  Must be a power of 2.  They are all
+// sent in one message, 16 bytes each, which must fit in the reliable stream.
+#define CMD_VEL_ACK_CAPACITY (64)
+
+// Run the subscriptions, clients and services on a second executor, on their
+// own task pinned to the other core.  See common/executor_split.h.
+#ifndef APP_EXECUTOR_SPLIT
+#define APP_EXECUTOR_SPLIT (0)
+#endif
+
+// Send the battery state from a template serialised at start up, patching
+// just the voltage and stamp.  Off by default, as rmw_microxrcedds for
+// foxy can't publish serialised messages.  See common/msg_template.h.
+#ifndef APP_MSG_TEMPLATES
+#define APP_MSG_TEMPLATES (0)
+#endif
+
+// Create the entities without waiting for the agent to confirm each one.
+// Changes app-colcon.meta.  See common/entity_table.h.
+#ifndef APP_FAST_BOOT
+#define APP_FAST_BOOT (0)
+#endif
+
+// Time every executor callback and publish the histograms on
+// diagnostics/executor_profile.  See common/executor_profile.h.
+#ifndef APP_EXECUTOR_PROFILE
+#define APP_EXECUTOR_PROFILE (1)
+#endif
+
+// Publish the tasks' CPU and stack, the heap and the static arena use on
+// diagnostics/resources.  See common/resource_diag.h.
+#ifndef APP_RESOURCE_DIAG
+#define APP_RESOURCE_DIAG (1)
+#endif
+
+// Spin loop.  SPIN_MODE_EVENT or SPIN_MODE_POLL.  See common/app_spin.h.
+#define APP_SPIN_MODE SPIN_MODE_EVENT
+
+// rcl allocator.  APP_ALLOCATOR_STATIC or APP_ALLOCATOR_DEFAULT.  See
+// common/static_allocator.h.
+#define APP_ALLOCATOR APP_ALLOCATOR_STATIC
+
+// Deferred logging level for the hot paths.  See common/deferred_log.h.
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+
+#endif  // APP_CONFIG_H
@@ -0,0 +1,56 @@
+#ifndef APP_ENTITIES_H
+#define APP_ENTITIES_H
+
+/* Entities used by the subscribers app.  See common/entity_table.h.
+ * ********** IMPORTANT: Run tools/gen_colcon_meta.bash after changing this
+ * file to update app-colcon.meta.  *********
+ */
+
+#include "app_config.h"
+#include "entity_table.h"
+
+// Acknowledgements for tools/cmd_vel_replay.py.  See cmd_vel_ack.h.
+#if CMD_VEL_ACK
+#define CMD_VEL_ACK_PUBLISHERS(PUBLISHER)                               \
+  PUBLISHER(cmd_vel_ack, std_msgs, UInt32MultiArray, "cmd_vel_ack", \
+            ENTITY_QOS_RELIABLE)
+#define CMD_VEL_ACK_TIMERS(TIMER) \
+  TIMER(cmd_vel_ack, CMD_VEL_ACK_PERIOD_MS, cmd_vel_ack_timer_callback)
+#else
+#define CMD_VEL_ACK_PUBLISHERS(PUBLISHER)
+#define CMD_VEL_ACK_TIMERS(TIMER)
+#endif
+
+#define APP_PUBLISHERS(PUBLISHER)                                      \
+  PUBLISHER(battery_state, sensor_msgs, BatteryState, "battery_state", \
+            ENTITY_QOS_RELIABLE)                                       \
+  CMD_VEL_ACK_PUBLISHERS(PUBLISHER)                                    \
+  ENTITY_PROFILE_PUBLISHERS(PUBLISHER)                                 \
+  ENTITY_DIAG_PUBLISHERS(PUBLISHER)
+
+// NOTE: "cmd_vel/1" caused add_subscriber to abort.
+#define APP_SUBSCRIPTIONS(SUBSCRIPTION)                          \
+  SUBSCRIPTION(cmd_vel_1, geometry_msgs, Twist, "cmd_vel_1",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel) \
+  SUBSCRIPTION(cmd_vel_2, geometry_msgs, Twist, "cmd_vel_2",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel) \
+  SUBSCRIPTION(cmd_vel_3, geometry_msgs, Twist, "cmd_vel_3",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel) \
+  SUBSCRIPTION(cmd_vel_4, geometry_msgs, Twist, "cmd_vel_4",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel) \
+  SUBSCRIPTION(cmd_vel_5, geometry_msgs, Twist, "cmd_vel_5",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel) \
+  SUBSCRIPTION(cmd_vel_6, geometry_msgs, Twist, "cmd_vel_6",     \
+               ENTITY_QOS_RELIABLE, subscription_callback_cmd_vel)
+
+#define APP_CLIENTS(CLIENT)
+
+#define APP_SERVICES(SERVICE)
+
+#define APP_TIMERS(TIMER)                                 \
+  TIMER(battery, BATTERY_TIMER_PERIOD_MS, timer_callback) \
+  CMD_VEL_ACK_TIMERS(TIMER)                               \
+  ENTITY_PROFILE_TIMERS(TIMER)                            \
+  ENTITY_DIAG_TIMERS(TIMER)
+
+#endif  // APP_ENTITIES_H
@@ -0,0 +1,88 @@
+#include "cmd_vel_ack.h"
+
+#include "app_time.h"
+#include "connection_manager.h"
+#include "spsc_ring.h"
+#include "time_sync.h"
+#include "u32_array.h"
+
+#if CMD_VEL_ACK
+#define HEADER_SIZE (3)
+#define ACK_SIZE (4)
+#define MESSAGE_SIZE (HEADER_SIZE + CMD_VEL_ACK_CAPACITY * ACK_SIZE)
+
+typedef struct {
+  uint32_t channel;
+  uint32_t tag;
+  int64_t time_us;
+} ack_t;
+
+static ack_t ack_buffer[CMD_VEL_ACK_CAPACITY];
+static spsc_ring_t acks;
+// Acks popped from the ring but not sent because the publish failed.
+static uint32_t publish_lost = 0;
+static std_msgs__msg__UInt32MultiArray ack_msg;
+static uint32_t ack_data[MESSAGE_SIZE];
+
+void cmd_vel_ack_init(void) {
+  spsc_ring_init(&acks, ack_buffer, sizeof(ack_t), CMD_VEL_ACK_CAPACITY);
+  u32_array_init(&ack_msg, ack_data, MESSAGE_SIZE);
+}
+
+void cmd_vel_ack_record(size_t channel,
+                        const geometry_msgs__msg__Twist *twist) {
+  double tag = twist->linear.z;
+  ack_t ack = {
+      .channel = (uint32_t)channel + 1,
+      .tag = (tag >= 1 && tag <= UINT32_MAX) ? (uint32_t)tag : 0,
+      .time_us = app_time_us(),
+  };
+  if (ack.tag != 0) {
+    // A full ring counts the ack as lost.
+    (void)spsc_ring_push(&acks, &ack);
+  }
+}
+
+void cmd_vel_ack_publish(const rcl_publisher_t *publisher) {
+  // Leave the acks on the ring until they can be sent.
+  if (!connection_manager_connected()) {
+    return;
+  }
+  uint32_t *data = ack_data + HEADER_SIZE;
+  uint32_t count = 0;
+  ack_t ack;
+  while (count < CMD_VEL_ACK_CAPACITY && spsc_ring_pop(&acks, &ack)) {
+    int64_t epoch_ns = time_sync_epoch_ns(ack.time_us);
+    *data++ = ack.channel;
+    *data++ = ack.tag;
+    *data++ = (uint32_t)(epoch_ns / 1000000000);
+    *data++ = (uint32_t)(epoch_ns % 1000000000);
+    count++;
+  }
+  if (count == 0) {
+    return;
+  }
+  ack_data[0] = CMD_VEL_ACK_VERSION;
+  ack_data[1] = atomic_load(&acks.overruns) + publish_lost;
+  ack_data[2] = count;
+  if (u32_array_publish(&ack_msg, "cmd_vel_ack", publisher,
+                        HEADER_SIZE + count * ACK_SIZE) != RCL_RET_OK) {
+    publish_lost += count;
+  }
+}
+
+#else
+
+void cmd_vel_ack_init(void) {}
+
+void cmd_vel_ack_record(size_t channel,
+                        const geometry_msgs__msg__Twist *twist) {
+  (void)channel;
+  (void)twist;
+}
+
+void cmd_vel_ack_publish(const rcl_publisher_t *publisher) {
+  (void)publisher;
+}
+
+#endif  // CMD_VEL_ACK
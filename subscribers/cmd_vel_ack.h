@@ -0,0 +1,44 @@
+#ifndef CMD_VEL_ACK_H
+#define CMD_VEL_ACK_H
+
+/* Acknowledgements of cmd_vel messages, for tools/cmd_vel_replay.py.
+ *
+ * With CMD_VEL_ACK set to 1 in app_config.h, the cmd_vel callback records the
+ * channel, the tag and the time of each message it is called with.  The tag
+ * is the whole number the replayer puts in linear.z, which the motion control
+ * doesn't use.  0 means untagged.  The record goes on a lock-free ring, so the
+ * callback stays cheap and can be on the other executor (see
+ * executor_split.h).
+ *
+ * Every CMD_VEL_ACK_PERIOD_MS the cmd_vel_ack timer empties the ring into a
+ * std_msgs/UInt32MultiArray on `cmd_vel_ack`.  The layout, all uint32:
+ *   version, acks lost since start up, ack count,
+ *   then for each ack: channel (1 to CMD_VEL_CHANNEL_COUNT), tag, callback
+ *   time seconds and nanoseconds.
+ * The callback time is in the agent's clock (see time_sync.h), and 0 before
+ * the first sync.  An ack is lost if the ring is full or its publish fails, so
+ * the replayer can tell a lost ack from a lost message.  While the agent can't
+ * be reached the acks stay on the ring, and only the ones that don't fit are
+ * lost.
+ *
+ * Adds a publisher and a timer to app_entities.h, so regenerate
+ * app-colcon.meta after changing CMD_VEL_ACK.
+ */
+
+#include <rcl/rcl.h>
+#include <stddef.h>
+
+#include "app_config.h"
+#include "geometry_msgs/msg/twist.h"
+
+#define CMD_VEL_ACK_VERSION (1)
+
+// Call before the executor runs.
+void cmd_vel_ack_init(void);
+// Called by the cmd_vel callback, on the executor that runs it.
+void cmd_vel_ack_record(size_t channel,
+                        const geometry_msgs__msg__Twist *twist);
+// Called by the cmd_vel_ack timer.  Does nothing while offline.
+void cmd_vel_ack_publish(const rcl_publisher_t *publisher);
+
+#endif  // CMD_VEL_ACK_H
@@ -0,0 +1,65 @@
+#include "cmd_vel_mailbox.h"
+
+#include <stdatomic.h>
+
+#include "app_time.h"
+
+typedef struct {
+  // Odd while a write is in progress.
+  atomic_uint sequence;
+  cmd_vel_sample_t sample;
+} cmd_vel_mailbox_t;
+
+// Attempts to get a consistent copy before giving up.
+#define READ_ATTEMPTS (3)
+
+static cmd_vel_mailbox_t mailboxes[CMD_VEL_CHANNEL_COUNT];
+// Last consistent copy of each mailbox.  Only used by the reader.
+static cmd_vel_sample_t last_read[CMD_VEL_CHANNEL_COUNT];
+
+void cmd_vel_mailbox_write(size_t channel,
+                           const geometry_msgs__msg__Twist *twist) {
+  if (channel >= CMD_VEL_CHANNEL_COUNT) {
+    return;
+  }
+  cmd_vel_mailbox_t *mailbox = &mailboxes[channel];
+  unsigned int sequence =
+      atomic_load_explicit(&mailbox->sequence, memory_order_relaxed);
+  atomic_store_explicit(&mailbox->sequence, sequence + 1,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  mailbox->sample.twist = *twist;
+  mailbox->sample.time_us = app_time_us();
+  mailbox->sample.count++;
+  atomic_store_explicit(&mailbox->sequence, sequence + 2,
+                        memory_order_release);
+}
+
+bool cmd_vel_mailbox_read(size_t channel, cmd_vel_sample_t *sample) {
+  if (channel >= CMD_VEL_CHANNEL_COUNT) {
+    return false;
+  }
+  cmd_vel_mailbox_t *mailbox = &mailboxes[channel];
+  for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+    unsigned int before =
+        atomic_load_explicit(&mailbox->sequence, memory_order_acquire);
+    if (before & 1) {
+      // Write in progress.
+      continue;
+    }
+    cmd_vel_sample_t copy = mailbox->sample;
+    atomic_thread_fence(memory_order_acquire);
+    unsigned int after =
+        atomic_load_explicit(&mailbox->sequence, memory_order_relaxed);
+    if (before == after) {
+      last_read[channel] = copy;
+      break;
+    }
+  }
+  /* If the reader has preempted the writer in the middle of a write, spinning
+   * here would never end, so use the previous copy.  The new value is picked
+   * up on the next read.
+   */
+  *sample = last_read[channel];
+  return sample->count != 0;
+}
@@ -0,0 +1,38 @@
+#ifndef CMD_VEL_MAILBOX_H
+#define CMD_VEL_MAILBOX_H
+
+/* Latest-value mailboxes for the cmd_vel channels.
+ *
+ * The cmd_vel callback writes each Twist into its channel's mailbox and the
+ * motion control task reads them.  Each mailbox is a seqlock: the writer
+ * never waits and a newer message simply replaces an older one, so a burst of
+ * messages collapses to the newest value.  The reader never waits either: if
+ * it overlaps a write it gets the previous value.  There must only be one
+ * writer, the executor task, and one reader, the motion control task.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "app_config.h"
+#include "geometry_msgs/msg/twist.h"
+
+typedef struct {
+  geometry_msgs__msg__Twist twist;
+  // Time the message was received (app_time_us()).
+  int64_t time_us;
+  // Number of messages received on this channel.
+  uint32_t count;
+} cmd_vel_sample_t;
+
+// Store the newest message for a channel.  Called from the executor.
+void cmd_vel_mailbox_write(size_t channel,
+                           const geometry_msgs__msg__Twist *twist);
+
+/* Copy the newest message for a channel into `sample`.  Never blocks.
+ * Returns false if nothing has been received on the channel yet.
+ */
+bool cmd_vel_mailbox_read(size_t channel, cmd_vel_sample_t *sample);
+
+#endif  // CMD_VEL_MAILBOX_H
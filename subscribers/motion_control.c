@@ -0,0 +1,178 @@
+#include "motion_control.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <stdbool.h>
+
+#include "app_config.h"
+#include "app_time.h"
+#include "cmd_vel_mailbox.h"
+#include "deferred_log.h"
+#include "histogram.h"
+
+#define TASK_STACK_SIZE (3072)
+// Higher than the executor task so that the control loop is not delayed by
+// network traffic.
+#define TASK_PRIORITY (tskIDLE_PRIORITY + 6)
+// Period between statistics reports.
+#define REPORT_PERIOD_MS (10000)
+
+static const char *TAG = "motion";
+
+#if CMD_VEL_TRIGGER > CMD_VEL_CHANNEL_COUNT || \
+    CMD_VEL_TRIGGER < CMD_VEL_TRIGGER_ALL
+#error "CMD_VEL_TRIGGER must be a CMD_VEL_TRIGGER_* value or a channel number"
+#endif
+#define ALL_CHANNELS ((UINT32_C(1) << CMD_VEL_CHANNEL_COUNT) - 1)
+
+typedef struct {
+  // Value of cmd_vel_sample_t.count last time the channel was read.
+  uint32_t last_count;
+  // Messages replaced by a newer one before the control loop used them.
+  uint32_t collapsed;
+  bool stopped;
+} channel_state_t;
+
+static channel_state_t channels[CMD_VEL_CHANNEL_COUNT];
+// Commands the channels are driven with.  Only replaced as a whole.
+static cmd_vel_sample_t command_set[CMD_VEL_CHANNEL_COUNT];
+
+// Since the last report.
+static histogram_t start_lateness;
+static uint32_t triggered = 0;
+static uint32_t held = 0;
+
+/* Drive one channel.  Placeholder until the motor drivers are added.
+ * Runs every period so must be quick and must not block.
+ */
+static void apply_command(size_t channel,
+                          const geometry_msgs__msg__Twist *twist) {
+  DLOG_D(TAG, "channel %u lin.x %f ang.z %f", (unsigned int)(channel + 1),
+         twist->linear.x, twist->angular.z);
+}
+
+/* Copy every mailbox before anything is driven.  Returns a bit for each
+ * channel with a command that isn't in the command set yet.
+ */
+static uint32_t take_snapshot(cmd_vel_sample_t *snapshot) {
+  uint32_t fresh = 0;
+  for (size_t i = 0; i < CMD_VEL_CHANNEL_COUNT; i++) {
+    if (cmd_vel_mailbox_read(i, &snapshot[i]) &&
+        snapshot[i].count != channels[i].last_count) {
+      fresh |= UINT32_C(1) << i;
+    }
+  }
+  return fresh;
+}
+
+static bool trigger_fired(uint32_t fresh) {
+#if CMD_VEL_TRIGGER == CMD_VEL_TRIGGER_ALWAYS
+  return true;
+#elif CMD_VEL_TRIGGER == CMD_VEL_TRIGGER_ANY
+  return fresh != 0;
+#elif CMD_VEL_TRIGGER == CMD_VEL_TRIGGER_ALL
+  return fresh == ALL_CHANNELS;
+#else
+  return (fresh & (UINT32_C(1) << (CMD_VEL_TRIGGER - 1))) != 0;
+#endif
+}
+
+// Make the snapshot the command set.
+static void take_command_set(const cmd_vel_sample_t *snapshot,
+                             uint32_t fresh) {
+  for (size_t i = 0; i < CMD_VEL_CHANNEL_COUNT; i++) {
+    if (!(fresh & (UINT32_C(1) << i))) {
+      continue;
+    }
+    channel_state_t *state = &channels[i];
+    state->collapsed += snapshot[i].count - state->last_count - 1;
+    state->last_count = snapshot[i].count;
+    command_set[i] = snapshot[i];
+  }
+}
+
+static void control_channel(size_t channel, int64_t now_us) {
+  static const geometry_msgs__msg__Twist stop = {0};
+  channel_state_t *state = &channels[channel];
+  const cmd_vel_sample_t *sample = &command_set[channel];
+  if (sample->count == 0) {
+    // Nothing received yet.
+    return;
+  }
+  if (now_us - sample->time_us > (int64_t)CMD_VEL_TIMEOUT_MS * 1000) {
+    if (!state->stopped) {
+      DLOG_W(TAG, "channel %u timed out, stopping",
+             (unsigned int)(channel + 1));
+      state->stopped = true;
+    }
+    apply_command(channel, &stop);
+    return;
+  }
+  state->stopped = false;
+  apply_command(channel, &sample->twist);
+}
+
+static void report(uint32_t overruns) {
+  uint32_t collapsed = 0;
+  for (size_t i = 0; i < CMD_VEL_CHANNEL_COUNT; i++) {
+    collapsed += channels[i].collapsed;
+  }
+  DLOG_I(TAG, "%u commands collapsed, %u overruns", collapsed, overruns);
+  DLOG_I(TAG,
+         "%u sets taken, %u held, start lateness p50 %u us, p99 %u us, "
+         "max %u us",
+         triggered, held, histogram_percentile(&start_lateness, 50.0),
+         histogram_percentile(&start_lateness, 99.0), start_lateness.max);
+  histogram_reset(&start_lateness);
+  triggered = 0;
+  held = 0;
+}
+
+static void motion_control_task(void *arg) {
+  const TickType_t period = pdMS_TO_TICKS(MOTION_CONTROL_PERIOD_MS);
+  TickType_t last_wake = xTaskGetTickCount();
+  int64_t report_us = app_time_us();
+  uint32_t overruns = 0;
+  // The steps are due at first_us + n * period.  The first one is the
+  // reference, so the lateness is relative to it.
+  int64_t first_us = 0;
+  uint32_t steps = 0;
+  histogram_reset(&start_lateness);
+  while (1) {
+    vTaskDelayUntil(&last_wake, period);
+    int64_t start_us = app_time_us();
+    if (steps == 0) {
+      first_us = start_us;
+    }
+    cmd_vel_sample_t snapshot[CMD_VEL_CHANNEL_COUNT];
+    uint32_t fresh = take_snapshot(snapshot);
+    if (trigger_fired(fresh)) {
+      take_command_set(snapshot, fresh);
+      triggered++;
+    } else {
+      held++;
+    }
+    int64_t drive_us = app_time_us();
+    int64_t lateness_us = drive_us - first_us -
+                          (int64_t)steps * MOTION_CONTROL_PERIOD_MS * 1000;
+    histogram_record(&start_lateness,
+                     lateness_us > 0 ? (uint32_t)lateness_us : 0);
+    steps++;
+    for (size_t i = 0; i < CMD_VEL_CHANNEL_COUNT; i++) {
+      control_channel(i, drive_us);
+    }
+    int64_t end_us = app_time_us();
+    if (end_us - start_us > (int64_t)MOTION_CONTROL_PERIOD_MS * 1000) {
+      overruns++;
+    }
+    if (end_us - report_us >= (int64_t)REPORT_PERIOD_MS * 1000) {
+      report(overruns);
+      report_us = end_us;
+    }
+  }
+}
+
+void motion_control_init(void) {
+  xTaskCreate(motion_control_task, "motion", TASK_STACK_SIZE, NULL,
+              TASK_PRIORITY, NULL);
+}
@@ -0,0 +1,22 @@
+#ifndef MOTION_CONTROL_H
+#define MOTION_CONTROL_H
+
+/* Fixed rate motion control task.
+ *
+ * Every MOTION_CONTROL_PERIOD_MS, independently of when the messages arrived,
+ * the task first copies the newest command for every cmd_vel channel out of
+ * the mailboxes.  If CMD_VEL_TRIGGER fires on that snapshot it becomes the
+ * command set, otherwise the previous set is kept, so the channels are always
+ * driven from commands taken at the same instant.  Then each channel is
+ * driven.  A channel that has not had a command for CMD_VEL_TIMEOUT_MS is
+ * stopped.
+ *
+ * The lateness of each control step, from its ideal start on the fixed period
+ * to the first channel being driven, is reported with the trigger counts every
+ * 10 seconds.
+ */
+
+// Start the motion control task.
+void motion_control_init(void);
+
+#endif  // MOTION_CONTROL_H
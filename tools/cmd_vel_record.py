@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""Record the cmd_vel channels to a file for tools/cmd_vel_replay.py.
+
+Subscribes to cmd_vel_1 to cmd_vel_N and writes every Twist, with the time it
+arrived, to a compact binary file.  Stop with Ctrl-C or --duration.
+
+The file is little endian.  A header:
+    magic b'CVEL', version (uint16), channel count (uint16)
+then one 53 byte record per message:
+    microseconds since the previous record (uint32), channel, 1 to N (uint8),
+    linear x, y, z, angular x, y, z (6 float64).
+
+To record someone driving with teleop_twist_keyboard, remap its topic to one
+of the channels.  Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/cmd_vel_record.py drive.cvel
+    ros2 run teleop_twist_keyboard teleop_twist_keyboard \\
+        --ros-args -r cmd_vel:=cmd_vel_1
+"""
+
+import argparse
+import struct
+import threading
+import time
+
+from geometry_msgs.msg import Twist
+import rclpy
+from rclpy.node import Node
+
+MAGIC = b'CVEL'
+VERSION = 1
+HEADER = struct.Struct('<4sHH')
+RECORD = struct.Struct('<IB6d')
+
+
+class CmdVelRecorder(Node):
+
+    def __init__(self, output, channels):
+        super().__init__('cmd_vel_record')
+        self._output = output
+        self._lock = threading.Lock()
+        self._last_ns = None
+        self.counts = [0] * channels
+        output.write(HEADER.pack(MAGIC, VERSION, channels))
+        for channel in range(1, channels + 1):
+            self.create_subscription(
+                Twist, 'cmd_vel_%d' % channel,
+                lambda msg, channel=channel: self._record(channel, msg), 100)
+
+    def _record(self, channel, msg):
+        now_ns = time.monotonic_ns()
+        with self._lock:
+            if self._last_ns is None:
+                self._last_ns = now_ns
+            delta_us = min((now_ns - self._last_ns) // 1000, 0xffffffff)
+            # Keep the rounding error from adding up over the recording.
+            self._last_ns += delta_us * 1000
+            self._output.write(RECORD.pack(
+                delta_us, channel, msg.linear.x, msg.linear.y, msg.linear.z,
+                msg.angular.x, msg.angular.y, msg.angular.z))
+            self.counts[channel - 1] += 1
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Record the cmd_vel channels to a file.')
+    parser.add_argument('output')
+    parser.add_argument('--channels', type=int, default=6)
+    parser.add_argument('--duration', type=float, default=0,
+                        help='Seconds to record, 0 until Ctrl-C')
+    args = parser.parse_args()
+
+    rclpy.init()
+    with open(args.output, 'wb') as output:
+        node = CmdVelRecorder(output, args.channels)
+        start = time.monotonic()
+        try:
+            while rclpy.ok() and (args.duration <= 0 or
+                                  time.monotonic() - start < args.duration):
+                rclpy.spin_once(node, timeout_sec=0.1)
+        except KeyboardInterrupt:
+            pass
+        node.get_logger().info('Recorded %d messages in %.1f s: %s' % (
+            sum(node.counts), time.monotonic() - start,
+            ', '.join('cmd_vel_%d %d' % (i + 1, count)
+                      for i, count in enumerate(node.counts))))
+        node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Replay a tools/cmd_vel_record.py file into the subscribers app.
+
+Publishes the recorded Twists on cmd_vel_1 to cmd_vel_N with the recorded
+timing, scaled by --speed, or as fast as it can with --speed 0.  Each message
+is tagged with its number, from 1, in linear.z, which the motion control
+doesn't use.
+
+Build the subscribers app with CMD_VEL_ACK set to 1 (see
+subscribers/cmd_vel_ack.h) and it acks each tagged message with the agent time
+its callback ran.  After the last message and --grace seconds for the acks,
+this prints per channel the messages sent, acked and dropped, and the latency
+from publishing to the callback.  The latency needs the app synced to the
+agent's clock, and the agent on this machine.  An ack the app couldn't send is
+counted apart from the drops.  It also prints how late the replay itself was
+against the recording, as a late replay drives the app more gently than the
+recording did.
+
+With --output the results are appended as a JSON line, to compare builds.
+
+Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/cmd_vel_replay.py drive.cvel --speed 2
+"""
+
+import argparse
+import json
+import statistics
+import struct
+import threading
+import time
+
+from geometry_msgs.msg import Twist
+import rclpy
+from rclpy.executors import SingleThreadedExecutor
+from rclpy.node import Node
+from std_msgs.msg import UInt32MultiArray
+
+MAGIC = b'CVEL'
+VERSION = 1
+HEADER = struct.Struct('<4sHH')
+RECORD = struct.Struct('<IB6d')
+ACK_VERSION = 1
+ACK_HEADER_SIZE = 3
+ACK_SIZE = 4
+
+
+def load(path):
+    """Return the channel count and a list of (time us, channel, fields)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if len(data) < HEADER.size:
+        raise SystemExit('%s is too short' % path)
+    magic, version, channels = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise SystemExit('%s is not a version %d cmd_vel recording' % (
+            path, VERSION))
+    records = []
+    time_us = 0
+    for offset in range(HEADER.size, len(data) - RECORD.size + 1,
+                        RECORD.size):
+        delta_us, channel, *fields = RECORD.unpack_from(data, offset)
+        time_us += delta_us
+        records.append((time_us, channel, fields))
+    return channels, records
+
+
+def percentile(values, fraction):
+    values = sorted(values)
+    return values[min(int(len(values) * fraction), len(values) - 1)]
+
+
+def summary_ms(values_ns):
+    if not values_ns:
+        return None
+    ms = [value / 1e6 for value in values_ns]
+    return {
+        'min': min(ms),
+        'mean': statistics.mean(ms),
+        'p50': percentile(ms, 0.5),
+        'p99': percentile(ms, 0.99),
+        'max': max(ms),
+    }
+
+
+class CmdVelReplay(Node):
+
+    def __init__(self, channels, depth):
+        super().__init__('cmd_vel_replay')
+        self.publishers_ = [
+            self.create_publisher(Twist, 'cmd_vel_%d' % channel, depth)
+            for channel in range(1, channels + 1)]
+        self._lock = threading.Lock()
+        # Tag to (channel, publish time in ns since the epoch).
+        self.sent = {}
+        # Tag to callback time in ns since the epoch, 0 if not synced.
+        self.acked = {}
+        self.acks_lost = 0
+        self.create_subscription(UInt32MultiArray, 'cmd_vel_ack',
+                                 self._ack_callback, 100)
+
+    def wait_for_app(self, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            if all(p.get_subscription_count() > 0 for p in self.publishers_):
+                return True
+            time.sleep(0.1)
+        return False
+
+    def publish(self, tag, channel, fields):
+        msg = Twist()
+        (msg.linear.x, msg.linear.y, _, msg.angular.x, msg.angular.y,
+         msg.angular.z) = fields
+        msg.linear.z = float(tag)
+        with self._lock:
+            self.sent[tag] = (channel, time.time_ns())
+        self.publishers_[channel - 1].publish(msg)
+
+    def _ack_callback(self, msg):
+        data = list(msg.data)
+        if len(data) < ACK_HEADER_SIZE or data[0] != ACK_VERSION:
+            self.get_logger().warning('Unknown cmd_vel_ack version')
+            return
+        _, acks_lost, count = data[:ACK_HEADER_SIZE]
+        with self._lock:
+            self.acks_lost = max(self.acks_lost, acks_lost)
+            for i in range(count):
+                offset = ACK_HEADER_SIZE + i * ACK_SIZE
+                _, tag, sec, nanosec = data[offset:offset + ACK_SIZE]
+                self.acked.setdefault(tag, sec * 1000000000 + nanosec)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Replay a cmd_vel recording and report the acks.')
+    parser.add_argument('input')
+    parser.add_argument('--speed', type=float, default=1.0,
+                        help='Times the recorded speed, 0 as fast as possible')
+    parser.add_argument('--grace', type=float, default=2.0,
+                        help='Seconds to wait for acks after the last message')
+    parser.add_argument('--depth', type=int, default=100,
+                        help='Publisher history depth')
+    parser.add_argument('--output', help='Append the results as a JSON line')
+    parser.add_argument('--label', default='',
+                        help='Label for the JSON line, e.g. the build')
+    args = parser.parse_args()
+
+    channels, records = load(args.input)
+    if not records:
+        raise SystemExit('%s has no messages' % args.input)
+
+    rclpy.init()
+    node = CmdVelReplay(channels, args.depth)
+    executor = SingleThreadedExecutor()
+    executor.add_node(node)
+    spinner = threading.Thread(target=executor.spin, daemon=True)
+    spinner.start()
+    log = node.get_logger()
+
+    if not node.wait_for_app(10.0):
+        log.warning('Not every cmd_vel channel has a subscriber, replaying '
+                    'anyway')
+
+    late_ns = []
+    start_ns = time.monotonic_ns()
+    for tag, (time_us, channel, fields) in enumerate(records, 1):
+        if args.speed > 0:
+            due_ns = start_ns + int(time_us * 1000 / args.speed)
+            wait_ns = due_ns - time.monotonic_ns()
+            if wait_ns > 0:
+                time.sleep(wait_ns / 1e9)
+            late_ns.append(max(time.monotonic_ns() - due_ns, 0))
+        node.publish(tag, channel, fields)
+    replay_s = (time.monotonic_ns() - start_ns) / 1e9
+    time.sleep(args.grace)
+
+    with node._lock:
+        sent = dict(node.sent)
+        acked = dict(node.acked)
+        acks_lost = node.acks_lost
+
+    results = {
+        'input': args.input,
+        'label': args.label,
+        'speed': args.speed,
+        'messages': len(records),
+        'recorded_s': records[-1][0] / 1e6,
+        'replay_s': replay_s,
+        'acks_lost': acks_lost,
+        'send_late_ms': summary_ms(late_ns),
+        'channels': {},
+    }
+    log.info('Replayed %d messages in %.2f s (recorded over %.2f s), %d acks '
+             'lost by the app' % (len(records), replay_s,
+                                  results['recorded_s'], acks_lost))
+    if late_ns:
+        late = results['send_late_ms']
+        log.info('  Replay late by mean %.3f ms, p99 %.3f ms, max %.3f ms' % (
+            late['mean'], late['p99'], late['max']))
+    for channel in range(1, channels + 1):
+        tags = [tag for tag, (c, _) in sent.items() if c == channel]
+        if not tags:
+            continue
+        latencies = [acked[tag] - sent[tag][1] for tag in tags
+                     if acked.get(tag)]
+        acked_count = sum(1 for tag in tags if tag in acked)
+        latency = summary_ms(latencies)
+        results['channels'][channel] = {
+            'sent': len(tags),
+            'acked': acked_count,
+            'dropped': len(tags) - acked_count,
+            'latency_ms': latency,
+        }
+        line = '  cmd_vel_%d: %d sent, %d acked, %d dropped' % (
+            channel, len(tags), acked_count, len(tags) - acked_count)
+        if latency:
+            line += (', latency min %.2f mean %.2f p50 %.2f p99 %.2f max '
+                     '%.2f ms' % (latency['min'], latency['mean'],
+                                  latency['p50'], latency['p99'],
+                                  latency['max']))
+        log.info(line)
+    if not acked:
+        log.warning('No acks, build the subscribers app with CMD_VEL_ACK 1')
+    elif acks_lost:
+        log.warning('The app lost %d acks, so some drops are only lost acks'
+                    % acks_lost)
+
+    if args.output:
+        with open(args.output, 'a') as f:
+            f.write(json.dumps(results) + '\n')
+
+    executor.shutdown()
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
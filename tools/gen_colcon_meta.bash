@@ -0,0 +1,56 @@
+#!/bin/bash
+# Generate app-colcon.meta from the entity table in app_entities.h.
+# Usage: gen_colcon_meta.bash [--host | --host-local] <app directory>
+#            [-DOPTION=VALUE ...]
+# Any -D options are passed to the compiler so that build options in
+# app_config.h can be overridden.
+# --host generates host-colcon.meta for the Linux build over UDP instead, and
+# --host-local generates host-local-colcon.meta for its local transport.  See
+# docker/build_host.bash.
+set -e
+
+meta_name=app-colcon.meta
+meta_define=""
+case "$1" in
+--host)
+    meta_name=host-colcon.meta
+    meta_define=-DCOLCON_META_HOST
+    shift
+    ;;
+--host-local)
+    meta_name=host-local-colcon.meta
+    meta_define=-DCOLCON_META_HOST_LOCAL
+    shift
+    ;;
+esac
+
+if [ $# -lt 1 ]
+then
+    echo "Usage: $0 [--host | --host-local] <app directory> [-DOPTION=VALUE ...]"
+    exit 1
+fi
+
+tools_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &>/dev/null && pwd )"
+app_dir="$( cd "$1" &>/dev/null && pwd )"
+shift
+meta=${app_dir}/${meta_name}
+tmp_dir=$(mktemp -d)
+trap "rm -rf ${tmp_dir}" EXIT
+
+cc ${meta_define} -I ${tools_dir}/../common -I ${app_dir} "$@" \
+    -o ${tmp_dir}/gen_colcon_meta ${tools_dir}/gen_colcon_meta.c
+${tmp_dir}/gen_colcon_meta > ${tmp_dir}/${meta_name}
+
+if cmp -s ${tmp_dir}/${meta_name} ${meta}
+then
+    echo "${meta} is up to date."
+else
+    cp -f ${tmp_dir}/${meta_name} ${meta}
+    echo "${meta} updated."
+    if [ -z "${meta_define}" ]
+    then
+        echo "IMPORTANT: Changes to app-colcon.meta need a full rebuild:"
+        echo "ros2 run micro_ros_setup configure_firmware.sh <app> -t udp -i <agent IP> -p 8888"
+        echo "ros2 run micro_ros_setup build_firmware.sh"
+    fi
+fi
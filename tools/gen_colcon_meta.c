@@ -0,0 +1,57 @@
+/* Print the app-colcon.meta for an app, generated from its app_entities.h.
+ * Built and run on the host by gen_colcon_meta.bash.  With -DCOLCON_META_HOST
+ * it prints the meta for the Linux build instead, which also sets the UDP
+ * transport to an agent on 127.0.0.1.  With -DCOLCON_META_HOST_LOCAL it sets
+ * the local transport, see host/local_transport.h.  docker/build_host.bash
+ * and tools/tuning_matrix.bash use those.
+ */
+#include <stdio.h>
+
+#include "app_entities.h"
+
+int main(void) {
+  printf("{\n");
+  printf("    \"names\": {\n");
+  printf("        \"microxrcedds_client\": {\n");
+  printf("            \"cmake-args\": [\n");
+#ifdef COLCON_META_HOST_LOCAL
+  // The local transport is a byte stream, so it needs the serial framing.
+  printf("                \"-DUCLIENT_PROFILE_CUSTOM_TRANSPORT=ON\",\n");
+  printf("                \"-DUCLIENT_PROFILE_STREAM_FRAMING=ON\",\n");
+  printf("                \"-DUCLIENT_CUSTOM_TRANSPORT_MTU=%d\",\n",
+         APP_TRANSPORT_MTU);
+#else
+  printf("                \"-DUCLIENT_UDP_TRANSPORT_MTU=%d\",\n",
+         APP_TRANSPORT_MTU);
+#endif
+  printf("            ]\n");
+  printf("        },\n");
+  printf("        \"rmw_microxrcedds\": {\n");
+  printf("            \"cmake-args\": [\n");
+#if defined(COLCON_META_HOST)
+  printf("                \"-DRMW_UXRCE_TRANSPORT=udp\",\n");
+  printf("                \"-DRMW_UXRCE_DEFAULT_UDP_IP=127.0.0.1\",\n");
+  printf("                \"-DRMW_UXRCE_DEFAULT_UDP_PORT=8888\",\n");
+#elif defined(COLCON_META_HOST_LOCAL)
+  printf("                \"-DRMW_UXRCE_TRANSPORT=custom\",\n");
+#endif
+  printf("                \"-DRMW_UXRCE_MAX_NODES=%d\",\n", APP_NODE_COUNT);
+  printf("                \"-DRMW_UXRCE_MAX_PUBLISHERS=%d\",\n",
+         APP_PUBLISHER_COUNT);
+  printf("                \"-DRMW_UXRCE_MAX_SUBSCRIPTIONS=%d\",\n",
+         APP_SUBSCRIPTION_COUNT);
+  printf("                \"-DRMW_UXRCE_MAX_SERVICES=%d\",\n",
+         APP_SERVICE_COUNT);
+  printf("                \"-DRMW_UXRCE_MAX_CLIENTS=%d\",\n", APP_CLIENT_COUNT);
+  printf("                \"-DRMW_UXRCE_MAX_HISTORY=%d\",\n",
+         APP_RMW_MAX_HISTORY);
+  printf("                \"-DRMW_UXRCE_STREAM_HISTORY=%d\",\n",
+         APP_RMW_STREAM_HISTORY);
+  printf("                \"-DRMW_UXRCE_ENTITY_CREATION_DESTROY_TIMEOUT"
+         "=%d\",\n", APP_ENTITY_CREATION_TIMEOUT_MS);
+  printf("            ]\n");
+  printf("        }\n");
+  printf("    }\n");
+  printf("}\n");
+  return 0;
+}
@@ -0,0 +1,99 @@
+#!/bin/bash
+# Run an app against an agent on this machine over the local transport, so
+# the results leave out Wi-Fi and the IP stack.
+# Usage: local_bench.bash <app> [output.jsonl]
+# Run in the docker after setup_host.bash and build_host.bash --local <app>.
+# Starts its own agent, and the echo node for the latency app.  The latency app stops
+# by itself when its sweep is done.  The other apps are stopped after
+# DURATION_S seconds.  The BENCH lines go to the output file.
+#
+# MODE=pty (the default) connects the app straight to the agent's pty.
+# MODE=unix goes through a UNIX domain socket, joined to the agent's serial
+# port with socat.  For steadier numbers, set CPUS to the cores for the agent
+# and the app, e.g. CPUS=2,3, so they don't move around.
+set -e
+
+if [ $# -lt 1 ]
+then
+    echo "Usage: $0 <app> [output.jsonl]"
+    exit 1
+fi
+app=$1
+output=$(realpath "${2:-local_bench.jsonl}")
+MODE=${MODE:-pty}
+DURATION_S=${DURATION_S:-60}
+
+tools_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &>/dev/null && pwd )"
+tmp_dir=$(mktemp -d)
+pids=""
+trap 'kill ${pids} 2>/dev/null; rm -rf ${tmp_dir}' EXIT
+
+source /opt/ros/foxy/setup.bash
+source ~/host_ws/install/local_setup.bash
+export RMW_IMPLEMENTATION=rmw_microxrcedds
+
+agent_pin=""
+app_pin=""
+if [ -n "${CPUS}" ]
+then
+    IFS=, read agent_cpu app_cpu <<< "${CPUS}"
+    agent_pin="taskset -c ${agent_cpu}"
+    app_pin="taskset -c ${app_cpu}"
+fi
+
+case ${MODE} in
+pty)
+    ${agent_pin} ros2 run micro_ros_agent micro_ros_agent pty \
+        > ${tmp_dir}/agent.log 2>&1 &
+    pids="${pids} $!"
+    # The agent prints the pty it opened.
+    for i in $(seq 50)
+    do
+        device=$(grep -o '/dev/pts/[0-9]*' ${tmp_dir}/agent.log | head -1)
+        [ -n "${device}" ] && break
+        sleep 0.1
+    done
+    ;;
+unix)
+    # socat makes the pty first, then waits for the app on the socket.
+    socat PTY,link=${tmp_dir}/agent_pty,raw,echo=0 \
+        UNIX-LISTEN:${tmp_dir}/agent.sock > ${tmp_dir}/socat.log 2>&1 &
+    pids="${pids} $!"
+    for i in $(seq 50)
+    do
+        [ -e ${tmp_dir}/agent_pty ] && break
+        sleep 0.1
+    done
+    ${agent_pin} ros2 run micro_ros_agent micro_ros_agent serial \
+        --dev ${tmp_dir}/agent_pty > ${tmp_dir}/agent.log 2>&1 &
+    pids="${pids} $!"
+    device=unix:${tmp_dir}/agent.sock
+    ;;
+*)
+    echo "MODE must be pty or unix"
+    exit 1
+    ;;
+esac
+if [ -z "${device}" ]
+then
+    cat ${tmp_dir}/agent.log
+    echo "The agent didn't start"
+    exit 1
+fi
+echo "Agent on ${device}"
+
+if [ "${app}" == "latency" ]
+then
+    python3 ${tools_dir}/pingpong_echo.py > ${tmp_dir}/echo.log 2>&1 &
+    pids="${pids} $!"
+    timeout=0
+else
+    timeout=${DURATION_S}
+fi
+
+rm -f ${output}
+HOST_AGENT_DEVICE=${device} BENCH_OUTPUT=${output} \
+    timeout --preserve-status ${timeout} \
+    ${app_pin} ros2 run micro_ros_esp32_test_host ${app} || true
+
+echo "Results in ${output}"
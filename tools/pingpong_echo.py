@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Echo the latency app's pings back to it.
+
+The latency app publishes std_msgs/UInt8MultiArray pings on
+`latency/ping_reliable` and `latency/ping_best_effort`.  Each ping is sent
+straight back, unchanged, on the matching `latency/pong_*` topic with the same
+QoS.  The app works out the round trip times from the timestamp in the ping.
+
+Start this before the app, as the app waits for its first pong before starting
+the sweep.  Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/pingpong_echo.py
+"""
+
+import rclpy
+from rclpy.node import Node
+from rclpy.qos import QoSProfile
+from rclpy.qos import QoSReliabilityPolicy
+from std_msgs.msg import UInt8MultiArray
+
+
+class PingPongEcho(Node):
+
+    def __init__(self):
+        super().__init__('pingpong_echo')
+        self.declare_parameter('topic_prefix', 'latency/')
+        prefix = self.get_parameter('topic_prefix').value
+        self._echoes = []
+        for name, reliability in (
+                ('reliable', QoSReliabilityPolicy.RELIABLE),
+                ('best_effort', QoSReliabilityPolicy.BEST_EFFORT)):
+            qos = QoSProfile(depth=10, reliability=reliability)
+            publisher = self.create_publisher(
+                UInt8MultiArray, prefix + 'pong_' + name, qos)
+            self._echoes.append(self.create_subscription(
+                UInt8MultiArray, prefix + 'ping_' + name,
+                lambda msg, publisher=publisher: publisher.publish(msg), qos))
+
+
+def main():
+    rclpy.init()
+    node = PingPongEcho()
+    try:
+        rclpy.spin(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""Print the executor profiles published by the apps.
+
+With APP_EXECUTOR_PROFILE the apps time every executor callback and publish
+the figures on `diagnostics/executor_profile` as a UInt32MultiArray.  See
+common/executor_profile.h for the layout.  For each message this prints, per
+executor, the time spent waiting in spin_some, in the callbacks and idle, then
+per handle the call count, mean, max and the p50/p99 estimated from the
+histogram.  A percentile is given as the upper edge of its bucket, so it is at
+most twice the real value.
+
+The handles are numbered by kind in the order of the app's app_entities.h,
+e.g. timer 0 is the first TIMER().  Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/profile_dump.py
+"""
+
+import rclpy
+from rclpy.node import Node
+from std_msgs.msg import UInt32MultiArray
+
+VERSION = 1
+HEADER_SIZE = 5
+EXECUTOR_SIZE = 4
+EXECUTORS = ['main', 'command']
+KINDS = ['timer', 'subscription', 'client', 'service']
+
+
+def bucket_limit_us(first_bucket_us, bucket):
+    return first_bucket_us << bucket
+
+
+def percentile_us(buckets, first_bucket_us, percent):
+    count = sum(buckets)
+    target = count * percent / 100.0
+    total = 0
+    for bucket, calls in enumerate(buckets):
+        total += calls
+        if total >= target:
+            if bucket == len(buckets) - 1:
+                # The last bucket has no upper edge.
+                return '>%d' % bucket_limit_us(first_bucket_us, bucket - 1)
+            return '<%d' % bucket_limit_us(first_bucket_us, bucket)
+    return '-'
+
+
+def decode(data):
+    """Return a list of report lines for one message."""
+    if len(data) < HEADER_SIZE or data[0] != VERSION:
+        return ['Unknown profile version']
+    _, slot_count, bucket_count, first_bucket_us, period_ms = data[:5]
+    lines = ['Period %d ms' % period_ms]
+    offset = HEADER_SIZE
+    for name in EXECUTORS:
+        spins, spin_us, callback_us, idle_us = data[offset:offset + 4]
+        offset += EXECUTOR_SIZE
+        if spins:
+            lines.append(
+                '  %s executor: %d spins, waiting %.1f ms, callbacks %.1f ms, '
+                'idle %.1f ms' % (name, spins, (spin_us - callback_us) / 1e3,
+                                  callback_us / 1e3, idle_us / 1e3))
+    for _ in range(slot_count):
+        kind, index, calls, total_us, max_us = data[offset:offset + 5]
+        buckets = data[offset + 5:offset + 5 + bucket_count]
+        offset += 5 + bucket_count
+        label = '%s %d' % (KINDS[kind] if kind < len(KINDS) else kind, index)
+        if calls == 0:
+            lines.append('  %s: no calls' % label)
+            continue
+        lines.append(
+            '  %s: %d calls, mean %d us, max %d us, p50 %s us, p99 %s us' % (
+                label, calls, total_us // calls, max_us,
+                percentile_us(buckets, first_bucket_us, 50),
+                percentile_us(buckets, first_bucket_us, 99)))
+    return lines
+
+
+class ProfileDump(Node):
+
+    def __init__(self):
+        super().__init__('profile_dump')
+        self.create_subscription(UInt32MultiArray,
+                                 'diagnostics/executor_profile',
+                                 self._callback, 10)
+
+    def _callback(self, msg):
+        for line in decode(list(msg.data)):
+            self.get_logger().info(line)
+
+
+def main():
+    rclpy.init()
+    node = ProfileDump()
+    try:
+        rclpy.spin(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
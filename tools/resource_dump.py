@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""Print the resource diagnostics published by the apps.
+
+With APP_RESOURCE_DIAG the apps sample their tasks, heap and static arena and
+publish them on `diagnostics/resources` as a UInt32MultiArray.  See
+common/resource_diag.h for the layout.  For each message this prints the
+heap and the arena, then per task the share of one core it used over
+the period and the bytes of its stack it has never touched.  Values the app
+couldn't measure are shown as '-'.
+
+Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/resource_dump.py
+"""
+
+import rclpy
+from rclpy.node import Node
+from std_msgs.msg import UInt32MultiArray
+
+VERSION = 2
+HEADER_SIZE = 8
+NAME_WORDS = 4
+TASK_SIZE = NAME_WORDS + 2
+UNKNOWN = 0xffffffff
+
+
+def value(number, fmt='%d'):
+    return '-' if number == UNKNOWN else fmt % number
+
+
+def task_name(words):
+    chars = b''.join(word.to_bytes(4, 'little') for word in words)
+    return chars.split(b'\0', 1)[0].decode('ascii', 'replace')
+
+
+def decode(data):
+    """Return a list of report lines for one message."""
+    if len(data) < HEADER_SIZE or data[0] != VERSION:
+        return ['Unknown resource diagnostics version']
+    (_, period_ms, heap_free, heap_min_free, heap_largest, arena_used,
+     arena_size, task_count) = data[:HEADER_SIZE]
+    lines = ['Period %d ms, heap %s bytes free, %s at the least, largest '
+             'block %s' % (period_ms, value(heap_free), value(heap_min_free),
+                           value(heap_largest))]
+    if arena_size != UNKNOWN:
+        lines.append('  Arena %d/%d bytes in use' % (arena_used, arena_size))
+    offset = HEADER_SIZE
+    for _ in range(task_count):
+        words = data[offset:offset + NAME_WORDS]
+        cpu_per_mille, stack_free = data[offset + NAME_WORDS:
+                                         offset + TASK_SIZE]
+        offset += TASK_SIZE
+        cpu = '-' if cpu_per_mille == UNKNOWN else '%.1f' % (
+            cpu_per_mille / 10.0)
+        stack = '-' if stack_free == 0 else '%d' % stack_free
+        lines.append('  %-16s CPU %5s%%, stack %6s bytes free' % (
+            task_name(words), cpu, stack))
+    return lines
+
+
+class ResourceDump(Node):
+
+    def __init__(self):
+        super().__init__('resource_dump')
+        self.create_subscription(UInt32MultiArray, 'diagnostics/resources',
+                                 self._callback, 10)
+
+    def _callback(self, msg):
+        for line in decode(list(msg.data)):
+            self.get_logger().info(line)
+
+
+def main():
+    rclpy.init()
+    node = ResourceDump()
+    try:
+        rclpy.spin(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
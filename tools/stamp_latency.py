@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""Report how old the apps' messages are when they reach the host.
+
+The apps stamp each outgoing header with the agent's clock, synced by
+common/time_sync.c.  For each topic this node works out:
+    latency: receive time - header stamp.  The time from the reading being
+        taken on the robot to it arriving here, including any time spent in
+        the app's store while the agent couldn't be reached.
+    gap: the longest time between two messages.
+    age: how old the newest reading was at the end of the period.
+The figures are logged every `report_period` seconds.  Messages with a zero
+stamp were sent before the app had synced and are only counted.
+
+The stamps are in the agent's clock, so run this on the same machine as the
+agent, or one synced to it with NTP.  Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/stamp_latency.py
+"""
+
+import rclpy
+from rclpy.node import Node
+from rclpy.qos import qos_profile_sensor_data
+from sensor_msgs.msg import BatteryState
+from sensor_msgs.msg import LaserScan
+from sensor_msgs.msg import Range
+
+# Topics published by the apps.  Not all of them exist at once.
+TOPICS = [('sensors/tof_batch', LaserScan), ('battery_state', BatteryState)]
+TOPICS += [('sensors/tof%d' % i, Range) for i in range(1, 7)]
+
+
+def percentile(values, percent):
+    index = min(len(values) - 1, int(len(values) * percent / 100.0))
+    return values[index]
+
+
+class TopicStats:
+
+    def __init__(self):
+        self.latencies_ms = []
+        self.unsynced = 0
+        self.max_gap_ms = 0.0
+        self.last_receive_ns = None
+        self.newest_stamp_ns = None
+
+    def record(self, stamp_ns, receive_ns):
+        if self.last_receive_ns is not None:
+            self.max_gap_ms = max(
+                self.max_gap_ms, (receive_ns - self.last_receive_ns) / 1e6)
+        self.last_receive_ns = receive_ns
+        if stamp_ns == 0:
+            self.unsynced += 1
+            return
+        self.latencies_ms.append((receive_ns - stamp_ns) / 1e6)
+        if self.newest_stamp_ns is None or stamp_ns > self.newest_stamp_ns:
+            self.newest_stamp_ns = stamp_ns
+
+    def report(self, now_ns):
+        count = len(self.latencies_ms) + self.unsynced
+        if count == 0:
+            return None
+        text = '%d msgs' % count
+        if self.unsynced:
+            text += ', %d unsynced' % self.unsynced
+        if self.latencies_ms:
+            values = sorted(self.latencies_ms)
+            text += (', latency ms min %.1f mean %.1f p50 %.1f p99 %.1f '
+                     'max %.1f' % (
+                         values[0], sum(values) / len(values),
+                         percentile(values, 50), percentile(values, 99),
+                         values[-1]))
+            text += ', age %.1f ms' % ((now_ns - self.newest_stamp_ns) / 1e6)
+        text += ', max gap %.1f ms' % self.max_gap_ms
+        # Start the next period.  The last receive time carries over so the
+        # first gap of the next period is measured.
+        self.latencies_ms = []
+        self.unsynced = 0
+        self.max_gap_ms = 0.0
+        return text
+
+
+class StampLatency(Node):
+
+    def __init__(self):
+        super().__init__('stamp_latency')
+        self.declare_parameter('report_period', 10.0)
+        self._stats = {}
+        for topic, msg_type in TOPICS:
+            self._stats[topic] = TopicStats()
+            # Best effort matches both reliable and best effort publishers.
+            self.create_subscription(
+                msg_type, topic,
+                lambda msg, topic=topic: self._callback(topic, msg),
+                qos_profile_sensor_data)
+        self.create_timer(
+            float(self.get_parameter('report_period').value), self._report)
+
+    def _callback(self, topic, msg):
+        receive_ns = self.get_clock().now().nanoseconds
+        stamp_ns = msg.header.stamp.sec * 1000000000 + msg.header.stamp.nanosec
+        self._stats[topic].record(stamp_ns, receive_ns)
+
+    def _report(self):
+        now_ns = self.get_clock().now().nanoseconds
+        for topic, stats in self._stats.items():
+            text = stats.report(now_ns)
+            if text is not None:
+                self.get_logger().info('%s: %s' % (topic, text))
+
+
+def main():
+    rclpy.init()
+    node = StampLatency()
+    try:
+        rclpy.spin(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
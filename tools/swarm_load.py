@@ -0,0 +1,334 @@
+#!/usr/bin/env python3
+"""Find how many troopers one agent can carry.
+
+Starts an agent and then more and more copies of a trooper app from the
+Linux build, each in its own process with its own XRCE session, client key
+and node namespace (trooper_1, trooper_2 and so on, set with
+HOST_NODE_NAMESPACE and HOST_CLIENT_KEY).  This node plays the rest of the
+swarm: it sends each trooper cmd_vel, answers its SetBool requests and
+listens to its battery state.
+
+The troopers are added `step` at a time up to `max`.  After each step it
+waits `hold` seconds and then records, over the next `hold` seconds:
+    agent CPU (% of one core) and resident memory, from /proc.
+    troopers up: process running, node in the graph, battery state received
+        and no SetBool timeouts.
+    SetBool round trip: average and max over all troopers, and the worst
+        trooper's average, from the troopers' BENCH lines.  The services app
+        reports every 10 s, so keep `hold` above that.
+One CSV row per step.  The first step with a trooper down is where sessions
+start failing.  The ramp stops after `stop_after` failed steps in a row.
+
+Run in the docker after setup_host.bash and build_host.bash with the trooper
+app, with nothing else using UDP port 8888.  The services troopers only send
+SetBool requests when built with SERVICE_REQUEST_PERIOD_MS set, e.g.
+build_host.bash services SERVICE_REQUEST_PERIOD_MS=100.  This node talks to
+the agent over DDS, so leave RMW_IMPLEMENTATION unset here.  The troopers get
+it set for them.
+    . ~/host_ws/install/local_setup.bash
+    python3 tools/swarm_load.py --max 40 --step 4 --output swarm.csv
+The agent and the troopers are all on this machine, so the CPU they take
+from each other is part of the result.  Use --cpus to keep the agent on its
+own core.
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import tempfile
+import threading
+import time
+
+from geometry_msgs.msg import Twist
+import rclpy
+from rclpy.executors import MultiThreadedExecutor
+from rclpy.node import Node
+from sensor_msgs.msg import BatteryState
+from std_srvs.srv import SetBool
+
+APP_PACKAGE = 'micro_ros_esp32_test_host'
+TROOPER_NODE = 'swarm_trooper'
+# The SetBool services each trooper app calls, and its cmd_vel topics.
+APPS = {
+    'services': {'set_bool': 3, 'cmd_vel': 1},
+    'subscribers': {'set_bool': 0, 'cmd_vel': 6},
+}
+
+
+def executable(package, name):
+    prefix = subprocess.check_output(
+        ['ros2', 'pkg', 'prefix', package], text=True).strip()
+    return os.path.join(prefix, 'lib', package, name)
+
+
+class AgentStats:
+    """CPU and memory of one process, from /proc."""
+
+    def __init__(self, pid):
+        self._pid = pid
+        self._ticks_per_s = os.sysconf('SC_CLK_TCK')
+        self._start = None
+
+    def _cpu_ticks(self):
+        with open('/proc/%d/stat' % self._pid) as stat:
+            # The command name can have spaces, so count from the ')'.
+            fields = stat.read().rsplit(')', 1)[1].split()
+        return int(fields[11]) + int(fields[12])
+
+    def start(self):
+        self._start = (time.monotonic(), self._cpu_ticks())
+
+    def cpu_percent(self):
+        wall = time.monotonic() - self._start[0]
+        ticks = self._cpu_ticks() - self._start[1]
+        return 100.0 * ticks / self._ticks_per_s / wall
+
+    def rss_kb(self):
+        with open('/proc/%d/status' % self._pid) as status:
+            for line in status:
+                if line.startswith('VmRSS:'):
+                    return int(line.split()[1])
+        return 0
+
+
+class Trooper:
+
+    def __init__(self, index, app_path, tmp_dir, cpu):
+        self.index = index
+        self.namespace = 'trooper_%d' % index
+        self.bench_path = os.path.join(tmp_dir, self.namespace + '.jsonl')
+        self._bench_offset = 0
+        env = dict(os.environ)
+        env['HOST_NODE_NAMESPACE'] = self.namespace
+        env['HOST_CLIENT_KEY'] = str(0x10000 + index)
+        env['BENCH_OUTPUT'] = self.bench_path
+        env['RMW_IMPLEMENTATION'] = 'rmw_microxrcedds'
+        command = [app_path]
+        if cpu is not None:
+            command = ['taskset', '-c', cpu] + command
+        self._log = open(os.path.join(tmp_dir, self.namespace + '.log'), 'w')
+        self.process = subprocess.Popen(
+            command, env=env, stdout=self._log, stderr=subprocess.STDOUT)
+
+    def running(self):
+        return self.process.poll() is None
+
+    def new_bench_lines(self):
+        """The BENCH lines written since the last call."""
+        try:
+            with open(self.bench_path) as bench:
+                bench.seek(self._bench_offset)
+                text = bench.read()
+                self._bench_offset = bench.tell()
+        except FileNotFoundError:
+            return []
+        return [json.loads(line) for line in text.splitlines() if line]
+
+    def stop(self):
+        self.process.terminate()
+        try:
+            self.process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+        self._log.close()
+
+
+class Swarm(Node):
+    """The swarm's side of each trooper's topics and services."""
+
+    def __init__(self, app, cmd_vel_hz):
+        super().__init__('swarm_load')
+        self._app = APPS[app]
+        self._lock = threading.Lock()
+        self._battery_counts = {}
+        self._cmd_vel = []
+        self._twist = Twist()
+        self.create_timer(1.0 / cmd_vel_hz, self._send_cmd_vel)
+
+    def add_trooper(self, namespace):
+        with self._lock:
+            self._battery_counts[namespace] = 0
+        self.create_subscription(
+            BatteryState, '/%s/battery_state' % namespace,
+            lambda msg, namespace=namespace: self._battery(namespace), 10)
+        for i in range(1, self._app['cmd_vel'] + 1):
+            self._cmd_vel.append(self.create_publisher(
+                Twist, '/%s/cmd_vel_%d' % (namespace, i), 10))
+        for i in range(1, self._app['set_bool'] + 1):
+            self.create_service(
+                SetBool, '/%s/set_bool_%d' % (namespace, i), self._set_bool)
+
+    def _battery(self, namespace):
+        with self._lock:
+            self._battery_counts[namespace] += 1
+
+    def take_battery_counts(self):
+        with self._lock:
+            counts = dict(self._battery_counts)
+            for namespace in self._battery_counts:
+                self._battery_counts[namespace] = 0
+        return counts
+
+    def _send_cmd_vel(self):
+        self._twist.angular.x += 0.01
+        for publisher in self._cmd_vel:
+            publisher.publish(self._twist)
+
+    def _set_bool(self, request, response):
+        response.success = True
+        response.message = 'on' if request.data else 'off'
+        return response
+
+    def troopers_in_graph(self):
+        return {namespace.lstrip('/')
+                for name, namespace in self.get_node_names_and_namespaces()
+                if name == TROOPER_NODE}
+
+
+def measure(swarm, troopers, agent, hold):
+    """Run one measurement window and return the CSV row."""
+    swarm.take_battery_counts()
+    for trooper in troopers:
+        trooper.new_bench_lines()
+    agent.start()
+    time.sleep(hold)
+    cpu = agent.cpu_percent()
+    batteries = swarm.take_battery_counts()
+    in_graph = swarm.troopers_in_graph()
+
+    up = 0
+    down = []
+    sum_us = 0
+    completed = 0
+    max_us = 0
+    worst_average_us = 0
+    timeouts = 0
+    for trooper in troopers:
+        trooper_completed = 0
+        trooper_sum_us = 0
+        trooper_timeouts = 0
+        for line in trooper.new_bench_lines():
+            if 'client' not in line:
+                continue
+            trooper_completed += line['completed']
+            trooper_sum_us += line['round_trip_avg_us'] * line['completed']
+            trooper_timeouts += line['timed_out']
+            max_us = max(max_us, line['round_trip_max_us'])
+        if trooper_completed:
+            worst_average_us = max(worst_average_us,
+                                   trooper_sum_us / trooper_completed)
+        completed += trooper_completed
+        sum_us += trooper_sum_us
+        timeouts += trooper_timeouts
+        if (trooper.running() and trooper.namespace in in_graph and
+                batteries.get(trooper.namespace, 0) > 0 and
+                trooper_timeouts == 0):
+            up += 1
+        else:
+            down.append(trooper.namespace)
+    return {
+        'troopers': len(troopers),
+        'up': up,
+        'agent_cpu_pct': round(cpu, 1),
+        'agent_rss_kb': agent.rss_kb(),
+        'battery_msgs': sum(batteries.values()),
+        'set_bool_completed': completed,
+        'set_bool_timeouts': timeouts,
+        'round_trip_avg_us': round(sum_us / completed) if completed else 0,
+        'round_trip_max_us': max_us,
+        'worst_trooper_avg_us': round(worst_average_us),
+        'down': ' '.join(down),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Ramp up troopers against one agent.')
+    parser.add_argument('--app', default='services', choices=sorted(APPS))
+    parser.add_argument('--max', type=int, default=32)
+    parser.add_argument('--step', type=int, default=4)
+    parser.add_argument('--hold', type=float, default=30.0,
+                        help='Seconds to settle, then to measure, per step')
+    parser.add_argument('--stop-after', type=int, default=2,
+                        help='Failed steps in a row before stopping')
+    parser.add_argument('--cmd-vel-hz', type=float, default=10.0)
+    parser.add_argument('--cpus', default=None,
+                        help='Cores for the agent and the troopers, '
+                        'e.g. 0,1-3')
+    parser.add_argument('--output', default='swarm_load.csv')
+    args = parser.parse_args()
+
+    agent_cpu = trooper_cpu = None
+    if args.cpus:
+        agent_cpu, trooper_cpu = args.cpus.split(',', 1)
+    tmp_dir = tempfile.mkdtemp(prefix='swarm_load_')
+    agent_command = [executable('micro_ros_agent', 'micro_ros_agent'),
+                     'udp4', '--port', '8888']
+    if agent_cpu is not None:
+        agent_command = ['taskset', '-c', agent_cpu] + agent_command
+    agent_log = open(os.path.join(tmp_dir, 'agent.log'), 'w')
+    agent_process = subprocess.Popen(
+        agent_command, stdout=agent_log, stderr=subprocess.STDOUT)
+    agent = AgentStats(agent_process.pid)
+    app_path = executable(APP_PACKAGE, args.app)
+
+    rclpy.init()
+    swarm = Swarm(args.app, args.cmd_vel_hz)
+    executor = MultiThreadedExecutor()
+    executor.add_node(swarm)
+    spin_thread = threading.Thread(target=executor.spin, daemon=True)
+    spin_thread.start()
+
+    troopers = []
+    failed_steps = 0
+    first_failure = None
+    try:
+        with open(args.output, 'w', newline='') as output:
+            writer = None
+            while len(troopers) < args.max and failed_steps < args.stop_after:
+                for _ in range(min(args.step, args.max - len(troopers))):
+                    trooper = Trooper(len(troopers) + 1, app_path, tmp_dir,
+                                      trooper_cpu)
+                    swarm.add_trooper(trooper.namespace)
+                    troopers.append(trooper)
+                time.sleep(args.hold)
+                row = measure(swarm, troopers, agent, args.hold)
+                if writer is None:
+                    writer = csv.DictWriter(output, fieldnames=list(row))
+                    writer.writeheader()
+                writer.writerow(row)
+                output.flush()
+                print('%d troopers: %d up, agent %.1f%% CPU %d kB, round '
+                      'trip avg %d us max %d us' % (
+                          row['troopers'], row['up'], row['agent_cpu_pct'],
+                          row['agent_rss_kb'], row['round_trip_avg_us'],
+                          row['round_trip_max_us']), flush=True)
+                if row['up'] < row['troopers']:
+                    failed_steps += 1
+                    if first_failure is None:
+                        first_failure = row['troopers']
+                else:
+                    failed_steps = 0
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for trooper in troopers:
+            trooper.stop()
+        agent_process.terminate()
+        agent_process.wait()
+        agent_log.close()
+        executor.shutdown()
+        swarm.destroy_node()
+        rclpy.shutdown()
+
+    if first_failure is None:
+        print('All %d troopers stayed up' % len(troopers))
+    else:
+        print('Troopers started failing at %d' % first_failure)
+    print('Results in %s, logs in %s' % (args.output, tmp_dir))
+
+
+if __name__ == '__main__':
+    main()
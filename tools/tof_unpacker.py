@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Unpack batched ToF readings into per-sensor Range topics.
+
+The publishers app can pack all the ToF readings from one tick into a single
+sensor_msgs/LaserScan message on `sensors/tof_batch`.  Each "ray" in the scan
+is one sensor, so `ranges[0]` is ToF 1, `ranges[1]` is ToF 2 and so on.  This
+node republishes each reading as a sensor_msgs/Range message on
+`sensors/tof1` ... `sensors/tofN`, keeping the shared stamp from the batch.
+
+Run on the host (or in the docker) using:
+    . /opt/ros/foxy/setup.bash
+    python3 tools/tof_unpacker.py
+"""
+
+import math
+
+import rclpy
+from rclpy.node import Node
+from sensor_msgs.msg import LaserScan
+from sensor_msgs.msg import Range
+
+
+class TofUnpacker(Node):
+
+    def __init__(self):
+        super().__init__('tof_unpacker')
+        self.declare_parameter('batch_topic', 'sensors/tof_batch')
+        self.declare_parameter('range_topic_prefix', 'sensors/tof')
+        self.declare_parameter('field_of_view', 0.1)
+        self.declare_parameter('radiation_type', Range.INFRARED)
+        self._prefix = self.get_parameter('range_topic_prefix').value
+        self._field_of_view = float(self.get_parameter('field_of_view').value)
+        self._radiation_type = int(self.get_parameter('radiation_type').value)
+        self._range_publishers = []
+        self.create_subscription(
+            LaserScan, self.get_parameter('batch_topic').value,
+            self._batch_callback, 10)
+
+    def _publisher(self, index):
+        # Create publishers on demand so that any number of sensors works.
+        while len(self._range_publishers) <= index:
+            topic = '%s%d' % (self._prefix, len(self._range_publishers) + 1)
+            self._range_publishers.append(
+                self.create_publisher(Range, topic, 10))
+        return self._range_publishers[index]
+
+    def _batch_callback(self, scan):
+        for index, value in enumerate(scan.ranges):
+            if math.isnan(value):
+                # Sensor had no reading this tick.
+                continue
+            msg = Range()
+            msg.header = scan.header
+            msg.radiation_type = self._radiation_type
+            msg.field_of_view = self._field_of_view
+            msg.min_range = scan.range_min
+            msg.max_range = scan.range_max
+            msg.range = value
+            self._publisher(index).publish(msg)
+
+
+def main():
+    rclpy.init()
+    node = TofUnpacker()
+    try:
+        rclpy.spin(node)
+    except KeyboardInterrupt:
+        pass
+    node.destroy_node()
+    rclpy.shutdown()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,129 @@
+#!/bin/bash
+# Sweep the micro-ROS transport settings with the latency app in the Linux
+# build and write one CSV row per benchmark point.
+# Usage: tuning_matrix.bash [output.csv]
+# Run in the docker after setup_host.bash and build_host.bash latency.  Starts
+# its own agent and echo node, so nothing else may be using UDP port 8888.
+#
+# For each combination of RMW history depth, transport MTU and reliable stream
+# history, rmw_microxrcedds and the client library are rebuilt with those
+# settings and the latency app is run once per workload.  Each run sweeps the
+# reliable and best effort topics at each rate.  The sweep can be changed by
+# setting these variables, e.g. MTUS="512 1024" tuning_matrix.bash
+set -e
+
+HISTORIES=${HISTORIES:-"1 2 4"}
+MTUS=${MTUS:-"512 1024"}
+STREAM_HISTORIES=${STREAM_HISTORIES:-"2 4 8"}
+RATES_HZ=${RATES_HZ:-"10,50"}
+DURATION_S=${DURATION_S:-5}
+# name:payload bytes:messages per tick.  The sizes are about what the
+# serialised messages come to: a BatteryState with six cells and a Range.
+WORKLOADS=${WORKLOADS:-"battery_state:136:1 range_burst:44:6"}
+
+tools_dir="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &>/dev/null && pwd )"
+code_dir="$( cd "${tools_dir}/.." &>/dev/null && pwd )"
+csv=$(realpath "${1:-tuning_matrix.csv}")
+tmp_dir=$(mktemp -d)
+pids=""
+trap 'kill ${pids} 2>/dev/null; rm -rf ${tmp_dir}' EXIT
+
+source /opt/ros/foxy/setup.bash
+cd ~/host_ws
+source install/local_setup.bash
+export RMW_IMPLEMENTATION=rmw_microxrcedds
+
+# Static RAM of the app and the micro-ROS libraries it loads, data and bss.
+static_ram() {
+    size -t install/micro_ros_esp32_test_host/lib/micro_ros_esp32_test_host/latency \
+        install/rmw_microxrcedds/lib/librmw_microxrcedds_c.so \
+        install/microxrcedds_client/lib/libmicroxrcedds_client.so |
+        awk 'END { print $2 + $3 }'
+}
+
+# The agent and the echo node don't depend on the settings, so they run for
+# the whole sweep.
+ros2 run micro_ros_agent micro_ros_agent udp4 --port 8888 \
+    > ${tmp_dir}/agent.log 2>&1 &
+pids="${pids} $!"
+python3 ${tools_dir}/pingpong_echo.py > ${tmp_dir}/echo.log 2>&1 &
+pids="${pids} $!"
+
+echo "history,mtu,stream_history,workload,qos,size,rate_hz,burst,sent,received,lost,drop_pct,throughput_bytes_s,p50_us,p99_us,max_us,static_ram_bytes" \
+    > ${csv}
+
+for history in ${HISTORIES}
+do
+for mtu in ${MTUS}
+do
+for stream_history in ${STREAM_HISTORIES}
+do
+    echo "=== history ${history}, MTU ${mtu}, stream history ${stream_history}"
+    settings="-DAPP_RMW_MAX_HISTORY=${history} -DAPP_TRANSPORT_MTU=${mtu}"
+    settings="${settings} -DAPP_RMW_STREAM_HISTORY=${stream_history}"
+    meta=${tmp_dir}/matrix.meta
+    cc -DCOLCON_META_HOST ${settings} -I ${code_dir}/common \
+        -I ${code_dir}/latency -o ${tmp_dir}/gen_colcon_meta \
+        ${tools_dir}/gen_colcon_meta.c
+    ${tmp_dir}/gen_colcon_meta > ${meta}
+    colcon build --metas ${meta} \
+        --packages-select microxrcedds_client rmw_microxrcedds \
+        > ${tmp_dir}/build.log 2>&1 || { cat ${tmp_dir}/build.log; exit 1; }
+
+    for workload in ${WORKLOADS}
+    do
+        IFS=: read name size burst <<< "${workload}"
+        defines="APP_RMW_MAX_HISTORY=${history};APP_TRANSPORT_MTU=${mtu}"
+        defines="${defines};APP_RMW_STREAM_HISTORY=${stream_history}"
+        defines="${defines};LATENCY_SIZES={${size}};LATENCY_MAX_SIZE=${size}"
+        defines="${defines};LATENCY_RATES_HZ={${RATES_HZ}}"
+        defines="${defines};LATENCY_BURST=${burst}"
+        defines="${defines};LATENCY_POINT_DURATION_S=${DURATION_S}"
+        colcon build --base-paths src ${code_dir}/host \
+            --packages-select micro_ros_esp32_test_host \
+            --cmake-args -DHOST_APPS=latency "-DHOST_APP_DEFINES=${defines}" \
+            > ${tmp_dir}/build.log 2>&1 || { cat ${tmp_dir}/build.log; exit 1; }
+        ram=$(static_ram)
+
+        # The app exits when its sweep is done.  Each point takes the
+        # duration plus a second of draining, two QoS per rate.
+        points=$(( 2 * $(echo ${RATES_HZ} | tr ',' ' ' | wc -w) ))
+        results=${tmp_dir}/results.jsonl
+        rm -f ${results}
+        BENCH_OUTPUT=${results} timeout $(( points * (DURATION_S + 2) + 30 )) \
+            ros2 run micro_ros_esp32_test_host latency \
+            > ${tmp_dir}/app.log 2>&1 ||
+            echo "${name}: latency app failed or timed out, see the CSV"
+
+        python3 - ${results} >> ${csv} <<EOF
+import json, sys
+try:
+    lines = open(sys.argv[1]).read().splitlines()
+except FileNotFoundError:
+    lines = []
+for line in lines:
+    r = json.loads(line)
+    drop = 100.0 * r['lost'] / r['sent'] if r['sent'] else 0.0
+    throughput = r['received'] * r['size'] / r['duration_s']
+    print('${history},${mtu},${stream_history},${name},%s,%d,%d,%d,%d,%d,%d,'
+          '%.1f,%.0f,%d,%d,%d,${ram}' % (
+              r['qos'], r['size'], r['rate_hz'], r['burst'], r['sent'],
+              r['received'], r['lost'], drop, throughput, r['p50_us'],
+              r['p99_us'], r['max_us']))
+EOF
+    done
+done
+done
+done
+
+# Put the libraries and the app back to the latency app's normal settings.
+${tools_dir}/gen_colcon_meta.bash --host ${code_dir}/latency
+colcon build --metas ${code_dir}/latency/host-colcon.meta \
+    --packages-select microxrcedds_client rmw_microxrcedds \
+    > ${tmp_dir}/build.log 2>&1
+colcon build --base-paths src ${code_dir}/host \
+    --packages-select micro_ros_esp32_test_host \
+    --cmake-args -DHOST_APPS=latency -DHOST_APP_DEFINES= \
+    > ${tmp_dir}/build.log 2>&1
+
+echo "Results in ${csv}"